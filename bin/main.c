@@ -390,7 +390,7 @@ gint main (int argc, char *argv[])
   if (render_svg)
     {
       g_print ("Rendering SVG outline!");
-      p2tr_render_svg (rcdt->mesh, svg_out);
+      p2tr_render_svg_compact (rcdt->mesh, svg_out, P2TR_SVG_DEFAULT_DECIMALS);
       fclose (svg_out);
     }
 
@@ -43,6 +43,8 @@
 static P2trEdge*  p2tr_cdt_try_flip  (P2trCDT   *self,
                                       P2trEdge  *to_flip);
 
+#define P2TR_CDT_FLIP_BUDGET_FACTOR 4
+
 /* This function implements "Lawson's algorithm", also known as "The
  * diagonal swapping algorithm". This algorithm takes a CDT, and a list
  * of triangles that were formed by the insertion of a new point into
@@ -67,6 +69,12 @@ static P2trEdge*  p2tr_cdt_try_flip  (P2trCDT   *self,
  * circular cut is inside the infinite area created by extending the
  * two other edges of the triangle, therefor the point is also inside
  * that area - meaning that the quadrilateral is not concave!
+ *
+ * With a metric field, each in-circle test uses the average of the
+ * metrics at its four points. That criterion isn't consistent over the
+ * whole mesh, so flipping isn't guaranteed to stop. In that case the
+ * amount of flips in each call is limited to a multiple of the amount
+ * of edges, and the triangulation is left as it is when it runs out.
  */
 
 void
@@ -75,9 +83,20 @@ p2tr_cdt_flip_fix (P2trCDT     *self,
 {
   P2trEdge *edge;
   P2trVEdge *vedge;
+  guint budget = G_MAXUINT;
+
+  if (self->metric != NULL)
+    budget = P2TR_CDT_FLIP_BUDGET_FACTOR
+        * (p2tr_dense_set_size (self->mesh->edges) / 2 + p2tr_vedge_set_size (candidates));
 
   while (p2tr_vedge_set_pop (candidates, &vedge))
     {
+      if (budget == 0)
+        {
+          p2tr_vedge_unref (vedge);
+          continue;
+        }
+
       if (! p2tr_vedge_try_get_and_unref (vedge, &edge))
         continue;
 
@@ -99,6 +118,7 @@ p2tr_cdt_flip_fix (P2trCDT     *self,
               p2tr_vedge_set_add (candidates, p2tr_point_get_edge_to (B, C1, TRUE));
               p2tr_vedge_set_add (candidates, p2tr_point_get_edge_to (B, C2, TRUE));
               p2tr_edge_unref (flipped);
+              --budget;
             }
         }
 
@@ -134,7 +154,15 @@ p2tr_cdt_try_flip (P2trCDT   *self,
 
   /* Check if the quadriliteral ADBC is concave (because if it is, we
    * can't flip the edge) */
-  if (p2tr_triangle_circumcircle_contains_point (AB->tri, &D->c) != P2TR_INCIRCLE_IN)
+  if (p2tr_cdt_circumcircle_contains_point (self, AB->tri, D) != P2TR_INCIRCLE_IN)
+    return NULL;
+
+  /* In a metric, the test above is done on rounded coordinates, so it
+   * doesn't prove that the quadriliteral is strictly convex. Check that
+   * the new diagonal really separates A from B */
+  if (self->metric != NULL
+      && p2tr_math_orient2d (&D->c, &C->c, &A->c)
+         * p2tr_math_orient2d (&D->c, &C->c, &B->c) >= 0)
     return NULL;
 
   CA = p2tr_point_get_edge_to (C, A, FALSE);
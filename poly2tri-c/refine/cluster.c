@@ -39,9 +39,6 @@
 
 #include "cluster.h"
 
-static gboolean p2tr_cluster_cw_tri_between_is_in_domain (P2trEdge *e1,
-                                                          P2trEdge *e2);
-
 gdouble
 p2tr_cluster_shortest_edge_length (P2trCluster *self)
 {
@@ -56,81 +53,158 @@ p2tr_cluster_shortest_edge_length (P2trCluster *self)
   return sqrt (min_length_sq);
 }
 
-/**
- * Return the edge cluster of the specified edge from the specified end
- * point. THE EDGES IN THE CLUSTER MUST BE UNREFFED!
- * @param[in] P The point which is shared between all edges of the cluster
- * @param[in] E The edge whose cluster should be returned
- * @return The cluster of @ref E from the point @ref P
- */
-P2trCluster*
-p2tr_cluster_get_for (P2trPoint   *P,
-                      P2trEdge    *E)
+static P2trCluster*
+p2tr_cluster_new (void)
 {
   P2trCluster *cluster = g_slice_new (P2trCluster);
-  gdouble temp_angle;
-  P2trEdge *current, *next;
-  
   cluster->min_angle = G_MAXDOUBLE;
   g_queue_init (&cluster->edges);
+  return cluster;
+}
+
+/*      ^ e2
+ *     /
+ *    /_ e2.Tri (e1.Mirror.Tri)
+ *   /  |
+ *  *---------> e1
+ *
+ * Compute the angle going counter-clockwise from e1 to e2, which is
+ * enclosed by constrained edges only if both are adjacent constrained
+ * edges around their start point. Return a negative value if that angle
+ * is not a part of the triangulation domain
+ */
+static gdouble
+p2tr_cluster_ccw_gap (P2trEdge *e1, P2trEdge *e2)
+{
+  gdouble gap = e2->angle - e1->angle;
+
+  if (gap <= 0)
+    gap += 2 * G_PI;
+
+  return (e1->mirror->tri != NULL) ? gap : -1;
+}
+
+/**
+ * Split the constrained edges going out of a point into clusters
+ */
+static GSList*
+p2tr_cluster_compute_all (P2trPoint *P)
+{
+  GPtrArray   *constrained = g_ptr_array_new ();
+  GSList      *result = NULL;
+  P2trCluster *current = NULL;
+  GList       *iter;
+  guint        i, n, first;
+  gdouble      gap;
+
+  /* The outgoing edges are sorted by ascending angle, so the constrained
+   * edges are collected in counter-clockwise order */
+  for (iter = P->outgoing_edges; iter != NULL; iter = iter->next)
+    if (((P2trEdge*) iter->data)->constrained)
+      g_ptr_array_add (constrained, iter->data);
+
+  n = constrained->len;
+
+  /* Start right after a gap which separates two clusters, so that no
+   * cluster wraps around the end of the array. If there is no such gap,
+   * all the edges form one cluster */
+  first = 0;
+  for (i = 0; i < n; i++)
+    {
+      gap = p2tr_cluster_ccw_gap (g_ptr_array_index (constrained, i),
+                                  g_ptr_array_index (constrained, (i + 1) % n));
+      if (gap < 0 || gap > P2TR_CLUSTER_LIMIT_ANGLE)
+        {
+          first = (i + 1) % n;
+          break;
+        }
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      P2trEdge *e = (P2trEdge*) g_ptr_array_index (constrained, (first + i) % n);
+
+      if (current == NULL)
+        {
+          current = p2tr_cluster_new ();
+          result = g_slist_prepend (result, current);
+        }
+
+      g_queue_push_tail (&current->edges, p2tr_edge_ref (e));
+
+      if (i + 1 < n)
+        {
+          gap = p2tr_cluster_ccw_gap (e, g_ptr_array_index (constrained, (first + i + 1) % n));
+          if (gap < 0 || gap > P2TR_CLUSTER_LIMIT_ANGLE)
+            current = NULL;
+          else
+            current->min_angle = MIN (current->min_angle, gap);
+        }
+    }
+
+  g_ptr_array_free (constrained, TRUE);
+  return result;
+}
+
+const P2trCluster*
+p2tr_cluster_get_cached (P2trPoint   *P,
+                         P2trEdge    *E)
+{
+  GSList *iter;
 
   if (P == E->end)
     E = E->mirror;
   else if (P != P2TR_EDGE_START (E))
     p2tr_exception_programmatic ("Unexpected point for the edge!");
 
-  g_queue_push_head (&cluster->edges, p2tr_edge_ref (E));
+  if (! E->constrained)
+    p2tr_exception_programmatic ("Clusters contain only constrained edges!");
 
-  current = p2tr_edge_ref (E);
-  next = p2tr_point_edge_cw (P, current);
-  
-  while (next != g_queue_peek_head (&cluster->edges)
-      && (temp_angle = p2tr_edge_angle_between (current->mirror, next)) <= P2TR_CLUSTER_LIMIT_ANGLE
-      && p2tr_cluster_cw_tri_between_is_in_domain (current, next))
+  if (P->clusters == NULL)
+    P->clusters = p2tr_cluster_compute_all (P);
+
+  for (iter = P->clusters; iter != NULL; iter = iter->next)
     {
-      g_queue_push_tail (&cluster->edges, p2tr_edge_ref (next));
-      p2tr_edge_unref (current);
-      current = next;
-      next = p2tr_point_edge_cw (P, current);
-      cluster->min_angle = MIN (cluster->min_angle, temp_angle);
+      P2trCluster *cluster = (P2trCluster*) iter->data;
+      if (g_queue_find (&cluster->edges, E) != NULL)
+        return cluster;
     }
-  p2tr_edge_unref (current);
-  p2tr_edge_unref (next);
 
-  current = p2tr_edge_ref (E);
-  next = p2tr_point_edge_ccw (P, current);
+  p2tr_exception_programmatic ("The edge is not in any cluster of the point!");
+}
 
-  while (next != g_queue_peek_tail (&cluster->edges)
-      && (temp_angle = p2tr_edge_angle_between (current->mirror, next)) <= P2TR_CLUSTER_LIMIT_ANGLE
-      && p2tr_cluster_cw_tri_between_is_in_domain (next, current))
-    {
-      g_queue_push_head (&cluster->edges, p2tr_edge_ref (next));
-      p2tr_edge_unref (current);
-      current = next;
-      next = p2tr_point_edge_ccw (P, current);
-      cluster->min_angle = MIN(cluster->min_angle, temp_angle);
-    }
-  p2tr_edge_unref (current);
-  p2tr_edge_unref (next);
+/**
+ * Return the edge cluster of the specified edge from the specified end
+ * point. The returned cluster is a new copy which must be freed using
+ * @ref p2tr_cluster_free
+ * @param[in] P The point which is shared between all edges of the cluster
+ * @param[in] E The constrained edge whose cluster should be returned
+ * @return The cluster of @ref E from the point @ref P
+ */
+P2trCluster*
+p2tr_cluster_get_for (P2trPoint   *P,
+                      P2trEdge    *E)
+{
+  const P2trCluster *cached = p2tr_cluster_get_cached (P, E);
+  P2trCluster *cluster = p2tr_cluster_new ();
+  GList *iter;
+
+  cluster->min_angle = cached->min_angle;
+  for (iter = cached->edges.head; iter != NULL; iter = iter->next)
+    g_queue_push_tail (&cluster->edges, p2tr_edge_ref ((P2trEdge*) iter->data));
 
   return cluster;
 }
 
-/*     ^ e1
- *    /
- *   /_ e1.Tri (e2.Mirror.Tri)
- *  /  |
- * *---------> e2
- *
- * Check if the angle marked is a part of the triangulation
- * domain
- */
-static gboolean
-p2tr_cluster_cw_tri_between_is_in_domain (P2trEdge *e1, P2trEdge *e2)
+void
+p2tr_cluster_invalidate_cache (P2trPoint *P)
 {
-  if (P2TR_EDGE_START(e1) != P2TR_EDGE_START(e2) || e1->tri != e2->mirror->tri)
-    p2tr_exception_programmatic ("Non clockwise adjacent edges!");
-  return e1->tri != NULL;
+  GSList *clusters = P->clusters;
+
+  /* Detach the cache first, since freeing the clusters may unref the
+   * edges and recursively get back to this point */
+  P->clusters = NULL;
+  g_slist_free_full (clusters, (GDestroyNotify) p2tr_cluster_free);
 }
 
 void
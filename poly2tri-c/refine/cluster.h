@@ -39,15 +39,40 @@
 
 #define P2TR_CLUSTER_LIMIT_ANGLE (G_PI / 6)
 
+/**
+ * A cluster of constrained edges going out of one point, where each two
+ * adjacent edges have an angle of at most @ref P2TR_CLUSTER_LIMIT_ANGLE
+ * between them, with the domain of the triangulation inside that angle
+ */
 typedef struct
 {
+  /** The edges of the cluster, sorted by ascending angle */
   GQueue   edges;
+  /** The smallest angle between adjacent edges, or G_MAXDOUBLE if the
+   *  cluster contains only one edge */
   gdouble  min_angle;
 } P2trCluster;
 
 P2trCluster*  p2tr_cluster_get_for              (P2trPoint *P,
                                                  P2trEdge  *E);
 
+/**
+ * Like @ref p2tr_cluster_get_for, but return the cluster from the cache
+ * of the point instead of creating a new one.
+ * @param[in] P The point which is shared between all edges of the cluster
+ * @param[in] E A constrained edge whose cluster should be returned
+ * @return The cluster of E from the point P. It's owned by the point and
+ *         remains valid until a constrained edge is added to P or
+ *         removed from it
+ */
+const P2trCluster* p2tr_cluster_get_cached      (P2trPoint *P,
+                                                 P2trEdge  *E);
+
+/**
+ * Drop the cached clusters of a point
+ */
+void          p2tr_cluster_invalidate_cache     (P2trPoint *P);
+
 gdouble       p2tr_cluster_shortest_edge_length (P2trCluster *self);
 
 void          p2tr_cluster_free                 (P2trCluster *self);
@@ -32,6 +32,7 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <glib.h>
 
 #include "rutils.h"
@@ -129,14 +130,55 @@ p2tr_cdt_is_encroached (P2trEdge *E)
 /* Now for the algorithm itself                                       */
 /* ****************************************************************** */
 
+/* Check whether a triangle is too big, according to a sizing field
+ * which may be NULL for no size control at all */
+#define P2TR_DT_TOO_BIG(sizing,t) \
+  ((sizing) != NULL && p2tr_sizing_field_too_big ((sizing), (t)))
+
+/* The amount of triangles whose size is tested together when scanning
+ * the entire mesh */
+#define P2TR_DT_BATCH 64
+
+/**
+ * Check whether a triangle should be refined. An angle bound of 0
+ * disables the quality tests, leaving only the size control.
+ * If the triangulation has a metric field, the angles and the edge
+ * lengths are measured in metric space instead of the Euclidean angles,
+ * and the angles of triangles which are already small enough in metric
+ * space are ignored
+ */
+static gboolean
+p2tr_dt_triangle_is_bad (P2trDelaunayTerminator *self,
+                         P2trTriangle           *t,
+                         gdouble                 theta,
+                         P2trSizingField        *sizing)
+{
+  if (P2TR_DT_TOO_BIG (sizing, t))
+    return TRUE;
+  else if (theta <= 0)
+    return FALSE;
+  else if (self->cdt->metric != NULL)
+    {
+      P2trMetric m;
+      gdouble    min_angle, min_length, max_length;
+
+      p2tr_metric_field_eval_triangle (self->cdt->metric, t, &m);
+      p2tr_metric_triangle_quality (&m, t, &min_angle, &min_length, &max_length);
+      return max_length > P2TR_METRIC_MAX_EDGE_LENGTH
+          || (min_angle < theta && min_length >= P2TR_METRIC_MIN_EDGE_LENGTH);
+    }
+  else
+    return p2tr_triangle_smallest_non_constrained_angle (t) < theta;
+}
+
 static gboolean
 SplitPermitted (P2trDelaunayTerminator *self, P2trEdge *s, gdouble d);
 
-static void
-SplitEncroachedSubsegments (P2trDelaunayTerminator *self, gdouble theta, P2trTriangleTooBig delta);
+static P2trRefineStopReason
+SplitEncroachedSubsegments (P2trDelaunayTerminator *self, gdouble theta, P2trSizingField *sizing, const P2trRefineBudget *budget);
 
 static void
-NewVertex (P2trDelaunayTerminator *self, P2trPoint *v, gdouble theta, P2trTriangleTooBig delta);
+NewVertex (P2trDelaunayTerminator *self, P2trPoint *v, gdouble theta, P2trSizingField *sizing);
 
 static gdouble
 ShortestEdgeLength (P2trTriangle *tri);
@@ -153,6 +195,9 @@ TolerantIsPowerOfTwoLength (gdouble length);
 static void
 ChooseSplitVertex(P2trEdge *e, P2trVector2 *dst);
 
+static P2trTriangle*
+ChooseSteinerPoint (P2trDelaunayTerminator *self, P2trTriangle *t, P2trVector2 *dst);
+
 
 
 static inline gint
@@ -180,19 +225,53 @@ vtriangle_quality_compare (P2trVTriangle *t1, P2trVTriangle *t2)
 P2trDelaunayTerminator*
 p2tr_dt_new (gdouble theta, P2trTriangleTooBig delta, P2trCDT *cdt)
 {
-  P2trDelaunayTerminator *self = g_slice_new (P2trDelaunayTerminator);
+  return p2tr_dt_new_full (theta, delta, P2TR_REFINER_PLACE_CIRCUMCENTER,
+                           NULL, NULL, cdt);
+}
+
+P2trDelaunayTerminator*
+p2tr_dt_new_full (gdouble               theta,
+                  P2trTriangleTooBig    delta,
+                  P2trSteinerPlacement  placement,
+                  P2trSteinerPointFunc  place_func,
+                  gpointer              place_data,
+                  P2trCDT              *cdt)
+{
+  P2trDelaunayTerminator *self;
+
+  if (placement == P2TR_REFINER_PLACE_CALLBACK && place_func == NULL)
+    p2tr_exception_programmatic ("No function given for placing points!");
+
+  self = g_slice_new (P2trDelaunayTerminator);
   self->Qt = g_sequence_new (NULL);
   g_queue_init (&self->Qs);
-  self->delta = delta;
+  self->sizing = (delta == NULL || delta == p2tr_refiner_false_too_big)
+      ? NULL : p2tr_sizing_field_new_callback (delta);
   self->theta = theta;
+  self->placement = placement;
+  self->place_func = place_func;
+  self->place_data = place_data;
+  self->suspended = FALSE;
   self->cdt = cdt;
   return self;
 }
 
+void
+p2tr_dt_set_sizing_field (P2trDelaunayTerminator *self,
+                          P2trSizingField        *sizing)
+{
+  if (sizing != NULL)
+    p2tr_sizing_field_ref (sizing);
+  if (self->sizing != NULL)
+    p2tr_sizing_field_unref (self->sizing);
+  self->sizing = sizing;
+}
+
 void
 p2tr_dt_free (P2trDelaunayTerminator *self)
 {
-  g_queue_clear (&self->Qs);
+  p2tr_dt_reset (self);
+  p2tr_dt_set_sizing_field (self, NULL);
   g_sequence_free (self->Qt);
   g_slice_free (P2trDelaunayTerminator, self);
 }
@@ -226,6 +305,14 @@ p2tr_dt_dequeue_tri (P2trDelaunayTerminator *self)
     }
 }
 
+static void
+p2tr_dt_clear_tri_queue (P2trDelaunayTerminator *self)
+{
+  P2trVTriangle *vt;
+  while ((vt = p2tr_dt_dequeue_tri (self)) != NULL)
+    p2tr_vtriangle_unref (vt);
+}
+
 static void
 p2tr_dt_enqueue_segment (P2trDelaunayTerminator *self,
                          P2trEdge               *E)
@@ -251,12 +338,400 @@ p2tr_dt_segment_queue_is_empty (P2trDelaunayTerminator *self)
   return g_queue_is_empty (&self->Qs);
 }
 
+void
+p2tr_dt_reset (P2trDelaunayTerminator *self)
+{
+  P2trEdge *s;
+
+  p2tr_dt_clear_tri_queue (self);
+  while ((s = p2tr_dt_dequeue_segment (self)) != NULL)
+    p2tr_edge_unref (s);
+
+  self->suspended = FALSE;
+}
+
+static guint
+p2tr_dt_point_index (P2trDelaunayTerminator *self,
+                     P2trPoint              *pt)
+{
+  return p2tr_dense_set_index_of (self->cdt->mesh->points, pt->handle);
+}
+
+void
+p2tr_dt_save_queues (P2trDelaunayTerminator *self,
+                     FILE                   *out)
+{
+  GSequenceIter *iter;
+  GList         *s_iter;
+  guint          tri_count = 0;
+
+  /* Triangles which were already eliminated would be skipped when
+   * dequeued, so there is no point in saving them */
+  for (iter = g_sequence_get_begin_iter (self->Qt);
+       ! g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    if (p2tr_vtriangle_is_real ((P2trVTriangle*) g_sequence_get (iter)))
+      ++tri_count;
+
+  fprintf (out, "P2TRQ %u %u %u\n", self->suspended ? 1 : 0,
+      tri_count, (guint) g_queue_get_length (&self->Qs));
+
+  for (iter = g_sequence_get_begin_iter (self->Qt);
+       ! g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      P2trVTriangle *vt = (P2trVTriangle*) g_sequence_get (iter);
+      if (! p2tr_vtriangle_is_real (vt))
+        continue;
+      fprintf (out, "%u %u %u\n",
+          p2tr_dt_point_index (self, vt->points[0]),
+          p2tr_dt_point_index (self, vt->points[1]),
+          p2tr_dt_point_index (self, vt->points[2]));
+    }
+
+  for (s_iter = self->Qs.head; s_iter != NULL; s_iter = s_iter->next)
+    {
+      P2trEdge *s = (P2trEdge*) s_iter->data;
+      fprintf (out, "%u %u\n",
+          p2tr_dt_point_index (self, P2TR_EDGE_START (s)),
+          p2tr_dt_point_index (self, s->end));
+    }
+}
+
+/**
+ * Find the point with the given index (as written by
+ * p2tr_dt_save_queues), or NULL if the index is out of range
+ */
+static P2trPoint*
+p2tr_dt_point_at (P2trDelaunayTerminator *self,
+                  guint                   index)
+{
+  P2trDenseSet *points = self->cdt->mesh->points;
+
+  if (index >= p2tr_dense_set_size (points))
+    return NULL;
+  else
+    return (P2trPoint*) p2tr_dense_set_get (points, index);
+}
+
+gboolean
+p2tr_dt_load_queues (P2trDelaunayTerminator *self,
+                     FILE                   *in)
+{
+  guint suspended, tri_count, seg_count;
+  guint i, j, pt_indexes[3];
+  P2trPoint *pts[3];
+
+  p2tr_dt_reset (self);
+
+  /* Skip any whitespace left after the mesh which was read before */
+  if (fscanf (in, " P2TRQ %u %u %u\n", &suspended, &tri_count, &seg_count) != 3)
+    return FALSE;
+
+  for (i = 0; i < tri_count; ++i)
+    {
+      P2trEdge *e0, *e1, *e2;
+
+      if (fscanf (in, "%u %u %u\n", &pt_indexes[0], &pt_indexes[1],
+          &pt_indexes[2]) != 3)
+        goto error_finish;
+
+      for (j = 0; j < 3; ++j)
+        if ((pts[j] = p2tr_dt_point_at (self, pt_indexes[j])) == NULL)
+          goto error_finish;
+
+      /* Triangles which were already eliminated would be skipped when
+       * dequeued, so there is no point in restoring them */
+      if ((e0 = p2tr_point_has_edge_to (pts[0], pts[1])) &&
+          (e1 = p2tr_point_has_edge_to (pts[1], pts[2])) &&
+          (e2 = p2tr_point_has_edge_to (pts[2], pts[0])) &&
+          e0->tri != NULL && e0->tri == e1->tri && e1->tri == e2->tri)
+        p2tr_dt_enqueue_tri (self, e0->tri);
+    }
+
+  for (i = 0; i < seg_count; ++i)
+    {
+      P2trEdge *s;
+
+      if (fscanf (in, "%u %u\n", &pt_indexes[0], &pt_indexes[1]) != 2)
+        goto error_finish;
+
+      for (j = 0; j < 2; ++j)
+        if ((pts[j] = p2tr_dt_point_at (self, pt_indexes[j])) == NULL)
+          goto error_finish;
+
+      if ((s = p2tr_point_has_edge_to (pts[0], pts[1])) && s->constrained)
+        p2tr_dt_enqueue_segment (self, s);
+    }
+
+  self->suspended = suspended != 0;
+  return TRUE;
+
+error_finish:
+  p2tr_dt_reset (self);
+  return FALSE;
+}
+
+/**
+ * Enqueue a triangle if it's bad, and its segments if they are
+ * encroached
+ */
+static void
+p2tr_dt_seed_triangle (P2trDelaunayTerminator *self,
+                       P2trTriangle           *t)
+{
+  gint i;
+
+  if (p2tr_dt_triangle_is_bad (self, t, self->theta, self->sizing))
+    p2tr_dt_enqueue_tri (self, t);
+
+  for (i = 0; i < 3; i++)
+    if (p2tr_cdt_is_encroached (t->edges[i]))
+      p2tr_dt_enqueue_segment (self, t->edges[i]);
+}
+
+void
+p2tr_dt_seed_region (P2trDelaunayTerminator  *self,
+                     P2trTriangle           **triangles,
+                     guint                    count)
+{
+  P2trHashSet *seeded = p2tr_hash_set_new_default ();
+  guint i;
+  gint j;
+
+  for (i = 0; i < count; i++)
+    {
+      P2trTriangle *t = triangles[i];
+
+      if (p2tr_triangle_is_removed (t))
+        continue;
+
+      /* An edit inside a triangle may also make its neighbors bad (for
+       * example by encroaching a segment on their side), so include
+       * them as well */
+      for (j = -1; j < 3; j++)
+        {
+          P2trTriangle *n = (j < 0) ? t : t->edges[j]->mirror->tri;
+          if (n != NULL && ! p2tr_hash_set_contains (seeded, n))
+            {
+              p2tr_hash_set_insert (seeded, n);
+              p2tr_dt_seed_triangle (self, n);
+            }
+        }
+    }
+
+  p2tr_hash_set_free (seeded);
+  self->suspended = TRUE;
+}
+
+static gboolean
+p2tr_dt_triangle_intersects_box (P2trTriangle *t,
+                                 gdouble       min_x,
+                                 gdouble       min_y,
+                                 gdouble       max_x,
+                                 gdouble       max_y)
+{
+  const P2trVector2 *A = &t->edges[0]->end->c;
+  const P2trVector2 *B = &t->edges[1]->end->c;
+  const P2trVector2 *C = &t->edges[2]->end->c;
+
+  return MAX (A->x, MAX (B->x, C->x)) >= min_x
+      && MIN (A->x, MIN (B->x, C->x)) <= max_x
+      && MAX (A->y, MAX (B->y, C->y)) >= min_y
+      && MIN (A->y, MIN (B->y, C->y)) <= max_y;
+}
+
+/**
+ * Add a triangle to the region grown by p2tr_dt_seed_box, if it
+ * intersects the box and wasn't added already
+ */
+static void
+p2tr_dt_seed_box_add (P2trHashSet  *checked,
+                      GQueue       *to_check,
+                      P2trTriangle *t,
+                      gdouble       min_x,
+                      gdouble       min_y,
+                      gdouble       max_x,
+                      gdouble       max_y)
+{
+  if (! p2tr_hash_set_contains (checked, t)
+      && p2tr_dt_triangle_intersects_box (t, min_x, min_y, max_x, max_y))
+    {
+      p2tr_hash_set_insert (checked, t);
+      g_queue_push_tail (to_check, t);
+    }
+}
+
+/**
+ * Walk along the boundary of the domain (the outline or the outline of
+ * a hole) which passes through the given point, and add the triangles
+ * along it which intersect the box. Parts of the domain inside the box
+ * which are only connected through triangles outside of it (across a
+ * hole or a concave part of the domain) are always connected along the
+ * boundary
+ */
+static void
+p2tr_dt_seed_box_walk_boundary (P2trPoint    *start,
+                                P2trHashSet  *walked,
+                                P2trHashSet  *checked,
+                                GQueue       *to_check,
+                                gdouble       min_x,
+                                gdouble       min_y,
+                                gdouble       max_x,
+                                gdouble       max_y)
+{
+  GQueue     points;
+  P2trPoint *p;
+  GList     *iter;
+
+  if (p2tr_hash_set_contains (walked, start))
+    return;
+
+  g_queue_init (&points);
+  p2tr_hash_set_insert (walked, start);
+  g_queue_push_tail (&points, start);
+
+  while ((p = (P2trPoint*) g_queue_pop_head (&points)) != NULL)
+    for (iter = p->outgoing_edges; iter != NULL; iter = iter->next)
+      {
+        P2trEdge *e = (P2trEdge*) iter->data;
+
+        /* Boundary edges have a triangle on exactly one side */
+        if ((e->tri == NULL) == (e->mirror->tri == NULL))
+          continue;
+
+        p2tr_dt_seed_box_add (checked, to_check,
+            (e->tri != NULL) ? e->tri : e->mirror->tri,
+            min_x, min_y, max_x, max_y);
+
+        if (! p2tr_hash_set_contains (walked, e->end))
+          {
+            p2tr_hash_set_insert (walked, e->end);
+            g_queue_push_tail (&points, e->end);
+          }
+      }
+}
+
+void
+p2tr_dt_seed_box (P2trDelaunayTerminator *self,
+                  gdouble                 min_x,
+                  gdouble                 min_y,
+                  gdouble                 max_x,
+                  gdouble                 max_y,
+                  P2trTriangle           *initial_guess)
+{
+  P2trMesh     *mesh = self->cdt->mesh;
+  P2trVector2   center;
+  P2trTriangle *start;
+  P2trTriangle *t;
+
+  center.x = (min_x + max_x) / 2;
+  center.y = (min_y + max_y) / 2;
+  start = p2tr_mesh_find_point_local (mesh, &center, initial_guess);
+
+  if (start == NULL)
+    {
+      /* The center of the box is outside the domain, so there is no
+       * triangle to start growing the region from - check all the
+       * triangles */
+      P2trDenseSetIter iter;
+
+      p2tr_dense_set_iter_init (&iter, mesh->triangles);
+      while (p2tr_dense_set_iter_next (&iter, (gpointer*)&t))
+        if (p2tr_dt_triangle_intersects_box (t, min_x, min_y, max_x, max_y))
+          p2tr_dt_seed_triangle (self, t);
+    }
+  else
+    {
+      /* Grow the region from the center as long as the triangles still
+       * intersect the box. When the region reaches the boundary of the
+       * domain, continue along the boundary to reach the parts of the
+       * box which are separated from the center by a hole or by a
+       * concave part of the domain */
+      P2trHashSet *checked = p2tr_hash_set_new_default ();
+      P2trHashSet *walked = p2tr_hash_set_new_default ();
+      GQueue       to_check;
+      gint         i;
+
+      g_queue_init (&to_check);
+      g_queue_push_tail (&to_check, start);
+      p2tr_hash_set_insert (checked, start);
+
+      while ((t = (P2trTriangle*) g_queue_pop_head (&to_check)) != NULL)
+        {
+          p2tr_dt_seed_triangle (self, t);
+
+          for (i = 0; i < 3; i++)
+            {
+              P2trTriangle *n = t->edges[i]->mirror->tri;
+              if (n != NULL)
+                p2tr_dt_seed_box_add (checked, &to_check, n,
+                    min_x, min_y, max_x, max_y);
+              else
+                p2tr_dt_seed_box_walk_boundary (t->edges[i]->end, walked,
+                    checked, &to_check, min_x, min_y, max_x, max_y);
+            }
+        }
+
+      p2tr_hash_set_free (walked);
+      p2tr_hash_set_free (checked);
+      p2tr_triangle_unref (start);
+    }
+
+  self->suspended = TRUE;
+}
+
 void
 p2tr_dt_refine (P2trDelaunayTerminator   *self,
                 gint                      max_steps,
                 P2trRefineProgressNotify  on_progress)
 {
-  P2trHashSetIter hs_iter;
+  P2trRefineBudget budget;
+
+  p2tr_refiner_budget_init (&budget);
+  budget.max_steps = MAX (max_steps, 0);
+
+  /* A limit of 0 steps means no limit in a budget, so handle it here */
+  if (max_steps > 0)
+    p2tr_dt_refine_budget (self, &budget, on_progress);
+}
+
+/**
+ * Check whether any of the limits of the budget was reached. All the
+ * checks take O(1) time.
+ */
+static P2trRefineStopReason
+p2tr_dt_check_budget (P2trDelaunayTerminator *self,
+                      const P2trRefineBudget *budget,
+                      gint                    steps)
+{
+  P2trMesh *mesh = self->cdt->mesh;
+
+  if (budget->max_steps > 0 && steps >= budget->max_steps)
+    return P2TR_REFINE_STOP_STEPS;
+  if (budget->max_points > 0
+      && p2tr_dense_set_size (mesh->points) >= budget->max_points)
+    return P2TR_REFINE_STOP_POINTS;
+  if (budget->max_triangles > 0
+      && p2tr_dense_set_size (mesh->triangles) >= budget->max_triangles)
+    return P2TR_REFINE_STOP_TRIANGLES;
+  if (budget->max_bytes > 0
+      && p2tr_mesh_get_memory_size (mesh) >= budget->max_bytes)
+    return P2TR_REFINE_STOP_MEMORY;
+  if (budget->deadline_ns > 0
+      && g_get_monotonic_time () * 1000 >= budget->deadline_ns)
+    return P2TR_REFINE_STOP_DEADLINE;
+  return P2TR_REFINE_DONE;
+}
+
+P2trRefineStopReason
+p2tr_dt_refine_budget (P2trDelaunayTerminator   *self,
+                       const P2trRefineBudget   *budget,
+                       P2trRefineProgressNotify  on_progress)
+{
+  gint max_steps = budget->max_steps;
+  P2trRefineStopReason reason;
+  P2trDenseSetIter hs_iter;
   P2trEdge *s;
   P2trTriangle *t;
   P2trVTriangle *vt;
@@ -264,21 +739,61 @@ p2tr_dt_refine (P2trDelaunayTerminator   *self,
 
   P2TR_CDT_VALIDATE_CDT (self->cdt);
 
-  if (steps++ >= max_steps)
-    return;
+  if ((reason = p2tr_dt_check_budget (self, budget, steps++)) != P2TR_REFINE_DONE)
+    return reason;
 
-  p2tr_hash_set_iter_init (&hs_iter, self->cdt->mesh->edges);
-    while (p2tr_hash_set_iter_next (&hs_iter, (gpointer*)&s))
-    if (s->constrained && p2tr_cdt_is_encroached (s))
-      p2tr_dt_enqueue_segment (self, s);
+  /* A suspended refinement continues from its queues, without scanning
+   * the entire mesh again */
+  if (! self->suspended)
+    {
+      p2tr_dense_set_iter_init (&hs_iter, self->cdt->mesh->edges);
+      while (p2tr_dense_set_iter_next (&hs_iter, (gpointer*)&s))
+        if (s->constrained && p2tr_cdt_is_encroached (s))
+          p2tr_dt_enqueue_segment (self, s);
+    }
 
-  SplitEncroachedSubsegments (self, 0, p2tr_refiner_false_too_big);
+  /* Before the scan, the triangles created by splitting segments don't
+   * have to be queued since the scan will find them. If splitting is
+   * stopped here, the next call simply scans again */
+  reason = self->suspended
+      ? SplitEncroachedSubsegments (self, self->theta, self->sizing, budget)
+      : SplitEncroachedSubsegments (self, 0, NULL, budget);
   P2TR_CDT_VALIDATE_CDT (self->cdt);
 
-  p2tr_hash_set_iter_init (&hs_iter, self->cdt->mesh->triangles);
-  while (p2tr_hash_set_iter_next (&hs_iter, (gpointer*)&t))
-    if (p2tr_triangle_smallest_non_constrained_angle (t) < self->theta)
-      p2tr_dt_enqueue_tri (self, t);
+  if (reason != P2TR_REFINE_DONE)
+    return reason;
+
+  if (! self->suspended)
+    {
+      /* Test the sizes in batches, directly on the array of the set.
+       * A size control callback (P2trTriangleTooBig) is only asked
+       * about triangles created by the refinement, so with one the
+       * existing triangles are queued by their angles alone */
+      P2trDenseSet *tris = self->cdt->mesh->triangles;
+      gboolean      scan_sizes = self->sizing != NULL
+          && self->sizing->type != P2TR_SIZING_CALLBACK;
+      gboolean      too_big[P2TR_DT_BATCH];
+      guint         start, n, i;
+
+      for (start = 0; start < p2tr_dense_set_size (tris); start += n)
+        {
+          n = MIN (p2tr_dense_set_size (tris) - start, P2TR_DT_BATCH);
+
+          if (scan_sizes)
+            p2tr_sizing_field_too_big_batch (self->sizing,
+                (P2trTriangle**) &p2tr_dense_set_get (tris, start), n, too_big);
+          else
+            memset (too_big, 0, sizeof (too_big));
+
+          for (i = 0; i < n; i++)
+            {
+              t = (P2trTriangle*) p2tr_dense_set_get (tris, start + i);
+              if (too_big[i]
+                  || p2tr_dt_triangle_is_bad (self, t, self->theta, NULL))
+                p2tr_dt_enqueue_tri (self, t);
+            }
+        }
+    }
 
   if (on_progress != NULL) on_progress ((P2trRefiner*) self, steps, max_steps);
 
@@ -287,19 +802,27 @@ p2tr_dt_refine (P2trDelaunayTerminator   *self,
       vt = p2tr_dt_dequeue_tri (self);
       t = p2tr_vtriangle_is_real (vt);
 
-      if (t && steps++ < max_steps)
+      if (t && (reason = p2tr_dt_check_budget (self, budget, steps)) != P2TR_REFINE_DONE)
+        {
+          /* Each step leaves the mesh as a valid CDT, so we can just
+           * stop here and keep the triangle for the next call */
+          g_sequence_insert_sorted (self->Qt, vt, (GCompareDataFunc)vtriangle_quality_compare, NULL);
+          self->suspended = TRUE;
+          return reason;
+        }
+
+      if (t)
         {
-          P2trCircle tCircum;
-          P2trVector2 *c;
+          P2trVector2 tCenter;
+          P2trVector2 *c = &tCenter;
           P2trTriangle *triContaining_c;
           P2trVEdgeSet *E;
           P2trPoint *cPoint;
 
-          P2TR_CDT_VALIDATE_CDT (self->cdt);
-          p2tr_triangle_get_circum_circle (t, &tCircum);
-          c = &tCircum.center;
+          steps++;
 
-          triContaining_c = p2tr_mesh_find_point_local (self->cdt->mesh, c, t);
+          P2TR_CDT_VALIDATE_CDT (self->cdt);
+          triContaining_c = ChooseSteinerPoint (self, t, c);
 
           /* If no edge is encroached, then this must be
            * inside the triangulation domain!!! */
@@ -318,8 +841,9 @@ p2tr_dt_refine (P2trDelaunayTerminator   *self,
 
           if (p2tr_vedge_set_size (E) == 0)
             {
+              P2TR_CDT_VALIDATE_GROUP (self->cdt);
               p2tr_mesh_action_group_commit (self->cdt->mesh);
-              NewVertex (self, cPoint, self->theta, self->delta);
+              NewVertex (self, cPoint, self->theta, self->sizing);
             }
           else
             {
@@ -339,7 +863,7 @@ p2tr_dt_refine (P2trDelaunayTerminator   *self,
               while (p2tr_vedge_set_pop (E, &vSegment))
                 {
                   s = p2tr_vedge_get (vSegment);
-                  if (self->delta (t) || SplitPermitted(self, s, d))
+                  if (P2TR_DT_TOO_BIG (self->sizing, t) || SplitPermitted(self, s, d))
                     p2tr_dt_enqueue_segment (self, s);
                   p2tr_edge_unref (s);
                   p2tr_vedge_unref (vSegment);
@@ -348,7 +872,8 @@ p2tr_dt_refine (P2trDelaunayTerminator   *self,
               if (! p2tr_dt_segment_queue_is_empty (self))
                 {
                   p2tr_dt_enqueue_tri (self, t);
-                  SplitEncroachedSubsegments(self, self->theta, self->delta);
+                  reason = SplitEncroachedSubsegments (self, self->theta,
+                      self->sizing, budget);
                 }
             }
 
@@ -360,15 +885,26 @@ p2tr_dt_refine (P2trDelaunayTerminator   *self,
       p2tr_vtriangle_unref (vt);
 
       if (on_progress != NULL) on_progress ((P2trRefiner*) self, steps, max_steps);
+
+      /* Splitting the segments was stopped, and the rest of them are
+       * still queued for the next call */
+      if (reason != P2TR_REFINE_DONE)
+        {
+          self->suspended = TRUE;
+          return reason;
+        }
     }
+
+  self->suspended = FALSE;
+  return P2TR_REFINE_DONE;
 }
 
 static gboolean
 SplitPermitted (P2trDelaunayTerminator *self, P2trEdge *s, gdouble d)
 {
-  P2trCluster *startCluster = p2tr_cluster_get_for (P2TR_EDGE_START(s), s);
-  P2trCluster *endCluster =   p2tr_cluster_get_for (s->end, s);
-  P2trCluster *S_NOREF =      NULL;
+  const P2trCluster *startCluster = p2tr_cluster_get_cached (P2TR_EDGE_START(s), s);
+  const P2trCluster *endCluster =   p2tr_cluster_get_cached (s->end, s);
+  const P2trCluster *S_NOREF =      NULL;
   GList *iter;
   
   gboolean permitted = FALSE;
@@ -384,7 +920,7 @@ SplitPermitted (P2trDelaunayTerminator *self, P2trEdge *s, gdouble d)
     {
       S_NOREF = (startCluster != NULL) ? startCluster : endCluster;
 
-      for (iter = g_queue_peek_head_link (&S_NOREF->edges); iter != NULL; iter = iter->next)
+      for (iter = S_NOREF->edges.head; iter != NULL; iter = iter->next)
         if (TolerantIsShorter((P2trEdge*) iter->data, s)) /* e shorter than s */
           {
             permitted = TRUE;
@@ -399,19 +935,29 @@ SplitPermitted (P2trDelaunayTerminator *self, P2trEdge *s, gdouble d)
         permitted = TRUE;
     }
 
-  if (startCluster) p2tr_cluster_free (startCluster);
-  if (endCluster) p2tr_cluster_free (endCluster);
-
   return permitted;
 }
 
-static void
-SplitEncroachedSubsegments (P2trDelaunayTerminator *self, gdouble theta, P2trTriangleTooBig delta)
+/**
+ * Split the queued segments, until none is encroached or until one of
+ * the limits of the budget (other than the amount of steps, which only
+ * counts triangles) is reached. The segments which weren't split yet
+ * are kept in the queue
+ */
+static P2trRefineStopReason
+SplitEncroachedSubsegments (P2trDelaunayTerminator *self, gdouble theta, P2trSizingField *sizing, const P2trRefineBudget *budget)
 {
+  P2trRefineStopReason reason;
+
   while (! p2tr_dt_segment_queue_is_empty (self))
   {
-    P2trEdge *s = p2tr_dt_dequeue_segment (self);
-    if (p2tr_hash_set_contains (self->cdt->mesh->edges, s))
+    P2trEdge *s;
+
+    if ((reason = p2tr_dt_check_budget (self, budget, 0)) != P2TR_REFINE_DONE)
+      return reason;
+
+    s = p2tr_dt_dequeue_segment (self);
+    if (p2tr_dense_set_contains (self->cdt->mesh->edges, s, s->handle))
       {
         P2trVector2 v;
         P2trPoint *Pv;
@@ -424,7 +970,7 @@ SplitEncroachedSubsegments (P2trDelaunayTerminator *self, gdouble theta, P2trTri
 
         parts = p2tr_cdt_split_edge (self->cdt, s, Pv);
         
-        NewVertex (self, Pv, theta, delta);
+        NewVertex (self, Pv, theta, sizing);
 
         for (iter = parts; iter != NULL; iter = iter->next)
           {
@@ -439,10 +985,12 @@ SplitEncroachedSubsegments (P2trDelaunayTerminator *self, gdouble theta, P2trTri
       }
     p2tr_edge_unref (s);
   }
+
+  return P2TR_REFINE_DONE;
 }
 
 static void
-NewVertex (P2trDelaunayTerminator *self, P2trPoint *v, gdouble theta, P2trTriangleTooBig delta)
+NewVertex (P2trDelaunayTerminator *self, P2trPoint *v, gdouble theta, P2trSizingField *sizing)
 {
   GList *iter;
   for (iter = v->outgoing_edges; iter != NULL; iter = iter->next)
@@ -461,7 +1009,7 @@ NewVertex (P2trDelaunayTerminator *self, P2trPoint *v, gdouble theta, P2trTriang
        * since it's still faster */
       if (e->constrained && p2tr_cdt_is_encroached (e))
         p2tr_dt_enqueue_segment (self, e);
-      else if (delta (t) || p2tr_triangle_smallest_non_constrained_angle (t) < theta)
+      else if (p2tr_dt_triangle_is_bad (self, t, theta, sizing))
         p2tr_dt_enqueue_tri (self, t);
 
       p2tr_edge_unref (e);
@@ -532,3 +1080,73 @@ ChooseSplitVertex(P2trEdge *e, P2trVector2 *dst)
   if (! TolerantIsPowerOfTwoLength(resultLength))
     p2tr_exception_numeric ("Bad rounding!");
 }
+
+/**
+ * Choose the point that should be inserted in order to eliminate the
+ * bad triangle t, according to the placement strategy of the refiner.
+ * Return the triangle containing the point (reffed!), or NULL if the
+ * point is outside of the domain.
+ */
+static P2trTriangle*
+ChooseSteinerPoint (P2trDelaunayTerminator *self, P2trTriangle *t, P2trVector2 *dst)
+{
+  P2trTriangle *result;
+  gboolean      chosen = FALSE;
+
+  if (self->cdt->metric != NULL)
+    {
+      /* Anisotropic refinement places the points by the metric alone */
+      P2trMetric m;
+
+      p2tr_metric_field_eval_triangle (self->cdt->metric, t, &m);
+      p2tr_metric_triangle_circumcenter (&m, t, dst);
+      result = p2tr_mesh_find_point_local (self->cdt->mesh, dst, t);
+      if (result != NULL)
+        return result;
+
+      /* A triangle near the boundary may have its metric circumcenter
+       * outside of the domain even if no segment is encroached
+       * (encroachment is tested in the Euclidean space). Try the
+       * Euclidean circumcenter, and then the centroid which is always
+       * a valid choice */
+      p2tr_triangle_get_circum_center (t, dst, NULL);
+      result = p2tr_mesh_find_point_local (self->cdt->mesh, dst, t);
+      if (result != NULL)
+        return result;
+
+      dst->x = (P2TR_TRIANGLE_GET_POINT (t, 0)->c.x
+                + P2TR_TRIANGLE_GET_POINT (t, 1)->c.x
+                + P2TR_TRIANGLE_GET_POINT (t, 2)->c.x) / 3;
+      dst->y = (P2TR_TRIANGLE_GET_POINT (t, 0)->c.y
+                + P2TR_TRIANGLE_GET_POINT (t, 1)->c.y
+                + P2TR_TRIANGLE_GET_POINT (t, 2)->c.y) / 3;
+      return p2tr_triangle_ref (t);
+    }
+
+  switch (self->placement)
+    {
+      case P2TR_REFINER_PLACE_OFFCENTER:
+        p2tr_triangle_get_off_center (t, self->theta, dst, NULL);
+        chosen = TRUE;
+        break;
+
+      case P2TR_REFINER_PLACE_CALLBACK:
+        chosen = self->place_func (t, self->theta, dst, self->place_data);
+        break;
+
+      case P2TR_REFINER_PLACE_CIRCUMCENTER:
+        break;
+    }
+
+  if (chosen)
+    {
+      result = p2tr_mesh_find_point_local (self->cdt->mesh, dst, t);
+      if (result != NULL)
+        return result;
+      /* Points other than the circumcenter are not guaranteed to be
+       * inside the domain, so fall back to the circumcenter */
+    }
+
+  p2tr_triangle_get_circum_center (t, dst, NULL);
+  return p2tr_mesh_find_point_local (self->cdt->mesh, dst, t);
+}
@@ -33,9 +33,11 @@
 #ifndef __P2TC_REFINE_DELAUNAY_TERMINATOR_H__
 #define __P2TC_REFINE_DELAUNAY_TERMINATOR_H__
 
+#include <stdio.h>
 #include <glib.h>
 #include "rcdt.h"
 #include "refiner.h"
+#include "sizing-field.h"
 #include "vedge.h"
 
 typedef struct
@@ -44,7 +46,14 @@ typedef struct
   GQueue              Qs;
   GSequence          *Qt;
   gdouble             theta;
-  P2trTriangleTooBig  delta;
+  /* The size control, or NULL if there is none */
+  P2trSizingField    *sizing;
+  P2trSteinerPlacement placement;
+  P2trSteinerPointFunc place_func;
+  gpointer            place_data;
+  /* TRUE if the queues hold a refinement which was stopped before it
+   * was finished, and should be continued without scanning the mesh */
+  gboolean            suspended;
 } P2trDelaunayTerminator;
 
 gboolean  p2tr_cdt_test_encroachment_ignore_visibility (const P2trVector2 *w,
@@ -62,10 +71,45 @@ gboolean      p2tr_cdt_is_encroached (P2trEdge *E);
 P2trDelaunayTerminator*
 p2tr_dt_new (gdouble theta, P2trTriangleTooBig delta, P2trCDT *cdt);
 
+P2trDelaunayTerminator*
+p2tr_dt_new_full (gdouble               theta,
+                  P2trTriangleTooBig    delta,
+                  P2trSteinerPlacement  placement,
+                  P2trSteinerPointFunc  place_func,
+                  gpointer              place_data,
+                  P2trCDT              *cdt);
+
+void p2tr_dt_set_sizing_field (P2trDelaunayTerminator *self,
+                               P2trSizingField        *sizing);
+
 void p2tr_dt_free (P2trDelaunayTerminator *self);
 
+void p2tr_dt_reset (P2trDelaunayTerminator *self);
+
+void p2tr_dt_save_queues (P2trDelaunayTerminator *self,
+                          FILE                   *out);
+
+gboolean p2tr_dt_load_queues (P2trDelaunayTerminator *self,
+                              FILE                   *in);
+
+void p2tr_dt_seed_region (P2trDelaunayTerminator  *self,
+                          P2trTriangle           **triangles,
+                          guint                    count);
+
+void p2tr_dt_seed_box (P2trDelaunayTerminator *self,
+                       gdouble                 min_x,
+                       gdouble                 min_y,
+                       gdouble                 max_x,
+                       gdouble                 max_y,
+                       P2trTriangle           *initial_guess);
+
 void p2tr_dt_refine (P2trDelaunayTerminator   *self,
                      gint                      max_steps,
                      P2trRefineProgressNotify  on_progress);
 
+P2trRefineStopReason
+     p2tr_dt_refine_budget (P2trDelaunayTerminator   *self,
+                            const P2trRefineBudget   *budget,
+                            P2trRefineProgressNotify  on_progress);
+
 #endif
@@ -0,0 +1,216 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <glib.h>
+#include "rutils.h"
+#include "dense-set.h"
+
+#define P2TR_DENSE_SET_MIN_CAPACITY 64
+
+P2trDenseSet*
+p2tr_dense_set_new (void)
+{
+  P2trDenseSet *self = g_slice_new (P2trDenseSet);
+
+  self->items         = NULL;
+  self->item_slots    = NULL;
+  self->slots         = NULL;
+  self->generations   = NULL;
+  self->size          = 0;
+  self->capacity      = 0;
+  self->slot_count    = 0;
+  self->slot_capacity = 0;
+  self->free_slot     = P2TR_HANDLE_NONE;
+
+  return self;
+}
+
+void
+p2tr_dense_set_free (P2trDenseSet *self)
+{
+  g_free (self->items);
+  g_free (self->item_slots);
+  g_free (self->slots);
+  g_free (self->generations);
+  g_slice_free (P2trDenseSet, self);
+}
+
+static guint32
+p2tr_dense_set_alloc_slot (P2trDenseSet *self)
+{
+  guint32 slot;
+
+  if (self->free_slot != P2TR_HANDLE_NONE)
+    {
+      slot = self->free_slot;
+      self->free_slot = self->slots[slot];
+      return slot;
+    }
+
+  /* The last index is reserved so that P2TR_HANDLE_NONE is never a
+   * valid handle. Since slots are retired after their generations are
+   * exhausted, this limits the amount of insertions into the set */
+  if (self->slot_count >= P2TR_HANDLE_INDEX_MASK)
+    p2tr_exception_programmatic ("Too many insertions into a dense set!");
+
+  if (self->slot_count == self->slot_capacity)
+    {
+      self->slot_capacity = MAX (P2TR_DENSE_SET_MIN_CAPACITY,
+                                 self->slot_capacity * 2);
+      self->slots = g_renew (guint32, self->slots, self->slot_capacity);
+      self->generations = g_renew (guint8, self->generations, self->slot_capacity);
+    }
+
+  slot = self->slot_count++;
+  self->generations[slot] = 0;
+  return slot;
+}
+
+P2trHandle
+p2tr_dense_set_insert (P2trDenseSet *self,
+                       gpointer      element)
+{
+  guint32 slot = p2tr_dense_set_alloc_slot (self);
+
+  if (self->size == self->capacity)
+    {
+      self->capacity = MAX (P2TR_DENSE_SET_MIN_CAPACITY, self->capacity * 2);
+      self->items = g_renew (gpointer, self->items, self->capacity);
+      self->item_slots = g_renew (guint32, self->item_slots, self->capacity);
+    }
+
+  self->items[self->size] = element;
+  self->item_slots[self->size] = slot;
+  self->slots[slot] = self->size;
+  ++self->size;
+
+  return (((guint32) self->generations[slot]) << P2TR_HANDLE_INDEX_BITS) | slot;
+}
+
+static inline gboolean
+p2tr_dense_set_handle_is_valid (P2trDenseSet *self,
+                                P2trHandle    handle)
+{
+  guint32 slot = P2TR_HANDLE_INDEX (handle);
+
+  return slot < self->slot_count
+      && self->generations[slot] == P2TR_HANDLE_GENERATION (handle)
+      && self->slots[slot] < self->size
+      && self->item_slots[self->slots[slot]] == slot;
+}
+
+void
+p2tr_dense_set_remove (P2trDenseSet *self,
+                       P2trHandle    handle)
+{
+  guint32 slot = P2TR_HANDLE_INDEX (handle);
+  guint32 index, last;
+
+  if (! p2tr_dense_set_handle_is_valid (self, handle))
+    p2tr_exception_programmatic ("Removing an element which is not in the set!");
+
+  index = self->slots[slot];
+  last = --self->size;
+
+  /* Move the last element into the hole, to keep the array dense */
+  if (index != last)
+    {
+      self->items[index] = self->items[last];
+      self->item_slots[index] = self->item_slots[last];
+      self->slots[self->item_slots[index]] = index;
+    }
+
+  /* A slot whose generation would wrap around is retired instead of
+   * being reused, so that a handle is never given to two different
+   * elements and stale handles are always detected */
+  if (self->generations[slot] == P2TR_HANDLE_GENERATION_MASK)
+    {
+      self->slots[slot] = P2TR_HANDLE_NONE;
+      return;
+    }
+
+  ++self->generations[slot];
+  self->slots[slot] = self->free_slot;
+  self->free_slot = slot;
+}
+
+gpointer
+p2tr_dense_set_lookup (P2trDenseSet *self,
+                       P2trHandle    handle)
+{
+  if (! p2tr_dense_set_handle_is_valid (self, handle))
+    return NULL;
+  return self->items[self->slots[P2TR_HANDLE_INDEX (handle)]];
+}
+
+gboolean
+p2tr_dense_set_contains (P2trDenseSet  *self,
+                         gconstpointer  element,
+                         P2trHandle     handle)
+{
+  return element != NULL && p2tr_dense_set_lookup (self, handle) == element;
+}
+
+guint
+p2tr_dense_set_index_of (P2trDenseSet *self,
+                         P2trHandle    handle)
+{
+  g_assert (p2tr_dense_set_handle_is_valid (self, handle));
+  return self->slots[P2TR_HANDLE_INDEX (handle)];
+}
+
+gsize
+p2tr_dense_set_memory_size (P2trDenseSet *self)
+{
+  return sizeof (P2trDenseSet)
+      + self->capacity * (sizeof (gpointer) + sizeof (guint32))
+      + self->slot_capacity * (sizeof (guint32) + sizeof (guint8));
+}
+
+void
+p2tr_dense_set_iter_init (P2trDenseSetIter *iter,
+                          P2trDenseSet     *set)
+{
+  iter->set = set;
+  iter->index = 0;
+}
+
+gboolean
+p2tr_dense_set_iter_next (P2trDenseSetIter *iter,
+                          gpointer         *value)
+{
+  if (iter->index >= iter->set->size)
+    return FALSE;
+
+  *value = iter->set->items[iter->index++];
+  return TRUE;
+}
@@ -0,0 +1,210 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __P2TC_REFINE_DENSE_SET_H__
+#define __P2TC_REFINE_DENSE_SET_H__
+
+#include <glib.h>
+
+/**
+ * \defgroup P2trDenseSet P2trDenseSet - Dense Handle-Based Sets
+ * A set of pointers which are stored densely in one array, for fast
+ * and cache friendly iteration. Each element inserted into the set
+ * receives a 32-bit handle, which allows removing the element and
+ * testing whether it's still in the set in O(1), without any hashing.
+ *
+ * Removing an element moves the last element of the array into its
+ * place, so the order of iteration is only stable as long as the set
+ * is not modified.
+ * @{
+ */
+
+/**
+ * A handle of an element inside a \ref P2trDenseSet. The low
+ * \ref P2TR_HANDLE_INDEX_BITS bits are the index of the slot of the
+ * element, and the remaining high bits are the generation of the slot
+ * which is bumped every time the slot is freed, so that stale handles
+ * of removed elements can be detected.
+ *
+ * A slot is retired once its generation is exhausted, so a handle is
+ * never reused and a stale handle never refers to a newer element. The
+ * cost is a limit of about 2^32 insertions during the lifetime of a
+ * set (2^26 slots, each used by 2^6 generations).
+ */
+typedef guint32 P2trHandle;
+
+/** The amount of bits of a handle used for the slot index */
+#define P2TR_HANDLE_INDEX_BITS 26
+
+/** A mask extracting the slot index from a handle */
+#define P2TR_HANDLE_INDEX_MASK ((((guint32) 1) << P2TR_HANDLE_INDEX_BITS) - 1)
+
+/** A mask for the generation of a slot, after shifting it down */
+#define P2TR_HANDLE_GENERATION_MASK (G_MAXUINT32 >> P2TR_HANDLE_INDEX_BITS)
+
+/** A handle value which never refers to any element */
+#define P2TR_HANDLE_NONE ((P2trHandle) G_MAXUINT32)
+
+/** Extract the slot index of a handle */
+#define P2TR_HANDLE_INDEX(h) ((h) & P2TR_HANDLE_INDEX_MASK)
+
+/** Extract the generation of a handle */
+#define P2TR_HANDLE_GENERATION(h) ((h) >> P2TR_HANDLE_INDEX_BITS)
+
+/**
+ * A struct for a set of pointers stored in a dense array
+ */
+typedef struct
+{
+  /** The elements of the set, packed at the begining of the array */
+  gpointer  *items;
+
+  /** For each element in \ref items, the index of its slot */
+  guint32   *item_slots;
+
+  /**
+   * For each slot, the position of its element inside \ref items if
+   * the slot is used, or the index of the next free slot otherwise
+   */
+  guint32   *slots;
+
+  /** For each slot, its current generation */
+  guint8    *generations;
+
+  /** The amount of elements in the set */
+  guint      size;
+
+  /** The allocated length of \ref items and \ref item_slots */
+  guint      capacity;
+
+  /** The amount of slots that were ever used */
+  guint      slot_count;
+
+  /** The allocated length of \ref slots and \ref generations */
+  guint      slot_capacity;
+
+  /** The first free slot, or \ref P2TR_HANDLE_NONE if there is none */
+  guint32    free_slot;
+} P2trDenseSet;
+
+/**
+ * An iterator over the elements of a \ref P2trDenseSet
+ */
+typedef struct
+{
+  P2trDenseSet *set;
+  guint         index;
+} P2trDenseSetIter;
+
+/**
+ * Create a new empty dense set
+ * @return The newly created set
+ */
+P2trDenseSet* p2tr_dense_set_new       (void);
+
+/**
+ * Free a dense set. The elements themselves are not freed
+ * @param self The set to free
+ */
+void          p2tr_dense_set_free      (P2trDenseSet *self);
+
+/**
+ * Insert an element into the set
+ * @param self The set to insert the element into
+ * @param element The element to insert. Must not be in the set already
+ * @return The handle of the element inside the set
+ */
+P2trHandle    p2tr_dense_set_insert    (P2trDenseSet *self,
+                                        gpointer      element);
+
+/**
+ * Remove an element from the set
+ * @param self The set to remove the element from
+ * @param handle The handle which was returned when the element was
+ *        inserted. It must refer to an element currently in the set
+ */
+void          p2tr_dense_set_remove    (P2trDenseSet *self,
+                                        P2trHandle    handle);
+
+/**
+ * Find the element with the given handle
+ * @param self The set to search
+ * @param handle The handle of the element
+ * @return The element, or NULL if the handle is stale or invalid
+ */
+gpointer      p2tr_dense_set_lookup    (P2trDenseSet *self,
+                                        P2trHandle    handle);
+
+/**
+ * Check whether an element is in the set
+ * @param self The set to search
+ * @param element The element to look for
+ * @param handle The handle that the element received when it was
+ *        inserted into the set, or \ref P2TR_HANDLE_NONE
+ * @return TRUE if the element is in the set, FALSE otherwise
+ */
+gboolean      p2tr_dense_set_contains  (P2trDenseSet  *self,
+                                        gconstpointer  element,
+                                        P2trHandle     handle);
+
+/**
+ * Find the position of an element inside the dense array of the set.
+ * This position stays valid only as long as the set is not modified.
+ * @param self The set containing the element
+ * @param handle The handle of an element currently in the set
+ * @return The position of the element, in the range [0, size)
+ */
+guint         p2tr_dense_set_index_of  (P2trDenseSet *self,
+                                        P2trHandle    handle);
+
+/**
+ * Find the amount of memory used by the set itself (not including the
+ * elements)
+ * @param self The set
+ * @return The size of the memory, in bytes
+ */
+gsize         p2tr_dense_set_memory_size (P2trDenseSet *self);
+
+/** The amount of elements in a dense set */
+#define p2tr_dense_set_size(set) ((set)->size)
+
+/** The element at a given position of the dense array of a set */
+#define p2tr_dense_set_get(set,index) ((set)->items[(index)])
+
+void          p2tr_dense_set_iter_init (P2trDenseSetIter *iter,
+                                        P2trDenseSet     *set);
+
+gboolean      p2tr_dense_set_iter_next (P2trDenseSetIter *iter,
+                                        gpointer         *value);
+
+/** @} */
+#endif
@@ -32,6 +32,7 @@
 
 #include <math.h>
 #include <glib.h>
+#include "pool.h"
 
 #include "point.h"
 #include "edge.h"
@@ -49,6 +50,7 @@ p2tr_edge_init (P2trEdge  *self,
                           end->c.x - start->c.x);
   self->constrained = constrained;
   self->delaunay    = FALSE;
+  self->handle      = P2TR_HANDLE_NONE;
   self->end         = end;
   self->mirror      = mirror;
   self->refcount    = 0;
@@ -60,11 +62,14 @@ p2tr_edge_new (P2trPoint *start,
                P2trPoint *end,
                gboolean   constrained)
 {
-  P2trEdge *self   = g_slice_new (P2trEdge);
-  P2trEdge *mirror = g_slice_new (P2trEdge);
+  /* Edges are allocated from the pools of the mesh of their points */
+  P2trPoolSet *pools  = (start->mesh != NULL) ? start->mesh->pools : NULL;
+  P2trEdge    *self   = p2tr_pool_new (P2trEdge, P2TR_POOL_EDGE, pools);
+  P2trEdge    *mirror = p2tr_pool_new (P2trEdge, P2TR_POOL_EDGE, pools);
 
   p2tr_edge_init (self, start, end, constrained, mirror);
   p2tr_edge_init (mirror, end, start, constrained, self);
+  self->pools = mirror->pools = pools;
 
   p2tr_point_ref (start);
   p2tr_point_ref (end);
@@ -150,9 +155,11 @@ p2tr_edge_remove (P2trEdge *self)
 void
 p2tr_edge_free (P2trEdge *self)
 {
+  P2trPoolSet *pools = self->pools;
+
   g_assert (p2tr_edge_is_removed (self));
-  g_slice_free (P2trEdge, self->mirror);
-  g_slice_free (P2trEdge, self);
+  p2tr_pool_delete (P2trEdge, P2TR_POOL_EDGE, pools, self->mirror);
+  p2tr_pool_delete (P2trEdge, P2TR_POOL_EDGE, pools, self);
 }
 
 void
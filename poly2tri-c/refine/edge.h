@@ -36,6 +36,8 @@
 #include <glib.h>
 #include "circle.h"
 #include "triangulation.h"
+#include "dense-set.h"
+#include "pool.h"
 
 /**
  * @struct P2trEdge_
@@ -51,6 +53,12 @@ struct P2trEdge_
   
   /** Is this a constrained edge? */
   gboolean      constrained;
+
+  /**
+   * The handle of this edge inside the set of edges of its mesh, or
+   * @ref P2TR_HANDLE_NONE if it's not a part of any mesh
+   */
+  P2trHandle    handle;
   
   /** The triangle where this edge goes clockwise along its outline */
   P2trTriangle *tri;
@@ -71,6 +79,12 @@ struct P2trEdge_
 
   /** A count of references to the edge */
   guint         refcount;
+
+  /**
+   * The pools from which the edge was allocated, or NULL if it was
+   * allocated with g_slice
+   */
+  P2trPoolSet  *pools;
 };
 
 #define P2TR_EDGE_START(E) ((E)->mirror->end)
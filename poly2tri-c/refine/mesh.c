@@ -31,6 +31,7 @@
  */
 
 #include <glib.h>
+#include "pool.h"
 #include "rutils.h"
 
 #include "mesh.h"
@@ -45,13 +46,17 @@ p2tr_mesh_new (void)
   P2trMesh *mesh = g_slice_new (P2trMesh);
 
   mesh->refcount = 1;
-  mesh->edges = p2tr_hash_set_new_default ();
-  mesh->points = p2tr_hash_set_new_default ();
-  mesh->triangles = p2tr_hash_set_new_default ();
+  mesh->edges = p2tr_dense_set_new ();
+  mesh->points = p2tr_dense_set_new ();
+  mesh->triangles = p2tr_dense_set_new ();
 
   mesh->record_undo = FALSE;
   g_queue_init (&mesh->undo);
 
+  mesh->changes = NULL;
+
+  mesh->pools = p2tr_pool_set_new ();
+
   return mesh;
 }
 
@@ -62,7 +67,7 @@ p2tr_mesh_add_point (P2trMesh  *self,
   g_assert (point->mesh == NULL);
   point->mesh = self;
   p2tr_mesh_ref (self);
-  p2tr_hash_set_insert (self->points, point);
+  point->handle = p2tr_dense_set_insert (self->points, point);
 
   if (self->record_undo)
     g_queue_push_tail (&self->undo, p2tr_mesh_action_new_point (point));
@@ -82,15 +87,16 @@ p2tr_mesh_new_point2 (P2trMesh *self,
                       gdouble   x,
                       gdouble   y)
 {
-  return p2tr_mesh_add_point (self, p2tr_point_new2 (x, y));
+  return p2tr_mesh_add_point (self, p2tr_point_new_from_pools (self->pools, x, y));
 }
 
 P2trEdge*
 p2tr_mesh_add_edge (P2trMesh *self,
                     P2trEdge *edge)
 {
-  p2tr_hash_set_insert (self->edges, p2tr_edge_ref (edge->mirror));
-  p2tr_hash_set_insert (self->edges, p2tr_edge_ref (edge));
+  edge->mirror->handle = p2tr_dense_set_insert (self->edges,
+                                                p2tr_edge_ref (edge->mirror));
+  edge->handle = p2tr_dense_set_insert (self->edges, p2tr_edge_ref (edge));
 
   if (self->record_undo)
     g_queue_push_tail (&self->undo, p2tr_mesh_action_new_edge (edge));
@@ -125,11 +131,15 @@ P2trTriangle*
 p2tr_mesh_add_triangle (P2trMesh     *self,
                         P2trTriangle *tri)
 {
-  p2tr_hash_set_insert (self->triangles, tri);
+  tri->handle = p2tr_dense_set_insert (self->triangles, tri);
+  p2tr_triangle_get_quality (tri);
 
   if (self->record_undo)
     g_queue_push_tail (&self->undo, p2tr_mesh_action_new_triangle (tri));
 
+  if (self->changes != NULL)
+    p2tr_mesh_on_triangle_changed (self, tri);
+
   return p2tr_triangle_ref (tri);
 }
 
@@ -152,7 +162,8 @@ p2tr_mesh_on_point_removed (P2trMesh  *self,
   point->mesh = NULL;
   p2tr_mesh_unref (self);
 
-  p2tr_hash_set_remove (self->points, point);
+  p2tr_dense_set_remove (self->points, point->handle);
+  point->handle = P2TR_HANDLE_NONE;
 
   if (self->record_undo)
     g_queue_push_tail (&self->undo, p2tr_mesh_action_del_point (point));
@@ -164,9 +175,11 @@ void
 p2tr_mesh_on_edge_removed (P2trMesh *self,
                            P2trEdge *edge)
 {
-  p2tr_hash_set_remove (self->edges, edge->mirror);
+  p2tr_dense_set_remove (self->edges, edge->mirror->handle);
+  edge->mirror->handle = P2TR_HANDLE_NONE;
   p2tr_edge_unref (edge->mirror);
-  p2tr_hash_set_remove (self->edges, edge);
+  p2tr_dense_set_remove (self->edges, edge->handle);
+  edge->handle = P2TR_HANDLE_NONE;
 
   if (self->record_undo)
     g_queue_push_tail (&self->undo, p2tr_mesh_action_del_edge (edge));
@@ -178,7 +191,11 @@ void
 p2tr_mesh_on_triangle_removed (P2trMesh     *self,
                                P2trTriangle *triangle)
 {
-  p2tr_hash_set_remove (self->triangles, triangle);
+  if (self->changes != NULL)
+    p2tr_mesh_on_triangle_changed (self, triangle);
+
+  p2tr_dense_set_remove (self->triangles, triangle->handle);
+  triangle->handle = P2TR_HANDLE_NONE;
 
   if (self->record_undo)
     g_queue_push_tail (&self->undo, p2tr_mesh_action_del_triangle (triangle));
@@ -186,6 +203,56 @@ p2tr_mesh_on_triangle_removed (P2trMesh     *self,
   p2tr_triangle_unref (triangle);
 }
 
+void
+p2tr_mesh_on_triangle_changed (P2trMesh     *self,
+                               P2trTriangle *triangle)
+{
+  P2trMeshBox  box;
+  gint         i;
+
+  if (self->changes == NULL)
+    return;
+
+  box.min_x = box.max_x = P2TR_TRIANGLE_GET_POINT (triangle, 0)->c.x;
+  box.min_y = box.max_y = P2TR_TRIANGLE_GET_POINT (triangle, 0)->c.y;
+
+  for (i = 1; i < 3; i++)
+    {
+      const P2trVector2 *c = &P2TR_TRIANGLE_GET_POINT (triangle, i)->c;
+      box.min_x = MIN (box.min_x, c->x);
+      box.min_y = MIN (box.min_y, c->y);
+      box.max_x = MAX (box.max_x, c->x);
+      box.max_y = MAX (box.max_y, c->y);
+    }
+
+  g_array_append_val (self->changes, box);
+}
+
+void
+p2tr_mesh_track_changes (P2trMesh *self,
+                         gboolean  track)
+{
+  if (track && self->changes == NULL)
+    self->changes = g_array_new (FALSE, FALSE, sizeof (P2trMeshBox));
+  else if (! track && self->changes != NULL)
+    {
+      g_array_free (self->changes, TRUE);
+      self->changes = NULL;
+    }
+}
+
+GArray*
+p2tr_mesh_take_changes (P2trMesh *self)
+{
+  GArray *result = self->changes;
+
+  if (result == NULL)
+    p2tr_exception_programmatic ("Changes aren't tracked on this mesh!");
+
+  self->changes = g_array_new (FALSE, FALSE, sizeof (P2trMeshBox));
+  return result;
+}
+
 void
 p2tr_mesh_action_group_begin (P2trMesh *self)
 {
@@ -229,34 +296,30 @@ p2tr_mesh_action_group_undo (P2trMesh *self)
 void
 p2tr_mesh_clear (P2trMesh *self)
 {
-  P2trHashSetIter iter;
-  gpointer temp;
+  P2trDenseSet *set;
 
   /* While iterating over the sets of points/edges/triangles to remove
    * all the mesh elements, the sets will be modified by the removal
-   * operation itself. Therefore we can't use a regular iterator -
-   * instead we must look always at the first place */
-  p2tr_hash_set_iter_init (&iter, self->triangles);
-  while (p2tr_hash_set_iter_next (&iter, &temp))
-    {
-      p2tr_triangle_remove ((P2trTriangle*)temp);
-      p2tr_hash_set_iter_init (&iter, self->triangles);
-    }
-
-  p2tr_hash_set_iter_init (&iter, self->edges);
-  while (p2tr_hash_set_iter_next (&iter, &temp))
+   * operation itself. Removing the last element of a dense set never
+   * moves any other element, so we always remove from the end */
+  set = self->triangles;
+  while (p2tr_dense_set_size (set) > 0)
+    p2tr_triangle_remove ((P2trTriangle*) p2tr_dense_set_get (set, p2tr_dense_set_size (set) - 1));
+
+  set = self->edges;
+  while (p2tr_dense_set_size (set) > 0)
     {
-      g_assert (((P2trEdge*)temp)->tri == NULL);
-      p2tr_edge_remove ((P2trEdge*)temp);
-      p2tr_hash_set_iter_init (&iter, self->edges);
+      P2trEdge *e = (P2trEdge*) p2tr_dense_set_get (set, p2tr_dense_set_size (set) - 1);
+      g_assert (e->tri == NULL);
+      p2tr_edge_remove (e);
     }
 
-  p2tr_hash_set_iter_init (&iter, self->points);
-  while (p2tr_hash_set_iter_next (&iter, &temp))
+  set = self->points;
+  while (p2tr_dense_set_size (set) > 0)
     {
-      g_assert (((P2trPoint*)temp)->outgoing_edges == NULL);
-      p2tr_point_remove ((P2trPoint*)temp);
-      p2tr_hash_set_iter_init (&iter, self->points);
+      P2trPoint *p = (P2trPoint*) p2tr_dense_set_get (set, p2tr_dense_set_size (set) - 1);
+      g_assert (p->outgoing_edges == NULL);
+      p2tr_point_remove (p);
     }
 }
 
@@ -266,11 +329,17 @@ p2tr_mesh_free (P2trMesh *self)
   if (self->record_undo)
     p2tr_mesh_action_group_commit (self);
 
+  /* Don't track the removal of everything */
+  p2tr_mesh_track_changes (self, FALSE);
   p2tr_mesh_clear (self);
 
-  p2tr_hash_set_free (self->points);
-  p2tr_hash_set_free (self->edges);
-  p2tr_hash_set_free (self->triangles);
+  p2tr_dense_set_free (self->points);
+  p2tr_dense_set_free (self->edges);
+  p2tr_dense_set_free (self->triangles);
+
+  /* If no object of the mesh is still referenced, this releases the
+   * memory of all of them at once */
+  p2tr_pool_set_release (self->pools);
 
   g_slice_free (P2trMesh, self);
 }
@@ -304,11 +373,11 @@ p2tr_mesh_find_point2 (P2trMesh          *self,
                        gdouble           *u,
                        gdouble           *v)
 {
-  P2trHashSetIter iter;
+  P2trDenseSetIter iter;
   P2trTriangle *result;
   
-  p2tr_hash_set_iter_init (&iter, self->triangles);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*)&result))
+  p2tr_dense_set_iter_init (&iter, self->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&result))
     if (p2tr_triangle_contains_point2 (result, pt, u, v) != P2TR_INTRIANGLE_OUT)
       return p2tr_triangle_ref (result);
 
@@ -387,11 +456,11 @@ p2tr_mesh_get_bounds (P2trMesh    *self,
   gdouble lmin_x = + G_MAXDOUBLE, lmin_y = + G_MAXDOUBLE;
   gdouble lmax_x = - G_MAXDOUBLE, lmax_y = - G_MAXDOUBLE;
 
-  P2trHashSetIter iter;
+  P2trDenseSetIter iter;
   P2trPoint *pt;
 
-  p2tr_hash_set_iter_init (&iter, self->points);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*) &pt))
+  p2tr_dense_set_iter_init (&iter, self->points);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*) &pt))
     {
       gdouble x = pt->c.x;
       gdouble y = pt->c.y;
@@ -407,12 +476,24 @@ p2tr_mesh_get_bounds (P2trMesh    *self,
   *max_y = lmax_y;
 }
 
+gsize
+p2tr_mesh_get_memory_size (P2trMesh *self)
+{
+  return sizeof (P2trMesh)
+      + p2tr_dense_set_size (self->points) * sizeof (P2trPoint)
+      + p2tr_dense_set_size (self->edges) * sizeof (P2trEdge)
+      + p2tr_dense_set_size (self->triangles) * sizeof (P2trTriangle)
+      + p2tr_dense_set_memory_size (self->points)
+      + p2tr_dense_set_memory_size (self->edges)
+      + p2tr_dense_set_memory_size (self->triangles);
+}
+
 void
 p2tr_mesh_save_to_file (P2trMesh *self,
                         FILE     *out)
 {
-  guint point_count        = p2tr_hash_set_size (self->points);
-  guint triangle_count     = p2tr_hash_set_size (self->triangles);
+  guint point_count        = p2tr_dense_set_size (self->points);
+  guint triangle_count     = p2tr_dense_set_size (self->triangles);
   guint edge_count_unused  = 0;
 
   P2trPoint    *pt;
@@ -420,53 +501,32 @@ p2tr_mesh_save_to_file (P2trMesh *self,
   gfloat        z_value    = 0;
 
   guint        pt_index;
-  GHashTable  *point2index;
-  guint       *indexes;
-  P2trHashSetIter siter;
+  P2trDenseSetIter siter;
 
   /* Begin with the file header */
   fprintf (out, "OFF %u %u %u\n", point_count, triangle_count,
       edge_count_unused);
 
-  /* We would like point2index to maintain a mapping from a point to
-   * it's index in the file. However, we can't do this directly since
-   * a GHashTable stores gpointer values and we have no gaurantee that
-   * sizeof(guint) <= sizeof(gpointer). It is probably true in most
-   * architectures, but relying on it may cause some exotic bugs in
-   * architectures that do not satisfy this condition...
-   * So, we'll create an array of running indexes and then we'll store
-   * a reference to the index in the array.
-   */
-  indexes = g_new (guint, point_count);
-  point2index = g_hash_table_new (g_direct_hash, g_int_equal);
-
-  /* Now add a line for each point */
-  pt_index = 0;
-  p2tr_hash_set_iter_init (&siter, self->points);
-  while (p2tr_hash_set_iter_next (&siter, (gpointer*)&pt))
-    {
-      indexes[pt_index] = pt_index;
-      g_hash_table_insert (point2index, pt, &indexes[pt_index]);
-      fprintf (out, "%f %f %f\n", pt->c.x, pt->c.y, z_value);
-      pt_index++;
-    }
+  /* Now add a line for each point. The points are written in the order
+   * of the dense set, so the index of each point in the file is simply
+   * its index inside the set */
+  p2tr_dense_set_iter_init (&siter, self->points);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&pt))
+    fprintf (out, "%f %f %f\n", pt->c.x, pt->c.y, z_value);
 
-  p2tr_hash_set_iter_init (&siter, self->triangles);
-  while (p2tr_hash_set_iter_next (&siter, (gpointer*)&tr))
+  p2tr_dense_set_iter_init (&siter, self->triangles);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&tr))
     {
-      guint* pt_indexes[3];
+      guint pt_indexes[3];
       for (pt_index = 0; pt_index < 3; ++pt_index)
         {
           pt = P2TR_TRIANGLE_GET_POINT (tr, pt_index);
-          pt_indexes[pt_index] = g_hash_table_lookup (point2index, pt);
+          pt_indexes[pt_index] = p2tr_dense_set_index_of (self->points, pt->handle);
         }
 
       fprintf (out, "%u %u %u %u\n", 3,
-          *pt_indexes[0],*pt_indexes[1],  *pt_indexes[2]);
+          pt_indexes[0], pt_indexes[1], pt_indexes[2]);
     }
-
-  g_hash_table_destroy (point2index);
-  g_free (indexes);
 }
 
 gboolean
@@ -587,3 +647,156 @@ p2tr_mesh_load (const gchar *path)
 
   return result;
 }
+
+/**
+ * Check whether an edge is the half which is written in a checkpoint -
+ * the one going from the point with the lower index
+ */
+static gboolean
+p2tr_mesh_edge_is_saved_half (P2trMesh *self,
+                              P2trEdge *e)
+{
+  return p2tr_dense_set_index_of (self->points, P2TR_EDGE_START (e)->handle)
+      < p2tr_dense_set_index_of (self->points, e->end->handle);
+}
+
+void
+p2tr_mesh_save_checkpoint (P2trMesh *self,
+                           FILE     *out)
+{
+  guint point_count        = p2tr_dense_set_size (self->points);
+  guint triangle_count     = p2tr_dense_set_size (self->triangles);
+  guint segment_count      = 0;
+
+  P2trPoint    *pt;
+  P2trEdge     *e;
+  P2trTriangle *tr;
+
+  guint        pt_index;
+  P2trDenseSetIter siter;
+
+  /* Each constrained edge is stored once, from the point with the
+   * lower index to the point with the higher one */
+  p2tr_dense_set_iter_init (&siter, self->edges);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&e))
+    if (e->constrained && p2tr_mesh_edge_is_saved_half (self, e))
+      ++segment_count;
+
+  fprintf (out, "P2TRM %u %u %u\n", point_count, segment_count,
+      triangle_count);
+
+  /* The points are written in the order of the dense set, with enough
+   * digits to be read back exactly */
+  p2tr_dense_set_iter_init (&siter, self->points);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&pt))
+    fprintf (out, "%.17g %.17g\n", pt->c.x, pt->c.y);
+
+  p2tr_dense_set_iter_init (&siter, self->edges);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&e))
+    if (e->constrained && p2tr_mesh_edge_is_saved_half (self, e))
+      fprintf (out, "%u %u\n",
+          p2tr_dense_set_index_of (self->points, P2TR_EDGE_START (e)->handle),
+          p2tr_dense_set_index_of (self->points, e->end->handle));
+
+  p2tr_dense_set_iter_init (&siter, self->triangles);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&tr))
+    {
+      guint pt_indexes[3];
+      for (pt_index = 0; pt_index < 3; ++pt_index)
+        {
+          pt = P2TR_TRIANGLE_GET_POINT (tr, pt_index);
+          pt_indexes[pt_index] = p2tr_dense_set_index_of (self->points, pt->handle);
+        }
+
+      fprintf (out, "%u %u %u\n",
+          pt_indexes[0], pt_indexes[1], pt_indexes[2]);
+    }
+}
+
+P2trMesh*
+p2tr_mesh_load_checkpoint (FILE *in)
+{
+  guint point_count;
+  guint segment_count;
+  guint triangle_count;
+
+  GPtrArray    *pts  = NULL;
+
+  P2trMesh     *mesh = NULL;
+  gdouble       x, y;
+
+  guint        i, j;
+  guint        pt_indexes[3];
+  P2trPoint   *points[3];
+  P2trEdge    *edges[3];
+
+  gint         read_count;
+
+  /* Skip any whitespace left by whatever was read before */
+  read_count = fscanf (in, " P2TRM %u %u %u", &point_count,
+      &segment_count, &triangle_count);
+  g_return_val_if_fail (read_count == 3, NULL);
+
+  mesh = p2tr_mesh_new ();
+
+  pts = g_ptr_array_new_full (point_count,
+      (GDestroyNotify) p2tr_point_unref);
+  for (i = 0; i < point_count; ++i)
+    {
+      read_count = fscanf (in, "%lf %lf", &x, &y);
+      if (read_count != 2)
+        goto error_finish;
+      g_ptr_array_add (pts, p2tr_mesh_new_point2 (mesh, x, y));
+    }
+
+  /* The segments come before the triangles which use them */
+  for (i = 0; i < segment_count; ++i)
+    {
+      read_count = fscanf (in, "%u %u", &pt_indexes[0], &pt_indexes[1]);
+      if (read_count != 2
+          || pt_indexes[0] >= point_count || pt_indexes[1] >= point_count)
+        goto error_finish;
+
+      edges[0] = p2tr_mesh_new_or_existing_edge (mesh,
+          (P2trPoint*) g_ptr_array_index (pts, pt_indexes[0]),
+          (P2trPoint*) g_ptr_array_index (pts, pt_indexes[1]), TRUE);
+      edges[0]->constrained = edges[0]->mirror->constrained = TRUE;
+      p2tr_edge_unref (edges[0]);
+    }
+
+  for (i = 0; i < triangle_count; ++i)
+    {
+      read_count = fscanf (in, "%u %u %u", &pt_indexes[0],
+          &pt_indexes[1], &pt_indexes[2]);
+      if (read_count != 3)
+        goto error_finish;
+
+      for (j = 0; j < 3; ++j)
+        {
+          if (pt_indexes[j] >= point_count)
+            goto error_finish;
+          points[j] = (P2trPoint*) g_ptr_array_index (pts, pt_indexes[j]);
+        }
+
+      for (j = 0; j < 3; ++j)
+        edges[j] = p2tr_mesh_new_or_existing_edge (mesh,
+            points[j], points[(j + 1) % 3], FALSE);
+
+      p2tr_triangle_unref (p2tr_mesh_new_triangle (mesh,
+          edges[0], edges[1], edges[2]));
+
+      for (j = 0; j < 3; ++j)
+        p2tr_edge_unref (edges[j]);
+    }
+
+  if (FALSE)
+    {
+error_finish:
+      p2tr_mesh_unref (mesh);
+      mesh = NULL;
+    }
+
+  g_ptr_array_free (pts, TRUE);
+
+  return mesh;
+}
@@ -37,6 +37,8 @@
 #include <glib.h>
 #include "vector2.h"
 #include "rutils.h"
+#include "dense-set.h"
+#include "pool.h"
 #include "triangulation.h"
 
 /**
@@ -46,28 +48,37 @@
  * @{
  */
 
+/**
+ * An axis aligned rectangle in the plane of a mesh
+ */
+typedef struct
+{
+  gdouble min_x, min_y;
+  gdouble max_x, max_y;
+} P2trMeshBox;
+
 /**
  * A struct for representing a triangular mesh
  */
 struct P2trMesh_
 {
   /**
-   * A hash set containing pointers to all the triangles
+   * A dense set containing pointers to all the triangles
    * (\ref P2trTriangle) in the mesh
    */
-  P2trHashSet *triangles;
+  P2trDenseSet *triangles;
 
   /**
-   * A hash set containing pointers to all the edges (\ref P2trEdge) in
-   * the mesh
+   * A dense set containing pointers to all the edges (\ref P2trEdge)
+   * in the mesh
    */
-  P2trHashSet *edges;
+  P2trDenseSet *edges;
 
   /**
-   * A hash set containing pointers to all the points (\ref P2trPoint)
+   * A dense set containing pointers to all the points (\ref P2trPoint)
    * in the mesh
    */
-  P2trHashSet *points;
+  P2trDenseSet *points;
 
   /**
    * A boolean flag specifying whether recording of actions on the
@@ -81,6 +92,21 @@ struct P2trMesh_
    */
   GQueue       undo;
 
+  /**
+   * The bounding boxes (\ref P2trMeshBox) of the triangles that were
+   * added to the mesh, removed from it or changed by moving their
+   * points (before and after the move) since the changes were last
+   * taken, or NULL if changes aren't tracked. See
+   * @ref p2tr_mesh_track_changes
+   */
+  GArray      *changes;
+
+  /**
+   * The pools from which the points, edges and triangles of the mesh
+   * are allocated
+   */
+  P2trPoolSet *pools;
+
   /**
    * Counts the amount of references to the mesh. When this counter
    * reaches zero, the mesh will be freed
@@ -212,6 +238,38 @@ void          p2tr_mesh_on_edge_removed     (P2trMesh *mesh,
 void          p2tr_mesh_on_triangle_removed (P2trMesh     *mesh,
                                              P2trTriangle *triangle);
 
+/** \internal
+ * This function should be called when the shape of a triangle is going
+ * to change, and again after it changed. It is used internally to
+ * update the mesh and it should not be called by any code outside of
+ * this library.
+ * @param mesh The mesh of the triangle
+ * @param triangle The triangle whose shape changes
+*/
+void          p2tr_mesh_on_triangle_changed (P2trMesh     *mesh,
+                                             P2trTriangle *triangle);
+
+/**
+ * Start or stop tracking the areas of the mesh which are changed. This
+ * allows updating data computed from the mesh (like a UVT cache for
+ * rendering) only in the areas that were changed.
+ * @param self The mesh
+ * @param track Whether changes should be tracked. If FALSE, all the
+ *        changes tracked so far are dropped
+ */
+void          p2tr_mesh_track_changes         (P2trMesh *self,
+                                               gboolean  track);
+
+/**
+ * Take the changes tracked on a mesh so far, and start tracking the
+ * next changes from scratch. Note that undoing a group of actions
+ * also counts as a change.
+ * @param self The mesh, which must be tracking changes
+ * @return An array of the bounding boxes (\ref P2trMeshBox) of the
+ *         changed triangles, which should be freed with g_array_free
+ */
+GArray*       p2tr_mesh_take_changes          (P2trMesh *self);
+
 /**
  * Begin recording all action performed on a mesh. Recording the
  * actions performed on a mesh allows choosing later whether to commit
@@ -359,6 +417,15 @@ void          p2tr_mesh_get_bounds        (P2trMesh    *self,
                                            gdouble     *max_x,
                                            gdouble     *max_y);
 
+/**
+ * Estimate the amount of memory used by the mesh - its points, edges,
+ * triangles and the sets containing them. This takes O(1) time, so it
+ * may be called frequently.
+ * @param[in] self The mesh
+ * @return The estimated size of the memory, in bytes
+ */
+gsize         p2tr_mesh_get_memory_size   (P2trMesh    *self);
+
 /**
  * Same as p2tr_mesh_save_to_file, but also opens the file at the
  * specified path to be used as the target file
@@ -396,5 +463,28 @@ P2trMesh*     p2tr_mesh_load_from_file    (FILE     *in);
  */
 P2trMesh*     p2tr_mesh_load              (const gchar *path);
 
+/**
+ * Save a mesh so that it can be restored exactly by
+ * @ref p2tr_mesh_load_checkpoint - unlike an .off export, this keeps
+ * the exact coordinates, the order of the points and the constrained
+ * edges. This is meant for checkpoints of a refinement (see
+ * @ref p2tr_refiner_save_queues), and the format is specific to this
+ * library.
+ * @param[in] self The mesh to save
+ * @param[in] out The file into which the mesh should be written
+ */
+void          p2tr_mesh_save_checkpoint   (P2trMesh *self,
+                                           FILE     *out);
+
+/**
+ * Load a mesh saved by @ref p2tr_mesh_save_checkpoint. Any whitespace
+ * before the saved mesh is skipped, so it may follow other data in the
+ * same file.
+ * @param[in] in The file to load the mesh from
+ * @return The loaded mesh, or NULL if an error occurred while parsing
+ *         the file
+ */
+P2trMesh*     p2tr_mesh_load_checkpoint   (FILE     *in);
+
 /** @} */
 #endif
@@ -0,0 +1,316 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <glib.h>
+#include "rutils.h"
+#include "rmath.h"
+
+#include "point.h"
+#include "edge.h"
+#include "triangle.h"
+#include "metric.h"
+
+void
+p2tr_metric_init_aligned (P2trMetric *self,
+                          gdouble     angle,
+                          gdouble     h_along,
+                          gdouble     h_across)
+{
+  gdouble cs = cos (angle), sn = sin (angle);
+  gdouble l1 = 1 / (h_along * h_along), l2 = 1 / (h_across * h_across);
+
+  /* R * diag(l1, l2) * R^T, where R is the rotation by angle */
+  self->a = cs * cs * l1 + sn * sn * l2;
+  self->b = cs * sn * (l1 - l2);
+  self->c = sn * sn * l1 + cs * cs * l2;
+}
+
+gboolean
+p2tr_metric_is_valid (const P2trMetric *self)
+{
+  return self->a > 0 && self->a * self->c - self->b * self->b > 0;
+}
+
+gdouble
+p2tr_metric_length_sq (const P2trMetric *self,
+                       gdouble           dx,
+                       gdouble           dy)
+{
+  return self->a * dx * dx + 2 * self->b * dx * dy + self->c * dy * dy;
+}
+
+/* The metric is decomposed as M = L^T L with L = [[l11, l12], [0, l22]]
+ * (Cholesky), so that |L v| is the metric length of v */
+#define P2TR_METRIC_CHOLESKY(m,l11,l12,l22) G_STMT_START { \
+    (l11) = sqrt ((m)->a);                                 \
+    (l12) = (m)->b / (l11);                                \
+    (l22) = sqrt ((m)->c - (l12) * (l12));                 \
+  } G_STMT_END
+
+void
+p2tr_metric_to_metric_space (const P2trMetric  *self,
+                             const P2trVector2 *origin,
+                             const P2trVector2 *pt,
+                             P2trVector2       *dest)
+{
+  gdouble l11, l12, l22;
+  gdouble dx = pt->x - origin->x, dy = pt->y - origin->y;
+
+  P2TR_METRIC_CHOLESKY (self, l11, l12, l22);
+  dest->x = l11 * dx + l12 * dy;
+  dest->y = l22 * dy;
+}
+
+void
+p2tr_metric_from_metric_space (const P2trMetric  *self,
+                               const P2trVector2 *origin,
+                               const P2trVector2 *pt,
+                               P2trVector2       *dest)
+{
+  gdouble l11, l12, l22;
+  gdouble dy;
+
+  P2TR_METRIC_CHOLESKY (self, l11, l12, l22);
+  dy = pt->y / l22;
+  dest->x = origin->x + (pt->x - l12 * dy) / l11;
+  dest->y = origin->y + dy;
+}
+
+void
+p2tr_metric_triangle_quality (const P2trMetric *self,
+                              P2trTriangle     *tri,
+                              gdouble          *min_angle,
+                              gdouble          *min_length,
+                              gdouble          *max_length)
+{
+  P2trVector2 q[3];
+  gdouble     min_sq = G_MAXDOUBLE, max_sq = 0, result = G_MAXDOUBLE;
+  gint        i;
+
+  /* Point i of the triangle is the end of edge i, so the angle at it is
+   * enclosed between edges i and i+1 */
+  for (i = 0; i < 3; i++)
+    p2tr_metric_to_metric_space (self, &tri->edges[0]->end->c,
+        &tri->edges[i]->end->c, &q[i]);
+
+  for (i = 0; i < 3; i++)
+    {
+      const P2trVector2 *P = &q[i], *prev = &q[(i + 2) % 3], *next = &q[(i + 1) % 3];
+      gdouble ux = prev->x - P->x, uy = prev->y - P->y;
+      gdouble vx = next->x - P->x, vy = next->y - P->y;
+
+      min_sq = MIN (min_sq, vx * vx + vy * vy);
+      max_sq = MAX (max_sq, vx * vx + vy * vy);
+
+      if (! tri->edges[i]->constrained || ! tri->edges[(i + 1) % 3]->constrained)
+        result = MIN (result, atan2 (ABS (ux * vy - uy * vx), ux * vx + uy * vy));
+    }
+
+  *min_angle = result;
+  *min_length = sqrt (min_sq);
+  *max_length = sqrt (max_sq);
+}
+
+void
+p2tr_metric_triangle_circumcenter (const P2trMetric *self,
+                                   P2trTriangle     *tri,
+                                   P2trVector2      *dest)
+{
+  const P2trVector2 *A = &tri->edges[0]->end->c;
+  P2trVector2 q[3], center;
+
+  q[0].x = q[0].y = 0;
+  p2tr_metric_to_metric_space (self, A, &tri->edges[1]->end->c, &q[1]);
+  p2tr_metric_to_metric_space (self, A, &tri->edges[2]->end->c, &q[2]);
+
+  p2tr_math_triangle_circumcenter (&q[0], &q[1], &q[2], &center, NULL);
+  p2tr_metric_from_metric_space (self, A, &center, dest);
+}
+
+static P2trMetricField*
+p2tr_metric_field_new (P2trMetricFieldType type)
+{
+  P2trMetricField *self = g_slice_new0 (P2trMetricField);
+  self->type = type;
+  self->refcount = 1;
+  return self;
+}
+
+P2trMetricField*
+p2tr_metric_field_new_constant (const P2trMetric *metric)
+{
+  P2trMetricField *self;
+
+  if (! p2tr_metric_is_valid (metric))
+    p2tr_exception_programmatic ("The metric is not positive definite!");
+
+  self = p2tr_metric_field_new (P2TR_METRIC_FIELD_CONSTANT);
+  self->data.constant = *metric;
+  return self;
+}
+
+P2trMetricField*
+p2tr_metric_field_new_grid (gdouble           min_x,
+                            gdouble           min_y,
+                            gdouble           step_x,
+                            gdouble           step_y,
+                            guint             width,
+                            guint             height,
+                            const P2trMetric *samples)
+{
+  P2trMetricField *self;
+  guint i;
+
+  if (width == 0 || height == 0 || step_x <= 0 || step_y <= 0)
+    p2tr_exception_programmatic ("Invalid metric grid dimensions!");
+
+  for (i = 0; i < width * height; i++)
+    if (! p2tr_metric_is_valid (&samples[i]))
+      p2tr_exception_programmatic ("The metric is not positive definite!");
+
+  self = p2tr_metric_field_new (P2TR_METRIC_FIELD_GRID);
+  self->data.grid.min_x = min_x;
+  self->data.grid.min_y = min_y;
+  self->data.grid.step_x = step_x;
+  self->data.grid.step_y = step_y;
+  self->data.grid.width = width;
+  self->data.grid.height = height;
+  self->data.grid.samples = g_new (P2trMetric, width * height);
+  memcpy (self->data.grid.samples, samples, width * height * sizeof (P2trMetric));
+  return self;
+}
+
+P2trMetricField*
+p2tr_metric_field_new_callback (P2trMetricFunc func,
+                                gpointer       user_data)
+{
+  P2trMetricField *self = p2tr_metric_field_new (P2TR_METRIC_FIELD_CALLBACK);
+  self->data.callback.func = func;
+  self->data.callback.user_data = user_data;
+  return self;
+}
+
+P2trMetricField*
+p2tr_metric_field_ref (P2trMetricField *self)
+{
+  ++self->refcount;
+  return self;
+}
+
+void
+p2tr_metric_field_unref (P2trMetricField *self)
+{
+  g_assert (self->refcount > 0);
+  if (--self->refcount == 0)
+    p2tr_metric_field_free (self);
+}
+
+void
+p2tr_metric_field_free (P2trMetricField *self)
+{
+  if (self->type == P2TR_METRIC_FIELD_GRID)
+    g_free (self->data.grid.samples);
+  g_slice_free (P2trMetricField, self);
+}
+
+void
+p2tr_metric_field_eval (P2trMetricField   *self,
+                        const P2trVector2 *pt,
+                        P2trMetric        *dest)
+{
+  switch (self->type)
+    {
+      case P2TR_METRIC_FIELD_CONSTANT:
+        *dest = self->data.constant;
+        break;
+
+      case P2TR_METRIC_FIELD_GRID:
+        {
+          guint   w = self->data.grid.width, h = self->data.grid.height;
+          gdouble fx, fy, tx, ty, w00, w01, w10, w11;
+          guint   x0, y0, x1, y1;
+          const P2trMetric *s = self->data.grid.samples;
+          const P2trMetric *s00, *s01, *s10, *s11;
+
+          fx = CLAMP ((pt->x - self->data.grid.min_x) / self->data.grid.step_x, 0, w - 1);
+          fy = CLAMP ((pt->y - self->data.grid.min_y) / self->data.grid.step_y, 0, h - 1);
+          x0 = (guint) fx;
+          y0 = (guint) fy;
+          x1 = MIN (x0 + 1, w - 1);
+          y1 = MIN (y0 + 1, h - 1);
+          tx = fx - x0;
+          ty = fy - y0;
+
+          s00 = &s[y0 * w + x0]; s01 = &s[y0 * w + x1];
+          s10 = &s[y1 * w + x0]; s11 = &s[y1 * w + x1];
+          w00 = (1 - tx) * (1 - ty); w01 = tx * (1 - ty);
+          w10 = (1 - tx) * ty;       w11 = tx * ty;
+
+          /* A convex combination of positive definite tensors is
+           * positive definite as well */
+          dest->a = w00 * s00->a + w01 * s01->a + w10 * s10->a + w11 * s11->a;
+          dest->b = w00 * s00->b + w01 * s01->b + w10 * s10->b + w11 * s11->b;
+          dest->c = w00 * s00->c + w01 * s01->c + w10 * s10->c + w11 * s11->c;
+        }
+        break;
+
+      case P2TR_METRIC_FIELD_CALLBACK:
+        self->data.callback.func (pt, dest, self->data.callback.user_data);
+        break;
+    }
+}
+
+void
+p2tr_metric_field_eval_triangle (P2trMetricField *self,
+                                 P2trTriangle    *tri,
+                                 P2trMetric      *dest)
+{
+  P2trMetric m;
+  gint i;
+
+  if (self->type == P2TR_METRIC_FIELD_CONSTANT)
+    {
+      *dest = self->data.constant;
+      return;
+    }
+
+  dest->a = dest->b = dest->c = 0;
+  for (i = 0; i < 3; i++)
+    {
+      p2tr_metric_field_eval (self, &tri->edges[i]->end->c, &m);
+      dest->a += m.a / 3;
+      dest->b += m.b / 3;
+      dest->c += m.c / 3;
+    }
+}
@@ -0,0 +1,245 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __P2TC_REFINE_METRIC_H__
+#define __P2TC_REFINE_METRIC_H__
+
+#include <glib.h>
+#include "vector2.h"
+#include "triangulation.h"
+
+/**
+ * \defgroup P2trMetric P2trMetric - Metric Tensor Fields
+ * Symmetric positive definite 2x2 tensors, describing the desired size
+ * and stretching of triangles across the plane for anisotropic
+ * refinement. Lengths and angles are measured in "metric space", where
+ * the length of a vector v is sqrt(v^T M v). A triangle is ideal when
+ * it's equilateral with edges of length 1 in metric space.
+ * @{
+ */
+
+/**
+ * The maximal length of an edge in metric space before the triangle
+ * containing it is refined
+ */
+#define P2TR_METRIC_MAX_EDGE_LENGTH G_SQRT2
+
+/**
+ * The minimal length of an edge in metric space for the angles of the
+ * triangle containing it to be improved. Triangles which are already
+ * that small are left as they are, since the bounds on the angles that
+ * hold in the Euclidean space don't hold in arbitrary metrics, and
+ * trying to improve them could go on forever.
+ */
+#define P2TR_METRIC_MIN_EDGE_LENGTH 0.5
+
+/**
+ * A symmetric positive definite tensor [[a, b], [b, c]]
+ */
+typedef struct
+{
+  gdouble a, b, c;
+} P2trMetric;
+
+/**
+ * Initialize a metric which asks for triangles with an edge length of
+ * h_along in the given direction, and h_across perpendicular to it
+ * @param[out] self The metric to initialize
+ * @param[in] angle The direction, in radians from the X axis
+ * @param[in] h_along The edge length along the direction
+ * @param[in] h_across The edge length across the direction
+ */
+void     p2tr_metric_init_aligned  (P2trMetric        *self,
+                                    gdouble            angle,
+                                    gdouble            h_along,
+                                    gdouble            h_across);
+
+/**
+ * Check whether a tensor is symmetric positive definite
+ */
+gboolean p2tr_metric_is_valid      (const P2trMetric  *self);
+
+/**
+ * Find the squared length of a vector in metric space
+ */
+gdouble  p2tr_metric_length_sq     (const P2trMetric  *self,
+                                    gdouble            dx,
+                                    gdouble            dy);
+
+/**
+ * Transform a point into metric space, relative to an origin point.
+ * Euclidean distances between transformed points are the metric
+ * distances between the original points
+ * @param[in] self The metric
+ * @param[in] origin The point which is mapped to (0, 0)
+ * @param[in] pt The point to transform
+ * @param[out] dest The transformed point
+ */
+void     p2tr_metric_to_metric_space   (const P2trMetric  *self,
+                                        const P2trVector2 *origin,
+                                        const P2trVector2 *pt,
+                                        P2trVector2       *dest);
+
+/**
+ * The inverse of @ref p2tr_metric_to_metric_space
+ */
+void     p2tr_metric_from_metric_space (const P2trMetric  *self,
+                                        const P2trVector2 *origin,
+                                        const P2trVector2 *pt,
+                                        P2trVector2       *dest);
+
+/**
+ * Measure the quality of a triangle in metric space
+ * @param[in] self The metric
+ * @param[in] tri The triangle
+ * @param[out] min_angle The smallest angle of the triangle which is not
+ *             enclosed between two constrained edges (same as
+ *             @ref p2tr_triangle_smallest_non_constrained_angle)
+ * @param[out] min_length The length of the shortest edge
+ * @param[out] max_length The length of the longest edge
+ */
+void     p2tr_metric_triangle_quality  (const P2trMetric  *self,
+                                        P2trTriangle      *tri,
+                                        gdouble           *min_angle,
+                                        gdouble           *min_length,
+                                        gdouble           *max_length);
+
+/**
+ * Find the circumcenter of a triangle in metric space, and return it
+ * in the original space
+ */
+void     p2tr_metric_triangle_circumcenter (const P2trMetric *self,
+                                            P2trTriangle     *tri,
+                                            P2trVector2      *dest);
+
+/**
+ * The types of metric fields
+ */
+typedef enum
+{
+  /** The same metric everywhere */
+  P2TR_METRIC_FIELD_CONSTANT,
+  /** A metric sampled on a regular grid, interpolated bilinearly
+   *  between the samples */
+  P2TR_METRIC_FIELD_GRID,
+  /** A metric computed by a \ref P2trMetricFunc */
+  P2TR_METRIC_FIELD_CALLBACK
+} P2trMetricFieldType;
+
+/**
+ * A function computing the metric at a point
+ * @param[in] pt The point
+ * @param[out] dest The metric at the point. Must be symmetric positive
+ *             definite
+ * @param[in] user_data The data given when the field was created
+ */
+typedef void (*P2trMetricFunc) (const P2trVector2 *pt,
+                                P2trMetric        *dest,
+                                gpointer           user_data);
+
+/**
+ * A struct for a field of metrics across the plane
+ */
+typedef struct
+{
+  P2trMetricFieldType type;
+
+  guint refcount;
+
+  union
+  {
+    P2trMetric constant;
+
+    struct
+    {
+      gdouble     min_x, min_y;
+      gdouble     step_x, step_y;
+      guint       width, height;
+      /** The samples, in row major order */
+      P2trMetric *samples;
+    } grid;
+
+    struct
+    {
+      P2trMetricFunc func;
+      gpointer       user_data;
+    } callback;
+  } data;
+} P2trMetricField;
+
+P2trMetricField* p2tr_metric_field_new_constant (const P2trMetric *metric);
+
+/**
+ * Create a metric field sampled on a regular grid. Outside of the
+ * grid, the nearest samples are used
+ * @param min_x The X coordinate of the first column of samples
+ * @param min_y The Y coordinate of the first row of samples
+ * @param step_x The distance between columns of samples
+ * @param step_y The distance between rows of samples
+ * @param width The amount of columns of samples
+ * @param height The amount of rows of samples
+ * @param samples The samples, in row major order. They are copied
+ */
+P2trMetricField* p2tr_metric_field_new_grid     (gdouble           min_x,
+                                                 gdouble           min_y,
+                                                 gdouble           step_x,
+                                                 gdouble           step_y,
+                                                 guint             width,
+                                                 guint             height,
+                                                 const P2trMetric *samples);
+
+P2trMetricField* p2tr_metric_field_new_callback (P2trMetricFunc    func,
+                                                 gpointer          user_data);
+
+P2trMetricField* p2tr_metric_field_ref          (P2trMetricField  *self);
+
+void             p2tr_metric_field_unref        (P2trMetricField  *self);
+
+void             p2tr_metric_field_free         (P2trMetricField  *self);
+
+/**
+ * Find the metric at a point
+ */
+void             p2tr_metric_field_eval         (P2trMetricField   *self,
+                                                 const P2trVector2 *pt,
+                                                 P2trMetric        *dest);
+
+/**
+ * Find the metric used for measuring a triangle - the average of the
+ * metrics at its three points
+ */
+void             p2tr_metric_field_eval_triangle (P2trMetricField  *self,
+                                                  P2trTriangle     *tri,
+                                                  P2trMetric       *dest);
+
+/** @} */
+#endif
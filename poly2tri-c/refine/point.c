@@ -30,10 +30,14 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <math.h>
 #include <glib.h>
+#include "pool.h"
 #include "point.h"
 #include "edge.h"
+#include "triangle.h"
 #include "mesh.h"
+#include "cluster.h"
 
 P2trPoint*
 p2tr_point_new (const P2trVector2 *c)
@@ -44,13 +48,24 @@ p2tr_point_new (const P2trVector2 *c)
 P2trPoint*
 p2tr_point_new2 (gdouble x, gdouble y)
 {
-  P2trPoint *self = g_slice_new (P2trPoint);
-  
+  return p2tr_point_new_from_pools (NULL, x, y);
+}
+
+P2trPoint*
+p2tr_point_new_from_pools (P2trPoolSet *pools,
+                           gdouble      x,
+                           gdouble      y)
+{
+  P2trPoint *self = p2tr_pool_new (P2trPoint, P2TR_POOL_POINT, pools);
+
+  self->pools = pools;
   self->c.x = x;
   self->c.y = y;
   self->mesh = NULL;
   self->outgoing_edges = NULL;
   self->refcount = 1;
+  self->handle = P2TR_HANDLE_NONE;
+  self->clusters = NULL;
 
   return self;
 }
@@ -68,11 +83,72 @@ p2tr_point_remove (P2trPoint *self)
     p2tr_mesh_on_point_removed (self->mesh, self);
 }
 
+static gint
+p2tr_point_edge_angle_compare (gconstpointer a,
+                               gconstpointer b)
+{
+  gdouble angle_a = ((const P2trEdge*) a)->angle;
+  gdouble angle_b = ((const P2trEdge*) b)->angle;
+
+  return (angle_a < angle_b) ? -1 : ((angle_a > angle_b) ? 1 : 0);
+}
+
+void
+p2tr_point_move (P2trPoint         *self,
+                 const P2trVector2 *c)
+{
+  GList *iter;
+
+  if (self->mesh != NULL && self->mesh->record_undo)
+    p2tr_exception_programmatic ("Can't move a point while recording "
+        "actions on its mesh!");
+
+  /* Each triangle around the point has exactly one edge going out of
+   * it, so this marks the area of each triangle before the move */
+  if (self->mesh != NULL && self->mesh->changes != NULL)
+    for (iter = self->outgoing_edges; iter != NULL; iter = iter->next)
+      if (((P2trEdge*) iter->data)->tri != NULL)
+        p2tr_mesh_on_triangle_changed (self->mesh, ((P2trEdge*) iter->data)->tri);
+
+  self->c.x = c->x;
+  self->c.y = c->y;
+
+  for (iter = self->outgoing_edges; iter != NULL; iter = iter->next)
+    {
+      P2trEdge  *e = (P2trEdge*) iter->data;
+      P2trPoint *end = e->end;
+
+      e->angle         = atan2 (end->c.y - c->y, end->c.x - c->x);
+      e->mirror->angle = atan2 (c->y - end->c.y, c->x - end->c.x);
+
+      /* The cyclic order of the edges around the other point doesn't
+       * change, but the edge may still wrap around from +PI to -PI */
+      end->outgoing_edges = g_list_sort (end->outgoing_edges,
+          p2tr_point_edge_angle_compare);
+
+      if (e->tri != NULL)
+        {
+          p2tr_triangle_invalidate_quality (e->tri);
+          if (self->mesh != NULL)
+            p2tr_mesh_on_triangle_changed (self->mesh, e->tri);
+        }
+
+      if (e->constrained)
+        {
+          p2tr_cluster_invalidate_cache (self);
+          p2tr_cluster_invalidate_cache (end);
+        }
+    }
+
+  self->outgoing_edges = g_list_sort (self->outgoing_edges,
+      p2tr_point_edge_angle_compare);
+}
+
 void
 p2tr_point_free (P2trPoint *self)
 {
   p2tr_point_remove (self);
-  g_slice_free (P2trPoint, self);
+  p2tr_pool_delete (P2trPoint, P2TR_POOL_POINT, self->pools, self);
 }
 
 P2trEdge*
@@ -115,6 +191,9 @@ _p2tr_point_insert_edge (P2trPoint *self, P2trEdge *e)
   self->outgoing_edges =
       g_list_insert_before (self->outgoing_edges, iter, e);
 
+  if (e->constrained)
+    p2tr_cluster_invalidate_cache (self);
+
   p2tr_edge_ref (e);
 }
 
@@ -134,6 +213,9 @@ _p2tr_point_remove_edge (P2trPoint *self, P2trEdge* e)
 
   self->outgoing_edges = g_list_delete_link (self->outgoing_edges, node);
 
+  if (e->constrained)
+    p2tr_cluster_invalidate_cache (self);
+
   p2tr_edge_unref (e);
 }
 
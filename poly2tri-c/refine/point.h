@@ -36,6 +36,8 @@
 #include <glib.h>
 #include "vector2.h"
 #include "triangulation.h"
+#include "dense-set.h"
+#include "pool.h"
 
 /**
  * @struct P2trPoint_
@@ -57,12 +59,39 @@ struct P2trPoint_
   
   /** The triangular mesh containing this point */
   P2trMesh    *mesh;
+
+  /**
+   * The handle of this point inside the set of points of its mesh, or
+   * @ref P2TR_HANDLE_NONE if it's not a part of any mesh
+   */
+  P2trHandle   handle;
+
+  /**
+   * A cache of the clusters (@ref P2trCluster) of constrained edges
+   * around this point, or NULL if it wasn't computed yet. It's dropped
+   * whenever a constrained edge is added or removed at this point
+   */
+  GSList      *clusters;
+
+  /**
+   * The pools from which the point was allocated, or NULL if it was
+   * allocated with g_slice
+   */
+  P2trPoolSet *pools;
 };
 
 P2trPoint*  p2tr_point_new                  (const P2trVector2 *c);
 
 P2trPoint*  p2tr_point_new2                 (gdouble x, gdouble y);
 
+/**
+ * Like @ref p2tr_point_new2, but allocate the point from a set of
+ * pools (usually the pools of the mesh it will be added to)
+ */
+P2trPoint*  p2tr_point_new_from_pools       (P2trPoolSet *pools,
+                                             gdouble      x,
+                                             gdouble      y);
+
 P2trPoint*  p2tr_point_ref                  (P2trPoint *self);
 
 void        p2tr_point_unref                (P2trPoint *self);
@@ -71,6 +100,18 @@ void        p2tr_point_free                 (P2trPoint *self);
 
 void        p2tr_point_remove               (P2trPoint *self);
 
+/**
+ * Move a point to a new position, and update everything that is cached
+ * about the edges and the triangles around it. The caller must make
+ * sure that none of the triangles around the point is inverted by the
+ * move, and that the mesh is not recording actions (since moves can't
+ * be undone)
+ * @param self The point to move
+ * @param c The new position of the point
+ */
+void        p2tr_point_move                 (P2trPoint         *self,
+                                             const P2trVector2 *c);
+
 P2trEdge*   p2tr_point_has_edge_to          (P2trPoint *start,
                                              P2trPoint *end);
 
@@ -0,0 +1,211 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <glib.h>
+#include "pool.h"
+
+/* The first bytes of each chunk hold the link to the next chunk. Keep
+ * them large enough so that the elements after them remain aligned */
+#define P2TR_POOL_ALIGN        (2 * sizeof (gdouble))
+#define P2TR_POOL_ROUND_UP(s)  (((s) + P2TR_POOL_ALIGN - 1) & ~(P2TR_POOL_ALIGN - 1))
+#define P2TR_POOL_CHUNK_HEADER P2TR_POOL_ROUND_UP (sizeof (gpointer))
+
+/* The amount of elements in each chunk of the pools of a mesh */
+#define P2TR_POOL_SET_CHUNK_ELEMS 1024
+
+void
+p2tr_pool_init (P2trPool *self,
+                gsize     elem_size,
+                guint     chunk_elems)
+{
+  self->elem_size   = P2TR_POOL_ROUND_UP (MAX (elem_size, sizeof (gpointer)));
+  self->chunk_elems = chunk_elems;
+  self->free_list   = NULL;
+  self->bump        = NULL;
+  self->bump_end    = NULL;
+  self->chunks      = NULL;
+  self->live        = 0;
+}
+
+gpointer
+p2tr_pool_alloc (P2trPool *self)
+{
+  gpointer result;
+
+  if (self->free_list != NULL)
+    {
+      result = self->free_list;
+      self->free_list = *(gpointer*) result;
+    }
+  else
+    {
+      if (self->bump == self->bump_end)
+        {
+          guint8 *chunk = (guint8*) g_malloc (P2TR_POOL_CHUNK_HEADER
+              + self->elem_size * self->chunk_elems);
+
+          *(gpointer*) chunk = self->chunks;
+          self->chunks = chunk;
+
+          self->bump = chunk + P2TR_POOL_CHUNK_HEADER;
+          self->bump_end = self->bump + self->elem_size * self->chunk_elems;
+        }
+
+      result = self->bump;
+      self->bump += self->elem_size;
+    }
+
+  ++self->live;
+  return result;
+}
+
+void
+p2tr_pool_free (P2trPool *self,
+                gpointer  mem)
+{
+  g_assert (self->live > 0);
+
+  *(gpointer*) mem = self->free_list;
+  self->free_list = mem;
+
+  --self->live;
+}
+
+void
+p2tr_pool_clear (P2trPool *self)
+{
+  gpointer chunk = self->chunks;
+
+  while (chunk != NULL)
+    {
+      gpointer next = *(gpointer*) chunk;
+      g_free (chunk);
+      chunk = next;
+    }
+
+  self->free_list = NULL;
+  self->bump      = NULL;
+  self->bump_end  = NULL;
+  self->chunks    = NULL;
+  self->live      = 0;
+}
+
+gboolean
+p2tr_pool_trim (P2trPool *self)
+{
+  if (self->live != 0)
+    return FALSE;
+
+  p2tr_pool_clear (self);
+  return TRUE;
+}
+
+P2trPoolSet*
+p2tr_pool_set_new (void)
+{
+  P2trPoolSet *self = g_slice_new (P2trPoolSet);
+  gint         i;
+
+  /* The element size is only known on the first allocation */
+  for (i = 0; i < P2TR_POOL_KIND_COUNT; i++)
+    p2tr_pool_init (&self->pools[i], 0, P2TR_POOL_SET_CHUNK_ELEMS);
+
+  self->released = FALSE;
+
+  return self;
+}
+
+/**
+ * Free the set if it was released and all its pools are empty
+ */
+static void
+p2tr_pool_set_try_free (P2trPoolSet *self)
+{
+  gint i;
+
+  for (i = 0; i < P2TR_POOL_KIND_COUNT; i++)
+    if (self->pools[i].live != 0)
+      return;
+
+  for (i = 0; i < P2TR_POOL_KIND_COUNT; i++)
+    p2tr_pool_clear (&self->pools[i]);
+
+  g_slice_free (P2trPoolSet, self);
+}
+
+gpointer
+p2tr_pool_set_alloc (P2trPoolSet  *self,
+                     P2trPoolKind  kind,
+                     gsize         elem_size)
+{
+  P2trPool *pool;
+
+  if (self == NULL)
+    return g_slice_alloc (elem_size);
+
+  g_assert (! self->released);
+
+  pool = &self->pools[kind];
+  if (G_UNLIKELY (pool->chunks == NULL))
+    p2tr_pool_init (pool, elem_size, P2TR_POOL_SET_CHUNK_ELEMS);
+  else
+    g_assert (pool->elem_size == P2TR_POOL_ROUND_UP (MAX (elem_size, sizeof (gpointer))));
+
+  return p2tr_pool_alloc (pool);
+}
+
+void
+p2tr_pool_set_free (P2trPoolSet  *self,
+                    P2trPoolKind  kind,
+                    gsize         elem_size,
+                    gpointer      mem)
+{
+  if (self == NULL)
+    {
+      g_slice_free1 (elem_size, mem);
+      return;
+    }
+
+  p2tr_pool_free (&self->pools[kind], mem);
+
+  if (self->released && self->pools[kind].live == 0)
+    p2tr_pool_set_try_free (self);
+}
+
+void
+p2tr_pool_set_release (P2trPoolSet *self)
+{
+  g_assert (! self->released);
+
+  self->released = TRUE;
+  p2tr_pool_set_try_free (self);
+}
@@ -0,0 +1,176 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __P2TC_REFINE_POOL_H__
+#define __P2TC_REFINE_POOL_H__
+
+#include <glib.h>
+
+/**
+ * \defgroup P2trPool P2trPool - Typed Memory Pools
+ * Fixed size allocators for the objects which are created and
+ * destroyed in huge amounts during the refinement (points, edges,
+ * triangles and their virtual counterparts).
+ *
+ * Each mesh owns a set of pools (@ref P2trPoolSet), from which its
+ * points, edges and triangles, and the virtual edges and triangles made
+ * of its points, are allocated. Each object remembers the set it was
+ * allocated from, so it can be freed on any thread and even after its
+ * mesh was freed. Objects made without a mesh are allocated with
+ * g_slice. Like the reference counts of the mesh objects, the pools
+ * are not thread safe, so a mesh and all of its objects must be used
+ * from one thread at a time.
+ * @{
+ */
+
+/**
+ * The kinds of objects which have a dedicated pool
+ */
+typedef enum
+{
+  P2TR_POOL_POINT = 0,
+  P2TR_POOL_EDGE,
+  P2TR_POOL_TRIANGLE,
+  P2TR_POOL_VEDGE,
+  P2TR_POOL_VTRIANGLE,
+  /** The amount of pool kinds - not a real kind */
+  P2TR_POOL_KIND_COUNT
+} P2trPoolKind;
+
+/**
+ * A pool of memory blocks of one fixed size
+ */
+typedef struct
+{
+  /** The size of each element, rounded up for alignment */
+  gsize     elem_size;
+
+  /** The amount of elements in each chunk */
+  guint     chunk_elems;
+
+  /** A linked list of the freed elements, ready for reuse */
+  gpointer  free_list;
+
+  /** The next never-used element inside the newest chunk */
+  guint8   *bump;
+
+  /** The end of the newest chunk */
+  guint8   *bump_end;
+
+  /** A linked list of all the chunks allocated by this pool */
+  gpointer  chunks;
+
+  /** The amount of elements which are currently allocated */
+  guint     live;
+} P2trPool;
+
+void      p2tr_pool_init          (P2trPool     *self,
+                                   gsize         elem_size,
+                                   guint         chunk_elems);
+
+gpointer  p2tr_pool_alloc         (P2trPool     *self);
+
+void      p2tr_pool_free          (P2trPool     *self,
+                                   gpointer      mem);
+
+/**
+ * Release all the memory of a pool at once, regardless of whether
+ * there are still allocated elements in it
+ */
+void      p2tr_pool_clear         (P2trPool     *self);
+
+/**
+ * Release all the memory of a pool at once, but only if none of its
+ * elements is currently allocated
+ * @return TRUE if the memory was released, FALSE otherwise
+ */
+gboolean  p2tr_pool_trim          (P2trPool     *self);
+
+/**
+ * The pools of all the kinds of objects of one mesh
+ */
+typedef struct
+{
+  P2trPool  pools[P2TR_POOL_KIND_COUNT];
+
+  /**
+   * Whether the owner of the set (its mesh) released it. The set is
+   * freed once it's released and all of its elements are freed
+   */
+  gboolean  released;
+} P2trPoolSet;
+
+P2trPoolSet* p2tr_pool_set_new     (void);
+
+/**
+ * Allocate an element from the pool of the given kind in a set
+ * @param self The set of pools, or NULL to allocate with g_slice
+ * @param kind The kind of the pool
+ * @param elem_size The size of the element. Must be the same for all
+ *        the allocations of the same kind
+ */
+gpointer     p2tr_pool_set_alloc   (P2trPoolSet  *self,
+                                    P2trPoolKind  kind,
+                                    gsize         elem_size);
+
+/**
+ * Return an element to the set of pools from which it was allocated
+ * (or to g_slice, if the set is NULL). If this was the last element of
+ * a released set, the set is freed
+ */
+void         p2tr_pool_set_free    (P2trPoolSet  *self,
+                                    P2trPoolKind  kind,
+                                    gsize         elem_size,
+                                    gpointer      mem);
+
+/**
+ * Release a set of pools by its owner. If none of its elements is
+ * still allocated, all the memory is freed at once. Otherwise, the set
+ * is freed together with its last element
+ */
+void         p2tr_pool_set_release (P2trPoolSet  *self);
+
+/**
+ * Allocate an object of the given type from the pool of the given kind
+ * in a set (or with g_slice, if the set is NULL)
+ */
+#define p2tr_pool_new(type,kind,set) \
+  ((type*) p2tr_pool_set_alloc ((set), (kind), sizeof (type)))
+
+/**
+ * Free an object which was allocated using @ref p2tr_pool_new
+ */
+#define p2tr_pool_delete(type,kind,set,mem) \
+  p2tr_pool_set_free ((set), (kind), sizeof (type), (mem))
+
+/** @} */
+#endif
@@ -36,6 +36,8 @@
 #include "point.h"
 #include "edge.h"
 #include "triangle.h"
+#include "vtriangle.h"
+#include "mesh-action.h"
 
 #include "rcdt.h"
 #include "visibility.h"
@@ -48,6 +50,9 @@ static gboolean  p2tr_cdt_visible_from_tri        (P2trCDT      *self,
 static gboolean  p2tr_cdt_has_empty_circum_circle (P2trCDT      *self,
                                                    P2trTriangle *tri);
 
+static P2trPoint**  p2tr_cdt_triangulate_hole        (P2trPoint *pt,
+                                                     guint     *count);
+
 static P2trHashSet* p2tr_cdt_triangulate_fan         (P2trCDT   *self,
                                                       P2trPoint *center,
                                                       GList     *edge_pts);
@@ -57,17 +62,17 @@ p2tr_cdt_validate_unused (P2trCDT* self)
 {
   P2trEdge *ed;
   P2trTriangle *tri;
-  P2trHashSetIter iter;
+  P2trDenseSetIter iter;
 
-  p2tr_hash_set_iter_init (&iter, self->mesh->edges);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*)&ed))
+  p2tr_dense_set_iter_init (&iter, self->mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&ed))
     {
       g_assert (ed->mirror != NULL);
       g_assert (! p2tr_edge_is_removed (ed));
     }
 
-  p2tr_hash_set_iter_init (&iter, self->mesh->triangles);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*)&tri))
+  p2tr_dense_set_iter_init (&iter, self->mesh->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&tri))
     g_assert (! p2tr_triangle_is_removed (tri));
 }
 
@@ -86,6 +91,7 @@ p2tr_cdt_new (P2tCDT *cdt)
 
   rmesh->mesh = p2tr_mesh_new ();
   rmesh->outline = p2tr_pslg_new ();
+  rmesh->metric = NULL;
 
   /* First iteration over the CDT - create all the points */
   for (i = 0; i < cdt_tris->len; i++)
@@ -170,6 +176,28 @@ p2tr_cdt_new (P2tCDT *cdt)
   return rmesh;
 }
 
+P2trCDT*
+p2tr_cdt_new_from_mesh (P2trMesh *mesh)
+{
+  P2trCDT *rmesh = g_slice_new (P2trCDT);
+  P2trDenseSetIter iter;
+  P2trEdge *e;
+
+  rmesh->mesh = p2tr_mesh_ref (mesh);
+  rmesh->outline = p2tr_pslg_new ();
+  rmesh->metric = NULL;
+
+  /* The outline is made of the constrained edges. Each one is in the
+   * set twice (once for each direction) but should be added once */
+  p2tr_dense_set_iter_init (&iter, mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&e))
+    if (e->constrained && e->handle < e->mirror->handle)
+      p2tr_pslg_add_new_line (rmesh->outline, &P2TR_EDGE_START (e)->c,
+          &e->end->c);
+
+  return rmesh;
+}
+
 void
 p2tr_cdt_free (P2trCDT *self)
 {
@@ -180,6 +208,8 @@ void
 p2tr_cdt_free_full (P2trCDT* self, gboolean clear_mesh)
 {
   p2tr_pslg_free (self->outline);
+  if (self->metric != NULL)
+    p2tr_metric_field_unref (self->metric);
   if (clear_mesh)
     p2tr_mesh_clear (self->mesh);
   p2tr_mesh_unref (self->mesh);
@@ -187,14 +217,80 @@ p2tr_cdt_free_full (P2trCDT* self, gboolean clear_mesh)
   g_slice_free (P2trCDT, self);
 }
 
+void
+p2tr_cdt_set_metric_field (P2trCDT         *self,
+                           P2trMetricField *metric)
+{
+  P2trVEdgeSet     *candidates;
+  P2trDenseSetIter  iter;
+  P2trEdge         *e;
+
+  if (metric != NULL)
+    p2tr_metric_field_ref (metric);
+  if (self->metric != NULL)
+    p2tr_metric_field_unref (self->metric);
+  self->metric = metric;
+
+  candidates = p2tr_vedge_set_new ();
+  p2tr_dense_set_iter_init (&iter, self->mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&e))
+    if (! e->constrained && e->handle < e->mirror->handle)
+      p2tr_vedge_set_add (candidates, p2tr_edge_ref (e));
+
+  p2tr_cdt_flip_fix (self, candidates);
+  p2tr_vedge_set_free (candidates);
+}
+
+P2trInCircle
+p2tr_cdt_circumcircle_contains_point (P2trCDT      *self,
+                                      P2trTriangle *tri,
+                                      P2trPoint    *pt)
+{
+  P2trPoint  *A, *B, *C;
+  P2trMetric  m, mi;
+  P2trVector2 a, b, c, d;
+  gint        i;
+
+  if (self->metric == NULL)
+    return p2tr_triangle_circumcircle_contains_point (tri, &pt->c);
+
+  A = P2TR_TRIANGLE_GET_POINT (tri, 0);
+  B = P2TR_TRIANGLE_GET_POINT (tri, 1);
+  C = P2TR_TRIANGLE_GET_POINT (tri, 2);
+
+  /* Average the metric over all four points, so that the test gives
+   * the same answer for both triangulations of a quadrilateral */
+  p2tr_metric_field_eval (self->metric, &pt->c, &m);
+  for (i = 0; i < 3; i++)
+    {
+      p2tr_metric_field_eval (self->metric, &tri->edges[i]->end->c, &mi);
+      m.a += mi.a;
+      m.b += mi.b;
+      m.c += mi.c;
+    }
+  m.a /= 4;
+  m.b /= 4;
+  m.c /= 4;
+
+  /* The transformation into metric space preserves the orientation, so
+   * the points are still in the same order as in
+   * p2tr_triangle_circumcircle_contains_point */
+  p2tr_metric_to_metric_space (&m, &A->c, &A->c, &a);
+  p2tr_metric_to_metric_space (&m, &A->c, &B->c, &b);
+  p2tr_metric_to_metric_space (&m, &A->c, &C->c, &c);
+  p2tr_metric_to_metric_space (&m, &A->c, &pt->c, &d);
+
+  return p2tr_math_incircle (&c, &b, &a, &d);
+}
+
 void
 p2tr_cdt_validate_edges (P2trCDT *self)
 {
-  P2trHashSetIter iter;
+  P2trDenseSetIter iter;
   P2trEdge *e;
 
-  p2tr_hash_set_iter_init (&iter, self->mesh->edges);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*)&e))
+  p2tr_dense_set_iter_init (&iter, self->mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&e))
     {
       if (! e->constrained && e->tri == NULL)
         p2tr_exception_geometric ("Found a non constrained edge without a triangle");
@@ -249,14 +345,15 @@ static gboolean
 p2tr_cdt_has_empty_circum_circle (P2trCDT      *self,
                                   P2trTriangle *tri)
 {
-  P2trCircle circum;
+  P2trVector2 center;
+  gdouble radius_sq;
   P2trPoint *p;
-  P2trHashSetIter iter;
+  P2trDenseSetIter iter;
 
-  p2tr_triangle_get_circum_circle (tri, &circum);
+  p2tr_triangle_get_circum_center (tri, &center, &radius_sq);
 
-  p2tr_hash_set_iter_init (&iter, self->mesh->points);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*)&p))
+  p2tr_dense_set_iter_init (&iter, self->mesh->points);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&p))
     {
       /** TODO: FIXME - is a point on a constrained edge really not a
        * problem?! */
@@ -268,7 +365,7 @@ p2tr_cdt_has_empty_circum_circle (P2trCDT      *self,
           || p == tri->edges[2]->end)
           continue;
 
-      if (! p2tr_circle_test_point_outside(&circum, &p->c)
+      if (P2TR_VECTOR2_DISTANCE_SQ (&center, &p->c) <= radius_sq
           && p2tr_cdt_visible_from_tri (self, tri, &p->c))
           return FALSE;
     }
@@ -278,15 +375,67 @@ p2tr_cdt_has_empty_circum_circle (P2trCDT      *self,
 void
 p2tr_cdt_validate_cdt (P2trCDT *self)
 {
-  P2trHashSetIter iter;
+  P2trDenseSetIter iter;
   P2trTriangle *tri;
 
-  p2tr_hash_set_iter_init (&iter, self->mesh->triangles);
-  while (p2tr_hash_set_iter_next (&iter, (gpointer*)&tri))
+  p2tr_dense_set_iter_init (&iter, self->mesh->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&tri))
     if (! p2tr_cdt_has_empty_circum_circle(self, tri))
       p2tr_exception_geometric ("Not a CDT!");
 }
 
+static gboolean
+p2tr_cdt_edge_is_locally_delaunay (P2trCDT *self, P2trEdge *e)
+{
+  P2trPoint *D;
+
+  /* Constrained edges and edges on the boundary of the domain are not
+   * required to satisfy the delaunay property */
+  if (e->constrained || e->tri == NULL || e->mirror->tri == NULL)
+    return TRUE;
+
+  D = p2tr_triangle_get_opposite_point (e->mirror->tri, e->mirror, FALSE);
+  return p2tr_cdt_circumcircle_contains_point (self, e->tri, D) != P2TR_INCIRCLE_IN;
+}
+
+void
+p2tr_cdt_validate_cdt_local (P2trCDT *self)
+{
+  P2trDenseSetIter iter;
+  P2trEdge *e;
+
+  p2tr_dense_set_iter_init (&iter, self->mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&e))
+    if (! p2tr_cdt_edge_is_locally_delaunay (self, e))
+      p2tr_exception_geometric ("Not a CDT!");
+}
+
+void
+p2tr_cdt_validate_action_group (P2trCDT *self)
+{
+  GList *iter;
+
+  g_assert (self->mesh->record_undo);
+
+  for (iter = self->mesh->undo.head; iter != NULL; iter = iter->next)
+    {
+      P2trMeshAction *action = (P2trMeshAction*) iter->data;
+      P2trTriangle   *tri;
+      gint            i;
+
+      if (action->type != P2TR_MESH_ACTION_TRIANGLE || ! action->added)
+        continue;
+
+      /* The triangle may have been removed later in the same group */
+      if ((tri = p2tr_vtriangle_is_real (action->action.action_tri.vtri)) == NULL)
+        continue;
+
+      for (i = 0; i < 3; i++)
+        if (! p2tr_cdt_edge_is_locally_delaunay (self, tri->edges[i]))
+          p2tr_exception_geometric ("Not a CDT!");
+    }
+}
+
 P2trPoint*
 p2tr_cdt_insert_point (P2trCDT           *self,
                        const P2trVector2 *pc,
@@ -313,7 +462,7 @@ p2tr_cdt_insert_point (P2trCDT           *self,
   for (i = 0; i < 3; i++)
     {
       P2trEdge *edge = tri->edges[i];
-      if (p2tr_math_orient2d (& P2TR_EDGE_START(edge)->c,
+      if (p2tr_math_orient2d_approx (& P2TR_EDGE_START(edge)->c,
               &edge->end->c, pc) == P2TR_ORIENTATION_LINEAR)
         {
           GList *parts = p2tr_cdt_split_edge (self, edge, pt), *eIter;
@@ -491,3 +640,142 @@ p2tr_cdt_split_edge (P2trCDT   *self,
   return new_edges;
 }
 
+gboolean
+p2tr_cdt_point_is_removable (P2trCDT   *self,
+                             P2trPoint *pt)
+{
+  return pt->mesh == self->mesh
+      && p2tr_point_is_fully_in_domain (pt)
+      && ! p2tr_point_has_constrained_edge (pt);
+}
+
+/**
+ * Triangulate the polygon formed by the neighbors of a point, as if the
+ * point was removed. Since the triangulation is delaunay, only the
+ * triangles around the point would change if it was removed, and the
+ * new triangles are usually the delaunay triangulation of that
+ * polygon. It's found by repeatedly cutting off "ears" of the polygon
+ * whose circum-circle doesn't contain any other point of the polygon.
+ * Returns the points of the triangles as described in
+ * @ref p2tr_cdt_predict_point_removal
+ */
+static P2trPoint**
+p2tr_cdt_triangulate_hole (P2trPoint *pt,
+                           guint     *count)
+{
+  P2trPoint **poly, **result;
+  GList      *iter;
+  guint       n, i, j, k, ear, pass;
+
+  /* The outgoing edges are sorted counter-clockwise, and since the
+   * point is surrounded by triangles, their ends form the polygon */
+  n = g_list_length (pt->outgoing_edges);
+  poly = g_new (P2trPoint*, n);
+  for (iter = pt->outgoing_edges, i = 0; iter != NULL; iter = iter->next, i++)
+    poly[i] = ((P2trEdge*) iter->data)->end;
+
+  *count = n - 2;
+  result = g_new (P2trPoint*, 3 * (n - 2));
+
+  for (k = 0; n > 3; k++)
+    {
+      ear = n;
+
+      /* Prefer ears with an empty circum-circle, but if there is none
+       * (which can happen near segments, or in a metric other than the
+       * euclidean one) settle for any ear and let the flips fix it */
+      for (pass = 0; pass < 2 && ear == n; pass++)
+        for (i = 0; i < n && ear == n; i++)
+          {
+            const P2trVector2 *A = &poly[(i + n - 1) % n]->c;
+            const P2trVector2 *B = &poly[i]->c;
+            const P2trVector2 *C = &poly[(i + 1) % n]->c;
+
+            if (p2tr_math_orient2d (A, B, C) != P2TR_ORIENTATION_CCW)
+              continue;
+
+            for (j = (i + 2) % n; j != (i + n - 1) % n; j = (j + 1) % n)
+              if (pass == 0
+                  ? p2tr_math_incircle (A, B, C, &poly[j]->c) == P2TR_INCIRCLE_IN
+                  : p2tr_math_intriangle (A, B, C, &poly[j]->c) != P2TR_INTRIANGLE_OUT)
+                break;
+
+            if (j == (i + n - 1) % n)
+              ear = i;
+          }
+
+      /* Every simple polygon has an ear */
+      if (ear == n)
+        p2tr_exception_geometric ("No ear found while removing a point!");
+
+      result[3 * k]     = poly[(ear + n - 1) % n];
+      result[3 * k + 1] = poly[ear];
+      result[3 * k + 2] = poly[(ear + 1) % n];
+
+      for (i = ear; i + 1 < n; i++)
+        poly[i] = poly[i + 1];
+      n--;
+    }
+
+  result[3 * k]     = poly[0];
+  result[3 * k + 1] = poly[1];
+  result[3 * k + 2] = poly[2];
+
+  g_free (poly);
+  return result;
+}
+
+P2trPoint**
+p2tr_cdt_predict_point_removal (P2trCDT   *self,
+                                P2trPoint *pt,
+                                guint     *count)
+{
+  if (! p2tr_cdt_point_is_removable (self, pt))
+    p2tr_exception_programmatic ("Only points inside the domain which "
+        "are not on any segment can be removed!");
+
+  return p2tr_cdt_triangulate_hole (pt, count);
+}
+
+void
+p2tr_cdt_remove_point (P2trCDT   *self,
+                       P2trPoint *pt)
+{
+  P2trVEdgeSet  *flip_candidates;
+  P2trPoint    **tris;
+  guint          count, i, j;
+
+  P2TR_CDT_VALIDATE_UNUSED (self);
+
+  tris = p2tr_cdt_predict_point_removal (self, pt, &count);
+
+  /* The points of the hole are kept alive by their other edges */
+  p2tr_point_remove (pt);
+
+  flip_candidates = p2tr_vedge_set_new ();
+  for (i = 0; i < count; i++)
+    {
+      P2trEdge *edges[3];
+
+      for (j = 0; j < 3; j++)
+        edges[j] = p2tr_mesh_new_or_existing_edge (self->mesh,
+            tris[3 * i + j], tris[3 * i + (j + 1) % 3], FALSE);
+
+      p2tr_triangle_unref (p2tr_mesh_new_triangle (self->mesh,
+            edges[0], edges[1], edges[2]));
+
+      /* In the euclidean metric the new triangles are already delaunay,
+       * but in other metrics some edges may need to be flipped */
+      for (j = 0; j < 3; j++)
+        if (edges[j]->constrained)
+          p2tr_edge_unref (edges[j]);
+        else
+          p2tr_vedge_set_add (flip_candidates, edges[j]);
+    }
+
+  p2tr_cdt_flip_fix (self, flip_candidates);
+  p2tr_vedge_set_free (flip_candidates);
+  g_free (tris);
+
+  P2TR_CDT_VALIDATE_UNUSED (self);
+}
@@ -35,12 +35,19 @@
 
 #include <poly2tri-c/p2t/poly2tri.h>
 #include "mesh.h"
+#include "metric.h"
 #include "pslg.h"
+#include "rmath.h"
 
 typedef struct
 {
   P2trMesh *mesh;
   P2trPSLG *outline;
+  /**
+   * The metric in which the triangulation is Delaunay, or NULL for the
+   * Euclidean metric. See @ref p2tr_cdt_set_metric_field
+   */
+  P2trMetricField *metric;
 } P2trCDT;
 
 /**
@@ -51,10 +58,41 @@ typedef struct
  */
 P2trCDT*    p2tr_cdt_new       (P2tCDT *cdt);
 
+/**
+ * Create a new P2trCDT over an existing mesh, such as one loaded by
+ * @ref p2tr_mesh_load_checkpoint. The mesh is reffed, and its
+ * constrained edges become the outline of the triangulation. The mesh
+ * is assumed to already be a constrained Delaunay triangulation
+ * @param mesh The mesh of the triangulation
+ * @return A P2trCDT Constrained Delaunay Triangulation
+ */
+P2trCDT*    p2tr_cdt_new_from_mesh (P2trMesh *mesh);
+
 void        p2tr_cdt_free      (P2trCDT *cdt);
 
 void        p2tr_cdt_free_full (P2trCDT *cdt, gboolean clear_mesh);
 
+/**
+ * Make the triangulation Delaunay according to a metric field instead
+ * of the Euclidean metric - the empty circum-circle tests are done in
+ * metric space, using the average of the metrics at the four points
+ * involved in each test. The existing triangulation is fixed by
+ * flipping edges.
+ * @param self The triangulation
+ * @param metric The metric field (which is reffed), or NULL for the
+ *        Euclidean metric
+ */
+void        p2tr_cdt_set_metric_field (P2trCDT         *self,
+                                       P2trMetricField *metric);
+
+/**
+ * Test whether a point is inside the circum-circle of a triangle,
+ * in the metric of the triangulation
+ */
+P2trInCircle p2tr_cdt_circumcircle_contains_point (P2trCDT      *self,
+                                                   P2trTriangle *tri,
+                                                   P2trPoint    *pt);
+
 /**
  * Test whether there is a path from the point @ref p to the edge @e
  * so that the path does not cross any segment of the CDT
@@ -76,20 +114,47 @@ void        p2tr_cdt_validate_unused   (P2trCDT* self);
  * Make sure the constrained empty circum-circle property holds,
  * meaning that each triangles circum-scribing circle is either empty
  * or only contains points which are not "visible" from the edges of
- * the triangle.
+ * the triangle. This test is always done in the Euclidean metric,
+ * even if the triangulation has a metric field.
  */
 void        p2tr_cdt_validate_cdt      (P2trCDT *self);
 
+/**
+ * Make sure the constrained delaunay property holds locally across
+ * every edge, meaning that for every unconstrained edge, the point
+ * opposite to it in one of its triangles is not inside the
+ * circum-circle of its other triangle. This is equivalent to the check
+ * done by @ref p2tr_cdt_validate_cdt, but it runs in linear time and
+ * respects the metric field of the triangulation.
+ */
+void        p2tr_cdt_validate_cdt_local (P2trCDT *self);
+
+/**
+ * Like @ref p2tr_cdt_validate_cdt_local, but only check the edges of
+ * the triangles that were added by the mesh action group which is
+ * currently being recorded on the mesh of the CDT. Must be called
+ * before the group is committed.
+ */
+void        p2tr_cdt_validate_action_group (P2trCDT *self);
+
 #if P2TR_CDT_VALIDATE
 #define P2TR_CDT_VALIDATE_EDGES(CDT)  p2tr_cdt_validate_edges(CDT)
 #define P2TR_CDT_VALIDATE_UNUSED(CDT) p2tr_cdt_validate_unused(CDT)
-#define P2TR_CDT_VALIDATE_CDT(CDT)    p2tr_cdt_validate_cdt(CDT)
+#define P2TR_CDT_VALIDATE_CDT(CDT)    p2tr_cdt_validate_cdt_local(CDT)
 #else
 #define P2TR_CDT_VALIDATE_EDGES(CDT)  G_STMT_START { } G_STMT_END
 #define P2TR_CDT_VALIDATE_UNUSED(CDT) G_STMT_START { } G_STMT_END
 #define P2TR_CDT_VALIDATE_CDT(CDT)    G_STMT_START { } G_STMT_END
 #endif
 
+/* The validation of each mesh action group is cheap enough to be
+ * enabled separately from the full validation */
+#if P2TR_CDT_VALIDATE || P2TR_CDT_VALIDATE_LOCAL
+#define P2TR_CDT_VALIDATE_GROUP(CDT)  p2tr_cdt_validate_action_group(CDT)
+#else
+#define P2TR_CDT_VALIDATE_GROUP(CDT)  G_STMT_START { } G_STMT_END
+#endif
+
 /**
  * Insert a point into the triangulation while preserving the
  * constrained delaunay property
@@ -124,4 +189,37 @@ GList*      p2tr_cdt_split_edge (P2trCDT   *self,
                                  P2trEdge  *e,
                                  P2trPoint *C);
 
+/**
+ * Test whether a point can be removed by @ref p2tr_cdt_remove_point,
+ * meaning that it's inside the domain and not on any segment
+ */
+gboolean    p2tr_cdt_point_is_removable (P2trCDT   *self,
+                                         P2trPoint *pt);
+
+/**
+ * Find the triangles that would fill the hole left by removing a point
+ * with @ref p2tr_cdt_remove_point, without changing the mesh. The
+ * actual result may differ in rare cases (and in triangulations with a
+ * metric field), since edges may be flipped after the hole is filled.
+ * @param self The triangulation
+ * @param pt A removable point (see @ref p2tr_cdt_point_is_removable)
+ * @param[out] count The amount of triangles
+ * @return An array of 3 * count points (which are not reffed), listing
+ *         the points of each triangle in counter-clockwise order. Must
+ *         be freed with g_free
+ */
+P2trPoint** p2tr_cdt_predict_point_removal (P2trCDT   *self,
+                                            P2trPoint *pt,
+                                            guint     *count);
+
+/**
+ * Remove a point from the triangulation while preserving the
+ * constrained delaunay property. Only the triangles around the point
+ * are changed.
+ * @param self The triangulation
+ * @param pt A removable point (see @ref p2tr_cdt_point_is_removable)
+ */
+void        p2tr_cdt_remove_point (P2trCDT   *self,
+                                   P2trPoint *pt);
+
 #endif
@@ -41,6 +41,8 @@
 #include "line.h"
 #include "bounded-line.h"
 #include "pslg.h"
+#include "dense-set.h"
+#include "pool.h"
 
 #include "triangulation.h"
 
@@ -53,7 +55,11 @@
 #include "vtriangle.h"
 
 #include "cluster.h"
+#include "metric.h"
 #include "rcdt.h"
 #include "refiner.h"
+#include "simplifier.h"
+#include "sizing-field.h"
+#include "smooth.h"
 
 #endif
@@ -54,12 +54,58 @@ p2tr_refiner_new (gdouble             min_angle,
   return P2T_IMP_TO_REFINER (p2tr_dt_new (min_angle, size_control, cdt));
 }
 
+P2trRefiner*
+p2tr_refiner_new_full (gdouble               min_angle,
+                       P2trTriangleTooBig    size_control,
+                       P2trSteinerPlacement  placement,
+                       P2trSteinerPointFunc  place_func,
+                       gpointer              place_data,
+                       P2trCDT              *cdt)
+{
+  return P2T_IMP_TO_REFINER (p2tr_dt_new_full (min_angle, size_control,
+      placement, place_func, place_data, cdt));
+}
+
 void
 p2tr_refiner_free (P2trRefiner *self)
 {
   p2tr_dt_free (P2T_REFINER_TO_IMP (self));
 }
 
+void
+p2tr_refiner_set_sizing_field (P2trRefiner     *self,
+                               P2trSizingField *sizing)
+{
+  p2tr_dt_set_sizing_field (P2T_REFINER_TO_IMP (self), sizing);
+}
+
+void
+p2tr_refiner_set_metric_field (P2trRefiner     *self,
+                               P2trMetricField *metric)
+{
+  p2tr_cdt_set_metric_field (P2T_REFINER_TO_IMP (self)->cdt, metric);
+}
+
+void
+p2tr_refiner_reset (P2trRefiner *self)
+{
+  p2tr_dt_reset (P2T_REFINER_TO_IMP (self));
+}
+
+void
+p2tr_refiner_save_queues (P2trRefiner *self,
+                          FILE        *out)
+{
+  p2tr_dt_save_queues (P2T_REFINER_TO_IMP (self), out);
+}
+
+gboolean
+p2tr_refiner_load_queues (P2trRefiner *self,
+                          FILE        *in)
+{
+  return p2tr_dt_load_queues (P2T_REFINER_TO_IMP (self), in);
+}
+
 void
 p2tr_refiner_refine (P2trRefiner             *self,
                      gint                     max_steps,
@@ -68,3 +114,70 @@ p2tr_refiner_refine (P2trRefiner             *self,
   p2tr_dt_refine (P2T_REFINER_TO_IMP (self), max_steps, on_progress);
 }
 
+void
+p2tr_refiner_budget_init (P2trRefineBudget *budget)
+{
+  budget->max_steps = 0;
+  budget->deadline_ns = 0;
+  budget->max_points = 0;
+  budget->max_triangles = 0;
+  budget->max_bytes = 0;
+}
+
+void
+p2tr_refiner_budget_set_timeout (P2trRefineBudget *budget,
+                                 gint64            timeout_ns)
+{
+  budget->deadline_ns = g_get_monotonic_time () * 1000 + timeout_ns;
+}
+
+P2trRefineStopReason
+p2tr_refiner_refine_budget (P2trRefiner              *self,
+                            const P2trRefineBudget   *budget,
+                            P2trRefineProgressNotify  on_progress)
+{
+  return p2tr_dt_refine_budget (P2T_REFINER_TO_IMP (self), budget, on_progress);
+}
+
+static P2trRefineStopReason
+p2tr_refiner_refine_seeded (P2trRefiner              *self,
+                            const P2trRefineBudget   *budget,
+                            P2trRefineProgressNotify  on_progress)
+{
+  P2trRefineBudget no_limits;
+
+  if (budget == NULL)
+    {
+      p2tr_refiner_budget_init (&no_limits);
+      budget = &no_limits;
+    }
+
+  return p2tr_dt_refine_budget (P2T_REFINER_TO_IMP (self), budget, on_progress);
+}
+
+P2trRefineStopReason
+p2tr_refiner_refine_region (P2trRefiner              *self,
+                            P2trTriangle            **triangles,
+                            guint                     count,
+                            const P2trRefineBudget   *budget,
+                            P2trRefineProgressNotify  on_progress)
+{
+  p2tr_dt_seed_region (P2T_REFINER_TO_IMP (self), triangles, count);
+  return p2tr_refiner_refine_seeded (self, budget, on_progress);
+}
+
+P2trRefineStopReason
+p2tr_refiner_refine_box (P2trRefiner              *self,
+                         gdouble                   min_x,
+                         gdouble                   min_y,
+                         gdouble                   max_x,
+                         gdouble                   max_y,
+                         P2trTriangle             *initial_guess,
+                         const P2trRefineBudget   *budget,
+                         P2trRefineProgressNotify  on_progress)
+{
+  p2tr_dt_seed_box (P2T_REFINER_TO_IMP (self), min_x, min_y, max_x, max_y,
+                    initial_guess);
+  return p2tr_refiner_refine_seeded (self, budget, on_progress);
+}
+
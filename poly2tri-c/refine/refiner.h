@@ -33,11 +33,15 @@
 #ifndef __P2TC_REFINE_REFINER_H__
 #define __P2TC_REFINE_REFINER_H__
 
+#include <stdio.h>
 #include <glib.h>
 #include "rcdt.h"
 
 typedef struct P2trRefiner_ P2trRefiner;
 
+/** \ingroup P2trSizingField */
+typedef struct P2trSizingField_ P2trSizingField;
+
 
 typedef gboolean (*P2trTriangleTooBig)       (P2trTriangle *tri);
 
@@ -48,14 +52,258 @@ typedef void     (*P2trRefineProgressNotify) (P2trRefiner  *refiner,
                                               int           step_number,
                                               int           max_steps);
 
+/**
+ * The strategy for choosing the position of the point which is inserted
+ * in order to eliminate a bad triangle
+ */
+typedef enum
+{
+  /** Insert the circumcenter of the triangle */
+  P2TR_REFINER_PLACE_CIRCUMCENTER,
+  /** Insert the off-center of the triangle, which usually results in
+   *  meshes with the same angle bound but fewer points. See
+   *  @ref p2tr_math_triangle_offcenter */
+  P2TR_REFINER_PLACE_OFFCENTER,
+  /** Ask a callback (@ref P2trSteinerPointFunc) for the point */
+  P2TR_REFINER_PLACE_CALLBACK
+} P2trSteinerPlacement;
+
+/**
+ * A function for choosing the point which should be inserted in order
+ * to eliminate a bad triangle
+ * @param[in] tri The bad triangle
+ * @param[in] min_angle The minimal angle requested from the refiner
+ * @param[out] dest The point to insert
+ * @param[in] user_data The data given when the refiner was created
+ * @return TRUE if a point was chosen, FALSE if the circumcenter should
+ *         be used instead
+ */
+typedef gboolean (*P2trSteinerPointFunc)     (P2trTriangle *tri,
+                                              gdouble       min_angle,
+                                              P2trVector2  *dest,
+                                              gpointer      user_data);
+
 P2trRefiner* p2tr_refiner_new    (gdouble                   min_angle,
                                   P2trTriangleTooBig        size_control,
                                   P2trCDT                  *cdt);
 
+/**
+ * Like @ref p2tr_refiner_new, but also choose the strategy for placing
+ * the new points
+ * @param min_angle The minimal angle of triangles in the refined mesh
+ * @param size_control A function for finding triangles which are too big
+ * @param placement The strategy for placing new points
+ * @param place_func The function for placing new points. Only used (and
+ *        must not be NULL) if the placement is
+ *        @ref P2TR_REFINER_PLACE_CALLBACK
+ * @param place_data User data for @ref place_func
+ * @param cdt The triangulation to refine
+ */
+P2trRefiner* p2tr_refiner_new_full (gdouble                 min_angle,
+                                    P2trTriangleTooBig      size_control,
+                                    P2trSteinerPlacement    placement,
+                                    P2trSteinerPointFunc    place_func,
+                                    gpointer                place_data,
+                                    P2trCDT                *cdt);
+
 void         p2tr_refiner_free   (P2trRefiner              *self);
 
+/**
+ * Replace the size control of a refiner with a sizing field. This
+ * takes the place of the @ref P2trTriangleTooBig function given when
+ * the refiner was created. Unlike that function, which is only asked
+ * about the triangles created by the refinement, a sizing field is
+ * also tested on all the triangles of the mesh when the refinement
+ * starts, so triangles of the input which are too big are split too
+ * @param self The refiner
+ * @param sizing The sizing field (which is reffed), or NULL to refine
+ *        according to the angle bound only
+ */
+void         p2tr_refiner_set_sizing_field (P2trRefiner     *self,
+                                            P2trSizingField *sizing);
+
+/**
+ * Discard the state of a refinement which was stopped before it was
+ * finished (see @ref p2tr_refiner_refine_budget), so that the next
+ * refinement scans the entire mesh again. This must be called if the
+ * mesh was modified by anything other than the refiner in the middle
+ * of a refinement.
+ */
+void         p2tr_refiner_reset  (P2trRefiner              *self);
+
+/**
+ * Switch a refiner to anisotropic refinement according to a metric
+ * field. The triangulation is made Delaunay in the metric (see
+ * @ref p2tr_cdt_set_metric_field), the angle bound of the refiner is
+ * tested in metric space (for triangles with no edge shorter than
+ * @ref P2TR_METRIC_MIN_EDGE_LENGTH), triangles with edges longer than
+ * @ref P2TR_METRIC_MAX_EDGE_LENGTH in metric space are refined too,
+ * and new points are placed at the circumcenters in metric space.
+ * Encroachment of segments is still tested in the Euclidean space, and
+ * a segment is split when it hides the circumcenter of a triangle.
+ *
+ * Since a metric field can ask for arbitrarily many triangles, it's
+ * recommended to refine with a limited budget (see
+ * @ref p2tr_refiner_refine_budget).
+ * @param self The refiner
+ * @param metric The metric field (which is reffed), or NULL to go back
+ *        to isotropic refinement
+ */
+void         p2tr_refiner_set_metric_field (P2trRefiner     *self,
+                                            P2trMetricField *metric);
+
+/**
+ * Save the state of a refinement which was stopped before it was
+ * finished. The points are referred to by their index in the mesh,
+ * so the state should be saved together with the mesh (see
+ * @ref p2tr_mesh_save_checkpoint), and the mesh must not be modified
+ * between saving the two.
+ * @param self The refiner whose state should be saved
+ * @param out The file into which the state should be written
+ */
+void         p2tr_refiner_save_queues (P2trRefiner         *self,
+                                       FILE                *out);
+
+/**
+ * Restore a state saved by @ref p2tr_refiner_save_queues, into a
+ * refiner of the triangulation that was saved along with it. To resume
+ * a refinement from a checkpoint, load the mesh with
+ * @ref p2tr_mesh_load_checkpoint, wrap it with
+ * @ref p2tr_cdt_new_from_mesh and create a refiner for it with the
+ * same parameters (including any sizing or metric field). The
+ * refinement can then be continued by calling
+ * @ref p2tr_refiner_refine_budget
+ * @param self The refiner whose state should be restored
+ * @param in The file to read the state from
+ * @return TRUE if the state was restored, FALSE if an error occurred
+ *         while parsing the file (in which case the refiner is reset)
+ */
+gboolean     p2tr_refiner_load_queues (P2trRefiner         *self,
+                                       FILE                *in);
+
 void         p2tr_refiner_refine (P2trRefiner              *self,
                                   gint                      max_steps,
                                   P2trRefineProgressNotify  on_progress);
 
+/**
+ * Limits on the work done by one call to
+ * @ref p2tr_refiner_refine_budget. A value of 0 in any of the fields
+ * means that the respective resource is not limited.
+ *
+ * The limits are checked between refinement steps and before each
+ * split of an encroached segment, so the mesh is always a valid CDT
+ * when refinement stops. Since inserting one point may add several
+ * triangles, the point, triangle and memory limits may be exceeded by
+ * the result of a single insertion.
+ */
+typedef struct
+{
+  /** The maximal amount of refinement steps */
+  gint     max_steps;
+  /** The monotonic time (see g_get_monotonic_time), in nanoseconds,
+   *  after which refinement should stop */
+  gint64   deadline_ns;
+  /** The maximal amount of points in the mesh */
+  guint    max_points;
+  /** The maximal amount of triangles in the mesh */
+  guint    max_triangles;
+  /** The maximal amount of memory used by the mesh, as estimated by
+   *  @ref p2tr_mesh_get_memory_size */
+  gsize    max_bytes;
+} P2trRefineBudget;
+
+/**
+ * The reason for which refinement stopped
+ */
+typedef enum
+{
+  /** The mesh was fully refined */
+  P2TR_REFINE_DONE = 0,
+  P2TR_REFINE_STOP_STEPS,
+  P2TR_REFINE_STOP_DEADLINE,
+  P2TR_REFINE_STOP_POINTS,
+  P2TR_REFINE_STOP_TRIANGLES,
+  P2TR_REFINE_STOP_MEMORY
+} P2trRefineStopReason;
+
+/**
+ * Initialize a budget with no limits at all
+ */
+void         p2tr_refiner_budget_init        (P2trRefineBudget *budget);
+
+/**
+ * Set the deadline of a budget to be the given amount of nanoseconds
+ * from now
+ */
+void         p2tr_refiner_budget_set_timeout (P2trRefineBudget *budget,
+                                              gint64            timeout_ns);
+
+/**
+ * Refine the triangulation until it's fully refined or until one of
+ * the limits of the budget is reached. Refinement which was stopped
+ * may be continued by calling this function again, with a larger
+ * budget - the refiner keeps its queues between the calls, so the
+ * mesh is not scanned again.
+ * @param self The refiner
+ * @param budget The limits on the refinement
+ * @param on_progress A function to notify on progress, or NULL. The
+ *        max_steps it receives is 0 if the steps are not limited
+ * @return The reason for which the refinement stopped
+ */
+P2trRefineStopReason
+             p2tr_refiner_refine_budget      (P2trRefiner              *self,
+                                              const P2trRefineBudget   *budget,
+                                              P2trRefineProgressNotify  on_progress);
+
+/**
+ * Refine the triangulation after it was edited in a small region,
+ * without scanning the entire mesh for bad triangles. Only the given
+ * triangles and their neighbors are checked at first, and the
+ * refinement then grows outward from the points it inserts. If a
+ * previous refinement was stopped before it finished, it's continued
+ * as well.
+ * @param self The refiner
+ * @param triangles The triangles which were created or modified by
+ *        the edit. Triangles which were removed since are ignored
+ * @param count The amount of triangles
+ * @param budget The limits on the refinement, or NULL for no limits
+ * @param on_progress A function to notify on progress, or NULL
+ * @return The reason for which the refinement stopped
+ */
+P2trRefineStopReason
+             p2tr_refiner_refine_region      (P2trRefiner              *self,
+                                              P2trTriangle            **triangles,
+                                              guint                     count,
+                                              const P2trRefineBudget   *budget,
+                                              P2trRefineProgressNotify  on_progress);
+
+/**
+ * Same as @ref p2tr_refiner_refine_region, but check the triangles
+ * which intersect an axis aligned box instead of a list of triangles.
+ * The triangles are found by growing a region from the center of the
+ * box, which continues along the boundary of the domain where the box
+ * crosses a hole or a concave part of the domain. If the center of the
+ * box is outside of the domain, all the triangles are checked
+ * @param self The refiner
+ * @param min_x The minimal X coordinate of the box
+ * @param min_y The minimal Y coordinate of the box
+ * @param max_x The maximal X coordinate of the box
+ * @param max_y The maximal Y coordinate of the box
+ * @param initial_guess A triangle near the center of the box, or NULL.
+ *        Without it, finding the triangles in the box takes time
+ *        linear in the size of the mesh
+ * @param budget The limits on the refinement, or NULL for no limits
+ * @param on_progress A function to notify on progress, or NULL
+ * @return The reason for which the refinement stopped
+ */
+P2trRefineStopReason
+             p2tr_refiner_refine_box         (P2trRefiner              *self,
+                                              gdouble                   min_x,
+                                              gdouble                   min_y,
+                                              gdouble                   max_x,
+                                              gdouble                   max_y,
+                                              P2trTriangle             *initial_guess,
+                                              const P2trRefineBudget   *budget,
+                                              P2trRefineProgressNotify  on_progress);
+
 #endif
@@ -31,6 +31,7 @@
  */
 
 #include <math.h>
+#include <string.h>
 #include <glib.h>
 #include "rmath.h"
 
@@ -88,43 +89,117 @@ p2tr_matrix_det4 (gdouble a00, gdouble a01, gdouble a02, gdouble a03,
 }
 
 void
-p2tr_math_triangle_circumcircle (const P2trVector2 *A,
+p2tr_math_triangle_circumcenter (const P2trVector2 *A,
                                  const P2trVector2 *B,
                                  const P2trVector2 *C,
-                                 P2trCircle    *circle)
+                                 P2trVector2       *center,
+                                 gdouble           *radius_sq)
 {
-  /*       | Ax Bx Cx |
-   * D = + | Ay By Cy | * 2
-   *       | +1 +1 +1 |
+  /* Compute everything relative to A, so that large coordinates don't
+   * get squared and lose their precision:
    *
-   *       | Asq Bsq Csq |
-   * X = + | Ay  By  Cy  | / D
-   *       | 1   1   1   |
+   *       | ABy  ABsq |              | ABx  ABsq |
+   * X = - | ACy  ACsq | / D,   Y = + | ACx  ACsq | / D
    *
-   *       | Asq Bsq Csq |
-   * Y = - | Ax  Bx  Cx  | / D
-   *       | 1   1   1   |
+   *         | ABx ABy |
+   * D = 2 * | ACx ACy |
    */
-  gdouble Asq = P2TR_VECTOR2_LEN_SQ (A);
-  gdouble Bsq = P2TR_VECTOR2_LEN_SQ (B);
-  gdouble Csq = P2TR_VECTOR2_LEN_SQ (C);
-
-  gdouble invD = 1 / (2 * p2tr_matrix_det3 (
-      A->x, B->x, C->x,
-      A->y, B->y, C->y,
-      1,    1,    1));
-
-  circle->center.x = + p2tr_matrix_det3 (
-      Asq,  Bsq,  Csq,
-      A->y, B->y, C->y,
-      1,    1,    1) * invD;
-
-  circle->center.y = - p2tr_matrix_det3 (
-      Asq,  Bsq,  Csq,
-      A->x, B->x, C->x,
-      1,    1,    1) * invD;
-
-  circle->radius = sqrt (P2TR_VECTOR2_DISTANCE_SQ (A, &circle->center));
+  gdouble abx = B->x - A->x, aby = B->y - A->y;
+  gdouble acx = C->x - A->x, acy = C->y - A->y;
+  gdouble absq = abx * abx + aby * aby;
+  gdouble acsq = acx * acx + acy * acy;
+
+  gdouble invD = 0.5 / p2tr_matrix_det2 (abx, aby, acx, acy);
+
+  gdouble x = - p2tr_matrix_det2 (aby, absq, acy, acsq) * invD;
+  gdouble y = + p2tr_matrix_det2 (abx, absq, acx, acsq) * invD;
+
+  center->x = A->x + x;
+  center->y = A->y + y;
+
+  if (radius_sq != NULL)
+    *radius_sq = x * x + y * y;
+}
+
+void
+p2tr_math_triangle_offcenter (const P2trVector2 *A,
+                              const P2trVector2 *B,
+                              const P2trVector2 *C,
+                              gdouble            min_angle,
+                              P2trVector2       *center,
+                              gdouble           *radius_sq)
+{
+  const P2trVector2 *P, *Q;
+  gdouble ab = P2TR_VECTOR2_DISTANCE_SQ (A, B);
+  gdouble bc = P2TR_VECTOR2_DISTANCE_SQ (B, C);
+  gdouble ca = P2TR_VECTOR2_DISTANCE_SQ (C, A);
+  gdouble pq_sq, mc_sq, h;
+  P2trVector2 M;
+
+  p2tr_math_triangle_circumcenter (A, B, C, center, radius_sq);
+
+  /* Find the shortest edge PQ */
+  if (ab <= bc && ab <= ca)
+    { P = A; Q = B; pq_sq = ab; }
+  else if (bc <= ca)
+    { P = B; Q = C; pq_sq = bc; }
+  else
+    { P = C; Q = A; pq_sq = ca; }
+
+  /* The off-center is the point on the bisector of PQ, on the side of
+   * the circumcenter, where PQ is seen at exactly the minimal angle. If
+   * the circumcenter is closer to PQ than that, it's used instead.
+   * See Alper Ungor, "Off-centers: A new type of Steiner points for
+   * computing size-optimal quality-guaranteed Delaunay triangulations" */
+  p2tr_vector2_center (P, Q, &M);
+  mc_sq = P2TR_VECTOR2_DISTANCE_SQ (&M, center);
+  h = sqrt (pq_sq) / (2 * tan (min_angle / 2));
+
+  if (mc_sq > h * h)
+    {
+      gdouble scale = h / sqrt (mc_sq);
+      center->x = M.x + (center->x - M.x) * scale;
+      center->y = M.y + (center->y - M.y) * scale;
+
+      if (radius_sq != NULL)
+        *radius_sq = pq_sq / 4 + h * h;
+    }
+}
+
+gdouble
+p2tr_math_triangle_min_angle (const P2trVector2 *A,
+                              const P2trVector2 *B,
+                              const P2trVector2 *C)
+{
+  const P2trVector2 *P[3];
+  gdouble            result = G_MAXDOUBLE;
+  gint               i;
+
+  P[0] = A;
+  P[1] = B;
+  P[2] = C;
+
+  for (i = 0; i < 3; i++)
+    {
+      const P2trVector2 *O = P[i], *U = P[(i + 1) % 3], *V = P[(i + 2) % 3];
+      gdouble ux = U->x - O->x, uy = U->y - O->y;
+      gdouble vx = V->x - O->x, vy = V->y - O->y;
+
+      result = MIN (result, atan2 (ABS (ux * vy - uy * vx), ux * vx + uy * vy));
+    }
+
+  return result;
+}
+
+void
+p2tr_math_triangle_circumcircle (const P2trVector2 *A,
+                                 const P2trVector2 *B,
+                                 const P2trVector2 *C,
+                                 P2trCircle    *circle)
+{
+  gdouble radius_sq;
+  p2tr_math_triangle_circumcenter (A, B, C, &circle->center, &radius_sq);
+  circle->radius = sqrt (radius_sq);
 }
 
 /* The point in triangle test which is implemented below is based on the
@@ -161,7 +236,327 @@ p2tr_math_triangle_barcycentric (const P2trVector2 *A,
   *v = (dot00 * dot12 - dot01 * dot02) * invDenom;
 }
 
-#define INTRIANGLE_EPSILON 0e-9
+/* The point in triangle circumcircle test, and the 3-point orientation
+ * test, are both based on the work of Jonathan Richard Shewchuk. The
+ * technique used here is described in his paper "Adaptive Precision
+ * Floating-Point Arithmetic and Fast Robust Geometric Predicates".
+ *
+ * Each predicate first evaluates its determinant using plain floating
+ * point arithmetic, and accepts the sign of the result if its magnitude
+ * is larger than a bound on the rounding error of that computation.
+ * Only when the result is too close to zero to be trusted, the
+ * determinant is evaluated again exactly, by representing each value as
+ * an "expansion" - a sum of non-overlapping doubles sorted by increasing
+ * magnitude, whose sign is the sign of its largest component.
+ *
+ * Like Shewchuk's code, this requires IEEE double precision arithmetic
+ * with round-to-nearest, and no reordering of floating point operations
+ * by the compiler (i.e. don't build with -ffast-math).
+ */
+
+/* Half of the distance between 1.0 and the next double */
+#define P2TR_EXACT_EPSILON        (1.0 / 9007199254740992.0)
+/* 2^ceil(53 / 2) + 1, used for splitting a double into two halves */
+#define P2TR_EXACT_SPLITTER       134217729.0
+
+#define P2TR_ORIENT2D_ERRBOUND    ((3.0 + 16.0 * P2TR_EXACT_EPSILON) * P2TR_EXACT_EPSILON)
+#define P2TR_INCIRCLE_ERRBOUND    ((10.0 + 96.0 * P2TR_EXACT_EPSILON) * P2TR_EXACT_EPSILON)
+
+/* The maximal length of the expansions built by the exact incircle */
+#define P2TR_EXACT_MAX_PRODUCT    512
+#define P2TR_EXACT_MAX_LENGTH     (3 * P2TR_EXACT_MAX_PRODUCT)
+
+/* x + y = a + b exactly, where x is the rounded sum */
+static inline void
+p2tr_exact_two_sum (gdouble a, gdouble b, gdouble *x, gdouble *y)
+{
+  gdouble bvirt, avirt;
+  *x = a + b;
+  bvirt = *x - a;
+  avirt = *x - bvirt;
+  *y = (a - avirt) + (b - bvirt);
+}
+
+/* Same as p2tr_exact_two_sum, assuming |a| >= |b| */
+static inline void
+p2tr_exact_fast_two_sum (gdouble a, gdouble b, gdouble *x, gdouble *y)
+{
+  *x = a + b;
+  *y = b - (*x - a);
+}
+
+/* x + y = a - b exactly, where x is the rounded difference */
+static inline void
+p2tr_exact_two_diff (gdouble a, gdouble b, gdouble *x, gdouble *y)
+{
+  gdouble bvirt, avirt;
+  *x = a - b;
+  bvirt = a - *x;
+  avirt = *x + bvirt;
+  *y = (a - avirt) + (bvirt - b);
+}
+
+/* hi + lo = a, where each half has at most 26 significant bits */
+static inline void
+p2tr_exact_split (gdouble a, gdouble *hi, gdouble *lo)
+{
+  gdouble c = P2TR_EXACT_SPLITTER * a;
+  gdouble abig = c - a;
+  *hi = c - abig;
+  *lo = a - *hi;
+}
+
+/* x + y = a * b exactly, where x is the rounded product and b was
+ * already split into bhi + blo */
+static inline void
+p2tr_exact_two_product_presplit (gdouble a, gdouble b, gdouble bhi,
+                                 gdouble blo, gdouble *x, gdouble *y)
+{
+  gdouble ahi, alo, err1, err2, err3;
+  *x = a * b;
+  p2tr_exact_split (a, &ahi, &alo);
+  err1 = *x - (ahi * bhi);
+  err2 = err1 - (alo * bhi);
+  err3 = err2 - (ahi * blo);
+  *y = (alo * blo) - err3;
+}
+
+/* h = e + f, where both e and f are non-empty expansions. h must not
+ * overlap e or f, and must have room for elen + flen components.
+ * Returns the length of h */
+static gint
+p2tr_exact_sum (gint elen, const gdouble *e,
+                gint flen, const gdouble *f,
+                gdouble *h)
+{
+  gdouble Q, Qnew, hh;
+  gint    eindex = 0, findex = 0, hindex = 0;
+
+  /* Always consume the component with the smaller magnitude first */
+  if ((f[0] > e[0]) == (f[0] > -e[0]))
+    Q = e[eindex++];
+  else
+    Q = f[findex++];
+
+  while (eindex < elen && findex < flen)
+    {
+      if ((f[findex] > e[eindex]) == (f[findex] > -e[eindex]))
+        p2tr_exact_two_sum (Q, e[eindex++], &Qnew, &hh);
+      else
+        p2tr_exact_two_sum (Q, f[findex++], &Qnew, &hh);
+      Q = Qnew;
+      if (hh != 0)
+        h[hindex++] = hh;
+    }
+
+  while (eindex < elen)
+    {
+      p2tr_exact_two_sum (Q, e[eindex++], &Qnew, &hh);
+      Q = Qnew;
+      if (hh != 0)
+        h[hindex++] = hh;
+    }
+
+  while (findex < flen)
+    {
+      p2tr_exact_two_sum (Q, f[findex++], &Qnew, &hh);
+      Q = Qnew;
+      if (hh != 0)
+        h[hindex++] = hh;
+    }
+
+  if (Q != 0 || hindex == 0)
+    h[hindex++] = Q;
+
+  return hindex;
+}
+
+/* h = e * b, where e is a non-empty expansion. h must not overlap e
+ * and must have room for 2 * elen components. Returns the length of h */
+static gint
+p2tr_exact_scale (gint elen, const gdouble *e, gdouble b, gdouble *h)
+{
+  gdouble Q, sum, hh, product1, product0, bhi, blo;
+  gint    eindex, hindex = 0;
+
+  p2tr_exact_split (b, &bhi, &blo);
+  p2tr_exact_two_product_presplit (e[0], b, bhi, blo, &Q, &hh);
+  if (hh != 0)
+    h[hindex++] = hh;
+
+  for (eindex = 1; eindex < elen; eindex++)
+    {
+      p2tr_exact_two_product_presplit (e[eindex], b, bhi, blo, &product1, &product0);
+      p2tr_exact_two_sum (Q, product0, &sum, &hh);
+      if (hh != 0)
+        h[hindex++] = hh;
+      p2tr_exact_fast_two_sum (product1, sum, &Q, &hh);
+      if (hh != 0)
+        h[hindex++] = hh;
+    }
+
+  if (Q != 0 || hindex == 0)
+    h[hindex++] = Q;
+
+  return hindex;
+}
+
+/* h = e * f, where the result is known to fit in
+ * P2TR_EXACT_MAX_PRODUCT components and e has at most 16 components.
+ * Returns the length of h */
+static gint
+p2tr_exact_mul (gint elen, const gdouble *e,
+                gint flen, const gdouble *f,
+                gdouble *h)
+{
+  gdouble scaled[32], acc[2][P2TR_EXACT_MAX_PRODUCT];
+  gint    i, slen, alen, cur = 0;
+
+  g_assert (elen <= 16);
+
+  alen = p2tr_exact_scale (elen, e, f[0], acc[cur]);
+  for (i = 1; i < flen; i++)
+    {
+      slen = p2tr_exact_scale (elen, e, f[i], scaled);
+      alen = p2tr_exact_sum (alen, acc[cur], slen, scaled, acc[1 - cur]);
+      cur = 1 - cur;
+    }
+
+  memcpy (h, acc[cur], alen * sizeof (gdouble));
+  return alen;
+}
+
+/* Negate an expansion in place */
+static void
+p2tr_exact_negate (gint elen, gdouble *e)
+{
+  gint i;
+  for (i = 0; i < elen; i++)
+    e[i] = -e[i];
+}
+
+/* The sign of an expansion is the sign of its largest component */
+#define P2TR_EXACT_SIGN(elen,e) ((e)[(elen) - 1])
+
+/* h = ab * cd - ef * gh, where each of the inputs is a two component
+ * expansion. h must have room for 16 components */
+static gint
+p2tr_exact_cross (const gdouble *ab, const gdouble *cd,
+                  const gdouble *ef, const gdouble *gh,
+                  gdouble *h)
+{
+  gdouble left[8], right[8];
+  gint    llen, rlen;
+
+  llen = p2tr_exact_mul (2, ab, 2, cd, left);
+  rlen = p2tr_exact_mul (2, ef, 2, gh, right);
+  p2tr_exact_negate (rlen, right);
+  return p2tr_exact_sum (llen, left, rlen, right, h);
+}
+
+static gdouble
+p2tr_exact_orient2d (const P2trVector2 *A,
+                     const P2trVector2 *B,
+                     const P2trVector2 *C)
+{
+  gdouble acx[2], acy[2], bcx[2], bcy[2], det[16];
+  gint    dlen;
+
+  p2tr_exact_two_diff (A->x, C->x, &acx[1], &acx[0]);
+  p2tr_exact_two_diff (A->y, C->y, &acy[1], &acy[0]);
+  p2tr_exact_two_diff (B->x, C->x, &bcx[1], &bcx[0]);
+  p2tr_exact_two_diff (B->y, C->y, &bcy[1], &bcy[0]);
+
+  dlen = p2tr_exact_cross (acx, bcy, acy, bcx, det);
+  return P2TR_EXACT_SIGN (dlen, det);
+}
+
+/* h = dx * dx + dy * dy, where dx and dy are two component
+ * expansions. h must have room for 16 components */
+static gint
+p2tr_exact_lift (const gdouble *dx, const gdouble *dy, gdouble *h)
+{
+  gdouble xx[8], yy[8];
+  gint    xlen, ylen;
+
+  xlen = p2tr_exact_mul (2, dx, 2, dx, xx);
+  ylen = p2tr_exact_mul (2, dy, 2, dy, yy);
+  return p2tr_exact_sum (xlen, xx, ylen, yy, h);
+}
+
+static gdouble
+p2tr_exact_incircle (const P2trVector2 *A,
+                     const P2trVector2 *B,
+                     const P2trVector2 *C,
+                     const P2trVector2 *D)
+{
+  gdouble adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+  gdouble lift[16], cross[16];
+  gdouble term[3][P2TR_EXACT_MAX_PRODUCT];
+  gdouble ab[2 * P2TR_EXACT_MAX_PRODUCT], det[P2TR_EXACT_MAX_LENGTH];
+  gint    liftlen, crosslen, tlen[3], ablen, dlen;
+
+  p2tr_exact_two_diff (A->x, D->x, &adx[1], &adx[0]);
+  p2tr_exact_two_diff (A->y, D->y, &ady[1], &ady[0]);
+  p2tr_exact_two_diff (B->x, D->x, &bdx[1], &bdx[0]);
+  p2tr_exact_two_diff (B->y, D->y, &bdy[1], &bdy[0]);
+  p2tr_exact_two_diff (C->x, D->x, &cdx[1], &cdx[0]);
+  p2tr_exact_two_diff (C->y, D->y, &cdy[1], &cdy[0]);
+
+  liftlen  = p2tr_exact_lift (adx, ady, lift);
+  crosslen = p2tr_exact_cross (bdx, cdy, cdx, bdy, cross);
+  tlen[0]  = p2tr_exact_mul (crosslen, cross, liftlen, lift, term[0]);
+
+  liftlen  = p2tr_exact_lift (bdx, bdy, lift);
+  crosslen = p2tr_exact_cross (cdx, ady, adx, cdy, cross);
+  tlen[1]  = p2tr_exact_mul (crosslen, cross, liftlen, lift, term[1]);
+
+  liftlen  = p2tr_exact_lift (cdx, cdy, lift);
+  crosslen = p2tr_exact_cross (adx, bdy, bdx, ady, cross);
+  tlen[2]  = p2tr_exact_mul (crosslen, cross, liftlen, lift, term[2]);
+
+  ablen = p2tr_exact_sum (tlen[0], term[0], tlen[1], term[1], ab);
+  dlen  = p2tr_exact_sum (ablen, ab, tlen[2], term[2], det);
+
+  return P2TR_EXACT_SIGN (dlen, det);
+}
+
+/* Compute a value whose sign is the orientation of A, B and C: positive
+ * if they are in counter-clockwise order, negative if clockwise and zero
+ * if they are colinear. */
+static inline gdouble
+p2tr_math_orient2d_value (const P2trVector2 *A,
+                          const P2trVector2 *B,
+                          const P2trVector2 *C)
+{
+  gdouble detleft  = (A->x - C->x) * (B->y - C->y);
+  gdouble detright = (A->y - C->y) * (B->x - C->x);
+  gdouble det      = detleft - detright;
+  gdouble detsum;
+
+  /* If the two products have different signs (or one of them is zero),
+   * there is no cancellation and the result is surely correct */
+  if (detleft > 0)
+    {
+      if (detright <= 0)
+        return det;
+      detsum = detleft + detright;
+    }
+  else if (detleft < 0)
+    {
+      if (detright >= 0)
+        return det;
+      detsum = - detleft - detright;
+    }
+  else
+    return det;
+
+  if (det >= P2TR_ORIENT2D_ERRBOUND * detsum
+      || -det >= P2TR_ORIENT2D_ERRBOUND * detsum)
+    return det;
+
+  return p2tr_exact_orient2d (A, B, C);
+}
 
 P2trInTriangle
 p2tr_math_intriangle (const P2trVector2 *A,
@@ -181,29 +576,60 @@ p2tr_math_intriangle2 (const P2trVector2 *A,
                        gdouble           *u,
                        gdouble           *v)
 {
-  p2tr_math_triangle_barcycentric (A, B, C, P, u, v);
-  
-  /* Check if point is in triangle - i.e. whether (u + v) < 1 and both
-   * u and v are positive */
-  if ((*u >= INTRIANGLE_EPSILON) && (*v >= INTRIANGLE_EPSILON) && (*u + *v < 1 - INTRIANGLE_EPSILON))
-    return P2TR_INTRIANGLE_IN;
-  else if ((*u >= -INTRIANGLE_EPSILON) && (*v >= -INTRIANGLE_EPSILON) && (*u + *v <= 1 + INTRIANGLE_EPSILON))
-    return P2TR_INTRIANGLE_ON;
-  else
+  gdouble tri, ab, bc, ca;
+
+  /* Each orientation value is twice the signed area of a triangle whose
+   * vertices are P and one of the edges. The signs are exact, so P is
+   * classified consistently among neighbouring triangles. The
+   * barycentric coordinates are the ratios between these areas and the
+   * area of the whole triangle */
+  tri = p2tr_math_orient2d_value (A, B, C);
+  if (tri == 0)
+    {
+      *u = *v = 0;
+      return P2TR_INTRIANGLE_OUT;
+    }
+
+  ab = p2tr_math_orient2d_value (A, B, P);
+  ca = p2tr_math_orient2d_value (C, A, P);
+
+  *u = ab / tri;
+  *v = ca / tri;
+
+  if (*u < 0 || *v < 0)
     return P2TR_INTRIANGLE_OUT;
-}
 
-/* The point in triangle circumcircle test, and the 3-point orientation
- * test, are both based on the work of Jonathan Richard Shewchuk. The
- * technique used here is described in his paper "Adaptive Precision
- * Floating-Point Arithmetic and Fast Robust Geometric Predicates"
- */
+  bc = p2tr_math_orient2d_value (B, C, P);
+  if (tri < 0)
+    bc = -bc;
 
-#define ORIENT2D_EPSILON 1e-9
+  if (bc < 0)
+    return P2TR_INTRIANGLE_OUT;
+  else if (*u > 0 && *v > 0 && bc > 0)
+    return P2TR_INTRIANGLE_IN;
+  else
+    return P2TR_INTRIANGLE_ON;
+}
 
 P2trOrientation p2tr_math_orient2d (const P2trVector2 *A,
                                     const P2trVector2 *B,
                                     const P2trVector2 *C)
+{
+  gdouble result = p2tr_math_orient2d_value (A, B, C);
+
+  if (result > 0)
+    return P2TR_ORIENTATION_CCW;
+  else if (result < 0)
+    return P2TR_ORIENTATION_CW;
+  else
+    return P2TR_ORIENTATION_LINEAR;
+}
+
+#define ORIENT2D_EPSILON 1e-9
+
+P2trOrientation p2tr_math_orient2d_approx (const P2trVector2 *A,
+                                           const P2trVector2 *B,
+                                           const P2trVector2 *C)
 {
   /* We are trying to compute this determinant:
    * |Ax Ay 1|
@@ -224,8 +650,6 @@ P2trOrientation p2tr_math_orient2d (const P2trVector2 *A,
     return P2TR_ORIENTATION_LINEAR;
 }
 
-#define INCIRCLE_EPSILON 1e-9
-
 /* Points must be given in CCW order!!!!! */
 P2trInCircle
 p2tr_math_incircle (const P2trVector2 *A,
@@ -238,17 +662,39 @@ p2tr_math_incircle (const P2trVector2 *A,
    * |Bx By Bx^2+By^2 1|
    * |Cx Cy Cx^2+Cy^2 1|
    * |Dx Dy Dx^2+Dy^2 1|
+   * Translating all the points so that D is at the origin, it reduces
+   * to a 3x3 determinant which is both cheaper and more accurate:
+   * |ADx ADy ADx^2+ADy^2|
+   * |BDx BDy BDx^2+BDy^2|
+   * |CDx CDy CDx^2+CDy^2|
    */
-  gdouble result = p2tr_matrix_det4 (
-      A->x, A->y, P2TR_VECTOR2_LEN_SQ(A), 1,
-      B->x, B->y, P2TR_VECTOR2_LEN_SQ(B), 1,
-      C->x, C->y, P2TR_VECTOR2_LEN_SQ(C), 1,
-      D->x, D->y, P2TR_VECTOR2_LEN_SQ(D), 1
-  );
+  gdouble adx = A->x - D->x, ady = A->y - D->y;
+  gdouble bdx = B->x - D->x, bdy = B->y - D->y;
+  gdouble cdx = C->x - D->x, cdy = C->y - D->y;
+
+  gdouble bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+  gdouble cdxady = cdx * ady, adxcdy = adx * cdy;
+  gdouble adxbdy = adx * bdy, bdxady = bdx * ady;
+
+  gdouble alift = adx * adx + ady * ady;
+  gdouble blift = bdx * bdx + bdy * bdy;
+  gdouble clift = cdx * cdx + cdy * cdy;
+
+  gdouble result = alift * (bdxcdy - cdxbdy)
+                 + blift * (cdxady - adxcdy)
+                 + clift * (adxbdy - bdxady);
+
+  gdouble permanent = (ABS (bdxcdy) + ABS (cdxbdy)) * alift
+                    + (ABS (cdxady) + ABS (adxcdy)) * blift
+                    + (ABS (adxbdy) + ABS (bdxady)) * clift;
+
+  if (result <= P2TR_INCIRCLE_ERRBOUND * permanent
+      && -result <= P2TR_INCIRCLE_ERRBOUND * permanent)
+    result = p2tr_exact_incircle (A, B, C, D);
 
-  if (result > INCIRCLE_EPSILON)
+  if (result > 0)
     return P2TR_INCIRCLE_IN;
-  else if (result < INCIRCLE_EPSILON)
+  else if (result < 0)
     return P2TR_INCIRCLE_OUT;
   else
     return P2TR_INCIRCLE_ON;
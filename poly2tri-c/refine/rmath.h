@@ -59,6 +59,52 @@ void      p2tr_math_triangle_circumcircle (const P2trVector2 *A,
                                            const P2trVector2 *C,
                                            P2trCircle    *circle);
 
+/**
+ * Find the center of the circumscribing circle of a triangle defined by
+ * the given points. The computation is done relative to the first
+ * vertex, so it remains accurate even for large coordinates, and it
+ * does not require any square root.
+ * @param[in] A The first vertex of the triangle
+ * @param[in] B The second vertex of the triangle
+ * @param[in] C The third vertex of the triangle
+ * @param[out] center The center of the circumscribing circle
+ * @param[out] radius_sq The squared radius of the circumscribing
+ *             circle. May be NULL
+ */
+void      p2tr_math_triangle_circumcenter (const P2trVector2 *A,
+                                           const P2trVector2 *B,
+                                           const P2trVector2 *C,
+                                           P2trVector2       *center,
+                                           gdouble           *radius_sq);
+
+/**
+ * Find the off-center of a triangle defined by the given points. This
+ * is the point on the bisector of the shortest edge of the triangle,
+ * from which that edge is seen at the given angle, or the circumcenter
+ * if it's closer to the shortest edge than that point.
+ * @param[in] A The first vertex of the triangle
+ * @param[in] B The second vertex of the triangle
+ * @param[in] C The third vertex of the triangle
+ * @param[in] min_angle The desired minimal angle of the triangle
+ * @param[out] center The off-center of the triangle
+ * @param[out] radius_sq The squared distance from the off-center to the
+ *             vertices of the shortest edge. May be NULL
+ */
+void      p2tr_math_triangle_offcenter    (const P2trVector2 *A,
+                                           const P2trVector2 *B,
+                                           const P2trVector2 *C,
+                                           gdouble            min_angle,
+                                           P2trVector2       *center,
+                                           gdouble           *radius_sq);
+
+/**
+ * Find the smallest angle of the triangle defined by the given points,
+ * in radians. The order of the points doesn't matter.
+ */
+gdouble   p2tr_math_triangle_min_angle    (const P2trVector2 *A,
+                                           const P2trVector2 *B,
+                                           const P2trVector2 *C);
+
 typedef enum
 {
   P2TR_INTRIANGLE_OUT = -1,
@@ -106,10 +152,25 @@ typedef enum
   P2TR_ORIENTATION_CCW = 1
 } P2trOrientation;
 
+/**
+ * Find the orientation of three points. The result is exact, meaning
+ * that @ref P2TR_ORIENTATION_LINEAR is returned only if the points are
+ * exactly colinear.
+ */
 P2trOrientation p2tr_math_orient2d (const P2trVector2 *A,
                                     const P2trVector2 *B,
                                     const P2trVector2 *C);
 
+/**
+ * Like @ref p2tr_math_orient2d, but treat points which are almost
+ * colinear as colinear. This should only be used for deciding whether
+ * a new point should be snapped onto an existing edge, and never for
+ * deciding the structure of the triangulation.
+ */
+P2trOrientation p2tr_math_orient2d_approx (const P2trVector2 *A,
+                                           const P2trVector2 *B,
+                                           const P2trVector2 *C);
+
 typedef enum
 {
   P2TR_INCIRCLE_IN,
@@ -117,6 +178,11 @@ typedef enum
   P2TR_INCIRCLE_OUT
 } P2trInCircle;
 
+/**
+ * Test whether D is inside the circumcircle of the triangle ABC. The
+ * points of the triangle must be given in counter-clockwise order. The
+ * result is exact.
+ */
 P2trInCircle p2tr_math_incircle (const P2trVector2 *A,
                                  const P2trVector2 *B,
                                  const P2trVector2 *C,
@@ -0,0 +1,416 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <glib.h>
+#include "rutils.h"
+#include "rmath.h"
+
+#include "point.h"
+#include "edge.h"
+#include "triangle.h"
+#include "mesh.h"
+#include "rcdt.h"
+#include "simplifier.h"
+
+struct P2trSimplifier_
+{
+  P2trCDT              *cdt;
+  P2trSimplifierParams  params;
+
+  /** The removable points, sorted by ascending cost of removal */
+  GSequence            *queue;
+  /** The position in the queue (a GSequenceIter) of each point in it */
+  GHashTable           *entries;
+
+  /**
+   * The removed points with their values, bucketed in a uniform grid
+   * over the bounds of the mesh. Each cell is a GArray of
+   * P2trSimplifierSample, or NULL if it's empty. Only used if there is
+   * a value function
+   */
+  GArray              **cells;
+  guint                 grid_w, grid_h;
+  gdouble               min_x, min_y, cell_size;
+};
+
+typedef struct
+{
+  P2trPoint *point;
+  gdouble    cost;
+} P2trSimplifierEntry;
+
+typedef struct
+{
+  P2trVector2 c;
+  gdouble     value;
+} P2trSimplifierSample;
+
+static void
+p2tr_simplifier_entry_free (gpointer data)
+{
+  P2trSimplifierEntry *entry = (P2trSimplifierEntry*) data;
+
+  p2tr_point_unref (entry->point);
+  g_slice_free (P2trSimplifierEntry, entry);
+}
+
+static gint
+p2tr_simplifier_entry_compare (gconstpointer a,
+                               gconstpointer b,
+                               gpointer      user_data)
+{
+  gdouble cost_a = ((const P2trSimplifierEntry*) a)->cost;
+  gdouble cost_b = ((const P2trSimplifierEntry*) b)->cost;
+
+  return (cost_a < cost_b) ? -1 : ((cost_a > cost_b) ? 1 : 0);
+}
+
+static void
+p2tr_simplifier_cell_of (P2trSimplifier *self,
+                         gdouble         x,
+                         gdouble         y,
+                         guint          *cx,
+                         guint          *cy)
+{
+  gdouble gx = floor ((x - self->min_x) / self->cell_size);
+  gdouble gy = floor ((y - self->min_y) / self->cell_size);
+
+  *cx = (guint) CLAMP (gx, 0, self->grid_w - 1);
+  *cy = (guint) CLAMP (gy, 0, self->grid_h - 1);
+}
+
+static void
+p2tr_simplifier_add_sample (P2trSimplifier *self,
+                            P2trPoint      *pt)
+{
+  P2trSimplifierSample sample;
+  GArray **cell;
+  guint    cx, cy;
+
+  sample.c = pt->c;
+  sample.value = self->params.value_func (pt, self->params.value_data);
+
+  p2tr_simplifier_cell_of (self, pt->c.x, pt->c.y, &cx, &cy);
+  cell = &self->cells[cy * self->grid_w + cx];
+  if (*cell == NULL)
+    *cell = g_array_new (FALSE, FALSE, sizeof (P2trSimplifierSample));
+  g_array_append_val (*cell, sample);
+}
+
+/**
+ * Interpolate the value at a position from the triangles which would
+ * replace a removed point. Returns FALSE if the position is outside of
+ * these triangles
+ */
+static gboolean
+p2tr_simplifier_interpolate (const P2trSimplifierParams  *params,
+                             P2trPoint                  **tris,
+                             guint                        count,
+                             const P2trVector2           *c,
+                             gdouble                     *value)
+{
+  guint i;
+
+  for (i = 0; i < count; i++)
+    {
+      P2trPoint *A = tris[3 * i], *B = tris[3 * i + 1], *C = tris[3 * i + 2];
+      gdouble    u, v;
+
+      if (p2tr_math_intriangle2 (&A->c, &B->c, &C->c, c, &u, &v) != P2TR_INTRIANGLE_OUT)
+        {
+          gdouble value_a = params->value_func (A, params->value_data);
+          gdouble value_b = params->value_func (B, params->value_data);
+          gdouble value_c = params->value_func (C, params->value_data);
+
+          /* u is the weight of C and v is the weight of B */
+          *value = value_a + u * (value_c - value_a) + v * (value_b - value_a);
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/**
+ * Find the largest difference between the value at a point being
+ * removed, or at any point removed before inside the triangles around
+ * it, and the value interpolated from the triangles replacing them.
+ * Stops early once the difference is larger than the maximal error
+ */
+static gdouble
+p2tr_simplifier_removal_error (P2trSimplifier  *self,
+                               P2trPoint       *pt,
+                               P2trPoint      **tris,
+                               guint            count)
+{
+  const P2trSimplifierParams *params = &self->params;
+  gdouble min_x = pt->c.x, min_y = pt->c.y, max_x = pt->c.x, max_y = pt->c.y;
+  gdouble error = 0, value;
+  guint   min_cx, min_cy, max_cx, max_cy, cx, cy, i;
+
+  if (p2tr_simplifier_interpolate (params, tris, count, &pt->c, &value))
+    error = ABS (params->value_func (pt, params->value_data) - value);
+
+  /* The new triangles cover exactly the triangles around the point, so
+   * only the removed points inside them may be interpolated
+   * differently */
+  for (i = 0; i < 3 * count; i++)
+    {
+      min_x = MIN (min_x, tris[i]->c.x);
+      min_y = MIN (min_y, tris[i]->c.y);
+      max_x = MAX (max_x, tris[i]->c.x);
+      max_y = MAX (max_y, tris[i]->c.y);
+    }
+
+  p2tr_simplifier_cell_of (self, min_x, min_y, &min_cx, &min_cy);
+  p2tr_simplifier_cell_of (self, max_x, max_y, &max_cx, &max_cy);
+
+  for (cy = min_cy; cy <= max_cy && error <= params->max_error; cy++)
+    for (cx = min_cx; cx <= max_cx && error <= params->max_error; cx++)
+      {
+        GArray *cell = self->cells[cy * self->grid_w + cx];
+
+        if (cell == NULL)
+          continue;
+
+        for (i = 0; i < cell->len && error <= params->max_error; i++)
+          {
+            P2trSimplifierSample *sample = &g_array_index (cell, P2trSimplifierSample, i);
+            if (p2tr_simplifier_interpolate (params, tris, count, &sample->c, &value))
+              error = MAX (error, ABS (sample->value - value));
+          }
+      }
+
+  return error;
+}
+
+/**
+ * Check whether removing a point would keep the bounds of the
+ * simplifier, and if so find the cost of removing it
+ */
+static gboolean
+p2tr_simplifier_evaluate (P2trSimplifier *self,
+                          P2trPoint      *pt,
+                          gdouble        *cost)
+{
+  const P2trSimplifierParams *params = &self->params;
+  P2trPoint **tris;
+  GList      *iter;
+  gdouble     old_angle = G_MAXDOUBLE, new_angle = G_MAXDOUBLE;
+  gdouble     shortest_sq = G_MAXDOUBLE, error = 0;
+  gboolean    ok = TRUE;
+  guint       count, i;
+
+  if (! p2tr_cdt_point_is_removable (self->cdt, pt))
+    return FALSE;
+
+  for (iter = pt->outgoing_edges; iter != NULL; iter = iter->next)
+    {
+      P2trEdge  *e = (P2trEdge*) iter->data;
+      P2trPoint *C = p2tr_triangle_get_opposite_point (e->tri, e, FALSE);
+
+      old_angle = MIN (old_angle, p2tr_math_triangle_min_angle (&pt->c, &e->end->c, &C->c));
+      shortest_sq = MIN (shortest_sq, p2tr_math_length_sq2 (&pt->c, &e->end->c));
+    }
+
+  tris = p2tr_cdt_predict_point_removal (self->cdt, pt, &count);
+
+  for (i = 0; i < count && ok; i++)
+    {
+      P2trPoint *A = tris[3 * i], *B = tris[3 * i + 1], *C = tris[3 * i + 2];
+
+      new_angle = MIN (new_angle, p2tr_math_triangle_min_angle (&A->c, &B->c, &C->c));
+
+      if (params->max_area > 0
+          && ABS ((B->c.x - A->c.x) * (C->c.y - A->c.y)
+                  - (B->c.y - A->c.y) * (C->c.x - A->c.x)) / 2 > params->max_area)
+        ok = FALSE;
+    }
+
+  if (new_angle < MIN (params->min_angle, old_angle))
+    ok = FALSE;
+
+  if (ok && params->value_func != NULL)
+    error = p2tr_simplifier_removal_error (self, pt, tris, count);
+
+  g_free (tris);
+
+  if (params->value_func != NULL)
+    {
+      ok = ok && error <= params->max_error;
+      *cost = error;
+    }
+  else
+    *cost = sqrt (shortest_sq);
+
+  return ok;
+}
+
+/**
+ * Evaluate a point again, after the triangles around it were changed
+ */
+static void
+p2tr_simplifier_update (P2trSimplifier *self,
+                        P2trPoint      *pt)
+{
+  GSequenceIter *iter = (GSequenceIter*) g_hash_table_lookup (self->entries, pt);
+  gdouble        cost;
+
+  if (iter != NULL)
+    {
+      g_hash_table_remove (self->entries, pt);
+      g_sequence_remove (iter);
+    }
+
+  if (p2tr_simplifier_evaluate (self, pt, &cost))
+    {
+      P2trSimplifierEntry *entry = g_slice_new (P2trSimplifierEntry);
+
+      entry->point = p2tr_point_ref (pt);
+      entry->cost = cost;
+      g_hash_table_insert (self->entries, pt, g_sequence_insert_sorted (
+          self->queue, entry, p2tr_simplifier_entry_compare, NULL));
+    }
+}
+
+void
+p2tr_simplifier_params_init (P2trSimplifierParams *params)
+{
+  params->min_angle = 0;
+  params->max_area = 0;
+  params->value_func = NULL;
+  params->value_data = NULL;
+  params->max_error = 0;
+}
+
+P2trSimplifier*
+p2tr_simplifier_new (P2trCDT                    *cdt,
+                     const P2trSimplifierParams *params)
+{
+  P2trSimplifier   *self = g_slice_new (P2trSimplifier);
+  P2trDenseSetIter  iter;
+  P2trPoint        *pt;
+
+  self->cdt = cdt;
+  if (params != NULL)
+    self->params = *params;
+  else
+    p2tr_simplifier_params_init (&self->params);
+
+  self->queue = g_sequence_new (p2tr_simplifier_entry_free);
+  self->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  self->cells = NULL;
+  self->grid_w = self->grid_h = 0;
+  self->min_x = self->min_y = 0;
+  self->cell_size = 1;
+
+  /* Removing points never extends the mesh, so a grid over its bounds
+   * with about one cell per point can hold all the removed points */
+  if (self->params.value_func != NULL
+      && p2tr_dense_set_size (cdt->mesh->points) > 0)
+    {
+      gdouble max_x, max_y;
+      guint   n = p2tr_dense_set_size (cdt->mesh->points);
+
+      p2tr_mesh_get_bounds (cdt->mesh, &self->min_x, &self->min_y, &max_x, &max_y);
+      self->cell_size = sqrt ((max_x - self->min_x) * (max_y - self->min_y) / n);
+      if (! (self->cell_size > 0))
+        self->cell_size = MAX (max_x - self->min_x, max_y - self->min_y) + 1;
+
+      self->grid_w = (guint) floor ((max_x - self->min_x) / self->cell_size) + 1;
+      self->grid_h = (guint) floor ((max_y - self->min_y) / self->cell_size) + 1;
+      self->cells = g_new0 (GArray*, self->grid_w * self->grid_h);
+    }
+
+  p2tr_dense_set_iter_init (&iter, cdt->mesh->points);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&pt))
+    p2tr_simplifier_update (self, pt);
+
+  return self;
+}
+
+void
+p2tr_simplifier_free (P2trSimplifier *self)
+{
+  guint i;
+
+  for (i = 0; i < self->grid_w * self->grid_h; i++)
+    if (self->cells[i] != NULL)
+      g_array_free (self->cells[i], TRUE);
+  g_free (self->cells);
+
+  g_hash_table_destroy (self->entries);
+  g_sequence_free (self->queue);
+  g_slice_free (P2trSimplifier, self);
+}
+
+guint
+p2tr_simplifier_simplify (P2trSimplifier *self,
+                          guint           target_points)
+{
+  guint removed = 0;
+
+  while (g_sequence_get_length (self->queue) > 0
+         && p2tr_dense_set_size (self->cdt->mesh->points) > target_points)
+    {
+      GSequenceIter *first = g_sequence_get_begin_iter (self->queue);
+      P2trPoint     *pt = p2tr_point_ref (((P2trSimplifierEntry*) g_sequence_get (first))->point);
+      GList         *neighbors = NULL, *iter;
+
+      g_hash_table_remove (self->entries, pt);
+      g_sequence_remove (first);
+
+      /* Only the points around the removed point get new triangles, so
+       * only their costs change */
+      for (iter = pt->outgoing_edges; iter != NULL; iter = iter->next)
+        neighbors = g_list_prepend (neighbors,
+            p2tr_point_ref (((P2trEdge*) iter->data)->end));
+
+      if (self->params.value_func != NULL)
+        p2tr_simplifier_add_sample (self, pt);
+
+      p2tr_cdt_remove_point (self->cdt, pt);
+      p2tr_point_unref (pt);
+      removed++;
+
+      for (iter = neighbors; iter != NULL; iter = iter->next)
+        {
+          p2tr_simplifier_update (self, (P2trPoint*) iter->data);
+          p2tr_point_unref ((P2trPoint*) iter->data);
+        }
+      g_list_free (neighbors);
+    }
+
+  return removed;
+}
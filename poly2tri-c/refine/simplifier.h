@@ -0,0 +1,126 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __P2TC_REFINE_SIMPLIFIER_H__
+#define __P2TC_REFINE_SIMPLIFIER_H__
+
+#include <glib.h>
+#include "rcdt.h"
+
+/**
+ * \defgroup P2trSimplifier P2trSimplifier - Mesh Simplification
+ * Coarsening a triangulation by removing points, while keeping it a
+ * CDT. Each removal collapses the edges around a point into the
+ * delaunay triangulation of its neighbors (see
+ * @ref p2tr_cdt_remove_point). Points of constrained edges are never
+ * removed, so the domain and its segments are kept exactly.
+ *
+ * The points are kept in a priority queue ordered by the cost of
+ * removing them, and only the neighbors of a removed point are
+ * evaluated again. The queue is kept between calls to
+ * @ref p2tr_simplifier_simplify, so several levels of detail can be
+ * produced from one fine mesh by simplifying it to smaller and smaller
+ * amounts of points, and saving the mesh in between.
+ * @{
+ */
+
+typedef struct P2trSimplifier_ P2trSimplifier;
+
+/**
+ * A function returning a value associated with a point of the mesh
+ * (such as a height or a color channel), which is interpolated linearly
+ * over the triangles
+ */
+typedef gdouble (*P2trPointValueFunc) (P2trPoint *point,
+                                       gpointer   user_data);
+
+/**
+ * The bounds on the simplification. A point is only removed if all of
+ * them hold for the triangles that replace it
+ */
+typedef struct
+{
+  /** The smallest angle allowed in the new triangles, in radians,
+   *  unless there was a smaller angle around the removed point
+   *  already. 0 for no limit */
+  gdouble             min_angle;
+  /** The maximal area of the new triangles, or 0 for no limit */
+  gdouble             max_area;
+  /** The value which should be approximated by the mesh, or NULL.
+   *  Without a value, the points with the shortest edges are removed
+   *  first. With a value, the points whose value is approximated best
+   *  by the triangles that replace them are removed first */
+  P2trPointValueFunc  value_func;
+  /** User data for @ref value_func */
+  gpointer            value_data;
+  /** The maximal difference between the value at any removed point
+   *  and the value interpolated at its position from the simplified
+   *  mesh. Only used if there is a @ref value_func. The bound is kept
+   *  by checking each removal against all the points removed before
+   *  inside the triangles it replaces, so it assumes that the
+   *  triangulation has no metric (which could flip edges further
+   *  away) */
+  gdouble             max_error;
+} P2trSimplifierParams;
+
+/**
+ * Initialize the bounds of a simplification to have no limits
+ */
+void             p2tr_simplifier_params_init (P2trSimplifierParams       *params);
+
+/**
+ * Create a simplifier for a triangulation. The triangulation must not
+ * be changed by anything else while the simplifier exists
+ * @param cdt The triangulation to simplify
+ * @param params The bounds on the simplification, or NULL for no
+ *        bounds
+ */
+P2trSimplifier*  p2tr_simplifier_new         (P2trCDT                    *cdt,
+                                              const P2trSimplifierParams *params);
+
+void             p2tr_simplifier_free        (P2trSimplifier             *self);
+
+/**
+ * Remove points from the triangulation, cheapest first, until it has
+ * the requested amount of points or until no more points can be
+ * removed without breaking the bounds of the simplifier
+ * @param self The simplifier
+ * @param target_points The amount of points to stop at, or 0 to remove
+ *        as many points as possible
+ * @return The amount of points which were removed
+ */
+guint            p2tr_simplifier_simplify    (P2trSimplifier             *self,
+                                              guint                       target_points);
+
+/** @} */
+
+#endif
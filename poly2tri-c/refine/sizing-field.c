@@ -0,0 +1,506 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <glib.h>
+#include "rutils.h"
+
+#include "mesh.h"
+#include "point.h"
+#include "edge.h"
+#include "triangle.h"
+#include "sizing-field.h"
+
+/** The amount of triangles tested together by the batch functions */
+#define P2TR_SIZING_BLOCK 64
+
+static P2trSizingField*
+p2tr_sizing_field_new (P2trSizingFieldType type)
+{
+  P2trSizingField *self = g_slice_new0 (P2trSizingField);
+  self->type = type;
+  self->refcount = 1;
+  return self;
+}
+
+P2trSizingField*
+p2tr_sizing_field_new_constant (gdouble max_area)
+{
+  P2trSizingField *self = p2tr_sizing_field_new (P2TR_SIZING_CONSTANT);
+  self->data.constant.max_area = max_area;
+  return self;
+}
+
+P2trSizingField*
+p2tr_sizing_field_new_grid (gdouble       min_x,
+                            gdouble       min_y,
+                            gdouble       step_x,
+                            gdouble       step_y,
+                            guint         width,
+                            guint         height,
+                            const gfloat *max_areas)
+{
+  P2trSizingField *self;
+
+  if (width == 0 || height == 0 || step_x <= 0 || step_y <= 0)
+    p2tr_exception_programmatic ("Invalid sizing grid dimensions!");
+
+  self = p2tr_sizing_field_new (P2TR_SIZING_GRID);
+  self->data.grid.min_x = min_x;
+  self->data.grid.min_y = min_y;
+  self->data.grid.step_x = step_x;
+  self->data.grid.step_y = step_y;
+  self->data.grid.width = width;
+  self->data.grid.height = height;
+  self->data.grid.max_areas = g_new (gfloat, width * height);
+  memcpy (self->data.grid.max_areas, max_areas,
+      width * height * sizeof (gfloat));
+  return self;
+}
+
+/**
+ * Find the range of buckets covering a range of coordinates, clamped
+ * to the grid of buckets
+ */
+static void
+p2tr_sizing_bucket_range (gdouble  min,
+                          gdouble  max,
+                          gdouble  origin,
+                          gdouble  size,
+                          guint    count,
+                          guint   *first,
+                          guint   *last)
+{
+  gdouble f = floor ((min - origin) / size);
+  gdouble l = floor ((max - origin) / size);
+  *first = (guint) CLAMP (f, 0, count - 1);
+  *last = (guint) CLAMP (l, 0, count - 1);
+}
+
+P2trSizingField*
+p2tr_sizing_field_new_boundary_distance (P2trMesh *mesh,
+                                         gdouble   min_area,
+                                         gdouble   grade,
+                                         gdouble   max_area)
+{
+  P2trSizingField  *self = p2tr_sizing_field_new (P2TR_SIZING_BOUNDARY_DISTANCE);
+  P2trDenseSetIter  iter;
+  P2trEdge         *e;
+  GArray           *segs = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  gdouble           min_x = G_MAXDOUBLE, min_y = G_MAXDOUBLE;
+  gdouble           max_x = -G_MAXDOUBLE, max_y = -G_MAXDOUBLE;
+  guint             n, i, b, cols, rows, bucket_count;
+  guint             x0, x1, y0, y1, x, y;
+  guint            *fill;
+
+  /* The edge length of an equilateral triangle whose area is min_area */
+  self->data.boundary.min_length = sqrt (4 * min_area / sqrt (3));
+  self->data.boundary.grade = grade;
+  self->data.boundary.max_area = max_area;
+
+  /* Copy each constrained edge once (and not once for each direction) */
+  p2tr_dense_set_iter_init (&iter, mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&e))
+    if (e->constrained && e->handle < e->mirror->handle)
+      {
+        P2trVector2 *start = &P2TR_EDGE_START (e)->c;
+        gdouble coords[4];
+
+        coords[0] = start->x;
+        coords[1] = start->y;
+        coords[2] = e->end->c.x;
+        coords[3] = e->end->c.y;
+        g_array_append_vals (segs, coords, 4);
+
+        min_x = MIN (min_x, MIN (coords[0], coords[2]));
+        min_y = MIN (min_y, MIN (coords[1], coords[3]));
+        max_x = MAX (max_x, MAX (coords[0], coords[2]));
+        max_y = MAX (max_y, MAX (coords[1], coords[3]));
+      }
+
+  n = segs->len / 4;
+  self->data.boundary.segment_count = n;
+  self->data.boundary.segments = (gdouble*) g_array_free (segs, FALSE);
+
+  if (n == 0)
+    return self;
+
+  /* Use about one bucket per segment */
+  cols = rows = MAX (1, (guint) ceil (sqrt (n)));
+  self->data.boundary.min_x = min_x;
+  self->data.boundary.min_y = min_y;
+  self->data.boundary.bucket_w = MAX (max_x - min_x, 1e-9) / cols;
+  self->data.boundary.bucket_h = MAX (max_y - min_y, 1e-9) / rows;
+  self->data.boundary.cols = cols;
+  self->data.boundary.rows = rows;
+
+  bucket_count = cols * rows;
+  self->data.boundary.bucket_start = g_new0 (guint, bucket_count + 1);
+  fill = g_new0 (guint, bucket_count);
+
+  /* Two passes - first count the segments in each bucket, then fill
+   * them in */
+  for (b = 0; b < 2; b++)
+    {
+      for (i = 0; i < n; i++)
+        {
+          const gdouble *s = self->data.boundary.segments + 4 * i;
+
+          p2tr_sizing_bucket_range (MIN (s[0], s[2]), MAX (s[0], s[2]),
+              min_x, self->data.boundary.bucket_w, cols, &x0, &x1);
+          p2tr_sizing_bucket_range (MIN (s[1], s[3]), MAX (s[1], s[3]),
+              min_y, self->data.boundary.bucket_h, rows, &y0, &y1);
+
+          for (y = y0; y <= y1; y++)
+            for (x = x0; x <= x1; x++)
+              {
+                guint bucket = y * cols + x;
+                if (b == 0)
+                  self->data.boundary.bucket_start[bucket + 1]++;
+                else
+                  self->data.boundary.bucket_items[
+                      self->data.boundary.bucket_start[bucket] + fill[bucket]++] = i;
+              }
+        }
+
+      if (b == 0)
+        {
+          for (i = 0; i < bucket_count; i++)
+            self->data.boundary.bucket_start[i + 1] += self->data.boundary.bucket_start[i];
+          self->data.boundary.bucket_items =
+              g_new (guint, self->data.boundary.bucket_start[bucket_count]);
+        }
+    }
+
+  g_free (fill);
+  return self;
+}
+
+P2trSizingField*
+p2tr_sizing_field_new_composite (P2trSizingField **fields,
+                                 guint             count)
+{
+  P2trSizingField *self = p2tr_sizing_field_new (P2TR_SIZING_COMPOSITE);
+  guint i;
+
+  self->data.composite.fields = g_new (P2trSizingField*, count);
+  self->data.composite.count = count;
+  for (i = 0; i < count; i++)
+    self->data.composite.fields[i] = p2tr_sizing_field_ref (fields[i]);
+  return self;
+}
+
+P2trSizingField*
+p2tr_sizing_field_new_callback (P2trTriangleTooBig func)
+{
+  P2trSizingField *self = p2tr_sizing_field_new (P2TR_SIZING_CALLBACK);
+  self->data.callback.func = func;
+  return self;
+}
+
+P2trSizingField*
+p2tr_sizing_field_ref (P2trSizingField *self)
+{
+  ++self->refcount;
+  return self;
+}
+
+void
+p2tr_sizing_field_unref (P2trSizingField *self)
+{
+  g_assert (self->refcount > 0);
+  if (--self->refcount == 0)
+    p2tr_sizing_field_free (self);
+}
+
+void
+p2tr_sizing_field_free (P2trSizingField *self)
+{
+  guint i;
+
+  switch (self->type)
+    {
+      case P2TR_SIZING_GRID:
+        g_free (self->data.grid.max_areas);
+        break;
+      case P2TR_SIZING_BOUNDARY_DISTANCE:
+        g_free (self->data.boundary.segments);
+        g_free (self->data.boundary.bucket_start);
+        g_free (self->data.boundary.bucket_items);
+        break;
+      case P2TR_SIZING_COMPOSITE:
+        for (i = 0; i < self->data.composite.count; i++)
+          p2tr_sizing_field_unref (self->data.composite.fields[i]);
+        g_free (self->data.composite.fields);
+        break;
+      case P2TR_SIZING_CONSTANT:
+      case P2TR_SIZING_CALLBACK:
+        break;
+    }
+
+  g_slice_free (P2trSizingField, self);
+}
+
+static gdouble
+p2tr_sizing_grid_sample (P2trSizingField *self,
+                         gdouble          x,
+                         gdouble          y)
+{
+  guint   w = self->data.grid.width, h = self->data.grid.height;
+  gdouble fx, fy, tx, ty;
+  guint   x0, y0, x1, y1;
+  const gfloat *v = self->data.grid.max_areas;
+
+  fx = CLAMP ((x - self->data.grid.min_x) / self->data.grid.step_x, 0, w - 1);
+  fy = CLAMP ((y - self->data.grid.min_y) / self->data.grid.step_y, 0, h - 1);
+
+  x0 = (guint) fx;
+  y0 = (guint) fy;
+  x1 = MIN (x0 + 1, w - 1);
+  y1 = MIN (y0 + 1, h - 1);
+  tx = fx - x0;
+  ty = fy - y0;
+
+  return (1 - ty) * ((1 - tx) * v[y0 * w + x0] + tx * v[y0 * w + x1])
+      + ty * ((1 - tx) * v[y1 * w + x0] + tx * v[y1 * w + x1]);
+}
+
+static gdouble
+p2tr_sizing_segment_distance_sq (const gdouble *s,
+                                 gdouble        x,
+                                 gdouble        y)
+{
+  gdouble dx = s[2] - s[0], dy = s[3] - s[1];
+  gdouble px = x - s[0], py = y - s[1];
+  gdouble len_sq = dx * dx + dy * dy;
+  gdouble t = (len_sq > 0) ? (px * dx + py * dy) / len_sq : 0;
+
+  t = CLAMP (t, 0, 1);
+  px -= t * dx;
+  py -= t * dy;
+  return px * px + py * py;
+}
+
+/**
+ * Find the distance from a point to the nearest boundary segment, by
+ * searching growing rings of buckets around the bucket of the point
+ * until no unsearched bucket can contain anything nearer
+ */
+static gdouble
+p2tr_sizing_boundary_distance (P2trSizingField *self,
+                               gdouble          x,
+                               gdouble          y)
+{
+  guint   cols = self->data.boundary.cols, rows = self->data.boundary.rows;
+  gdouble bw = self->data.boundary.bucket_w, bh = self->data.boundary.bucket_h;
+  gdouble ox = self->data.boundary.min_x, oy = self->data.boundary.min_y;
+  gdouble best = G_MAXDOUBLE;
+  guint   cx, cy, r;
+
+  if (self->data.boundary.segment_count == 0)
+    return G_MAXDOUBLE;
+
+  p2tr_sizing_bucket_range (x, x, ox, bw, cols, &cx, &cx);
+  p2tr_sizing_bucket_range (y, y, oy, bh, rows, &cy, &cy);
+
+  for (r = 0; ; r++)
+    {
+      guint x0 = (cx >= r) ? cx - r : 0, x1 = MIN (cx + r, cols - 1);
+      guint y0 = (cy >= r) ? cy - r : 0, y1 = MIN (cy + r, rows - 1);
+      gdouble margin;
+      guint bx, by, i;
+
+      for (by = y0; by <= y1; by++)
+        for (bx = x0; bx <= x1; bx++)
+          {
+            guint bucket = by * cols + bx;
+
+            /* Only the outline of the ring is new */
+            if (r > 0 && by != cy - r && by != cy + r
+                && bx != cx - r && bx != cx + r)
+              continue;
+
+            for (i = self->data.boundary.bucket_start[bucket];
+                 i < self->data.boundary.bucket_start[bucket + 1]; i++)
+              {
+                const gdouble *s = self->data.boundary.segments
+                    + 4 * self->data.boundary.bucket_items[i];
+                best = MIN (best, p2tr_sizing_segment_distance_sq (s, x, y));
+              }
+          }
+
+      if (x0 == 0 && y0 == 0 && x1 == cols - 1 && y1 == rows - 1)
+        break;
+
+      /* Anything outside of the searched buckets is at least this far */
+      margin = MIN (MIN (x - (ox + x0 * bw), (ox + (x1 + 1) * bw) - x),
+                    MIN (y - (oy + y0 * bh), (oy + (y1 + 1) * bh) - y));
+      if (margin > 0 && best <= margin * margin)
+        break;
+    }
+
+  return sqrt (best);
+}
+
+static gdouble
+p2tr_sizing_boundary_max_area (P2trSizingField *self,
+                               gdouble          x,
+                               gdouble          y)
+{
+  gdouble d = p2tr_sizing_boundary_distance (self, x, y);
+  gdouble len, area;
+
+  if (d == G_MAXDOUBLE)
+    return self->data.boundary.max_area;
+
+  len = self->data.boundary.min_length + self->data.boundary.grade * d;
+  area = len * len * (sqrt (3) / 4);
+  return MIN (area, self->data.boundary.max_area);
+}
+
+/**
+ * Evaluate the maximal area of a block of triangles, given their
+ * centroids. Callback fields report a negative area for triangles
+ * which are too big, and G_MAXDOUBLE for the rest
+ */
+static void
+p2tr_sizing_field_eval (P2trSizingField  *self,
+                        P2trTriangle    **tris,
+                        const gdouble    *cx,
+                        const gdouble    *cy,
+                        guint             count,
+                        gdouble          *max_area)
+{
+  gdouble tmp[P2TR_SIZING_BLOCK];
+  guint i, j;
+
+  switch (self->type)
+    {
+      case P2TR_SIZING_CONSTANT:
+        for (i = 0; i < count; i++)
+          max_area[i] = self->data.constant.max_area;
+        break;
+
+      case P2TR_SIZING_GRID:
+        for (i = 0; i < count; i++)
+          max_area[i] = p2tr_sizing_grid_sample (self, cx[i], cy[i]);
+        break;
+
+      case P2TR_SIZING_BOUNDARY_DISTANCE:
+        for (i = 0; i < count; i++)
+          max_area[i] = p2tr_sizing_boundary_max_area (self, cx[i], cy[i]);
+        break;
+
+      case P2TR_SIZING_COMPOSITE:
+        for (i = 0; i < count; i++)
+          max_area[i] = G_MAXDOUBLE;
+        for (j = 0; j < self->data.composite.count; j++)
+          {
+            p2tr_sizing_field_eval (self->data.composite.fields[j],
+                tris, cx, cy, count, tmp);
+            for (i = 0; i < count; i++)
+              max_area[i] = MIN (max_area[i], tmp[i]);
+          }
+        break;
+
+      case P2TR_SIZING_CALLBACK:
+        for (i = 0; i < count; i++)
+          max_area[i] = self->data.callback.func (tris[i]) ? -1 : G_MAXDOUBLE;
+        break;
+    }
+}
+
+gdouble
+p2tr_sizing_field_max_area (P2trSizingField   *self,
+                            const P2trVector2 *pt)
+{
+  gdouble result;
+
+  if (self->type == P2TR_SIZING_CALLBACK)
+    return G_MAXDOUBLE;
+
+  if (self->type == P2TR_SIZING_COMPOSITE)
+    {
+      guint j;
+      result = G_MAXDOUBLE;
+      for (j = 0; j < self->data.composite.count; j++)
+        result = MIN (result,
+            p2tr_sizing_field_max_area (self->data.composite.fields[j], pt));
+      return result;
+    }
+
+  p2tr_sizing_field_eval (self, NULL, &pt->x, &pt->y, 1, &result);
+  return result;
+}
+
+gboolean
+p2tr_sizing_field_too_big_full (P2trSizingField *self,
+                                P2trTriangle    *tri)
+{
+  gboolean result;
+  p2tr_sizing_field_too_big_batch (self, &tri, 1, &result);
+  return result;
+}
+
+void
+p2tr_sizing_field_too_big_batch (P2trSizingField  *self,
+                                 P2trTriangle    **tris,
+                                 guint             count,
+                                 gboolean         *result)
+{
+  gdouble cx[P2TR_SIZING_BLOCK], cy[P2TR_SIZING_BLOCK];
+  gdouble area[P2TR_SIZING_BLOCK], max_area[P2TR_SIZING_BLOCK];
+  guint start, n, i;
+
+  for (start = 0; start < count; start += n)
+    {
+      n = MIN (count - start, P2TR_SIZING_BLOCK);
+
+      for (i = 0; i < n; i++)
+        {
+          P2trTriangle *t = tris[start + i];
+          const P2trVector2 *A = &t->edges[0]->end->c;
+          const P2trVector2 *B = &t->edges[1]->end->c;
+          const P2trVector2 *C = &t->edges[2]->end->c;
+
+          cx[i] = (A->x + B->x + C->x) / 3;
+          cy[i] = (A->y + B->y + C->y) / 3;
+          area[i] = p2tr_triangle_get_quality (t)->area;
+        }
+
+      p2tr_sizing_field_eval (self, tris + start, cx, cy, n, max_area);
+
+      for (i = 0; i < n; i++)
+        result[start + i] = area[i] > max_area[i];
+    }
+}
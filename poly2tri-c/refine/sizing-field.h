@@ -0,0 +1,240 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __P2TC_REFINE_SIZING_FIELD_H__
+#define __P2TC_REFINE_SIZING_FIELD_H__
+
+#include <glib.h>
+#include "vector2.h"
+#include "triangulation.h"
+#include "triangle.h"
+#include "refiner.h"
+
+/**
+ * \defgroup P2trSizingField P2trSizingField - Sizing Fields
+ * Descriptions of the maximal area of triangles across the plane,
+ * used by the refiner to decide which triangles are too big. Each
+ * triangle is tested against the maximal area at its centroid.
+ *
+ * The built-in fields are evaluated directly by the refiner, and
+ * triangles are tested in batches when the whole mesh is scanned.
+ * A callback (\ref P2trTriangleTooBig) may still be used for
+ * anything the built-in fields can't describe.
+ * @{
+ */
+
+/**
+ * The types of sizing fields
+ */
+typedef enum
+{
+  /** The same maximal area everywhere */
+  P2TR_SIZING_CONSTANT,
+  /** A maximal area sampled on a regular grid, interpolated
+   *  bilinearly between the samples */
+  P2TR_SIZING_GRID,
+  /** A maximal area which grows with the distance from the
+   *  constrained edges of the mesh */
+  P2TR_SIZING_BOUNDARY_DISTANCE,
+  /** The minimum of several other sizing fields */
+  P2TR_SIZING_COMPOSITE,
+  /** A \ref P2trTriangleTooBig function */
+  P2TR_SIZING_CALLBACK
+} P2trSizingFieldType;
+
+/**
+ * A struct for a sizing field. The type itself is declared in
+ * refiner.h, which uses it
+ */
+struct P2trSizingField_
+{
+  P2trSizingFieldType type;
+
+  guint refcount;
+
+  union
+  {
+    struct
+    {
+      gdouble  max_area;
+    } constant;
+
+    struct
+    {
+      gdouble  min_x, min_y;
+      gdouble  step_x, step_y;
+      guint    width, height;
+      /** The samples, in row major order */
+      gfloat  *max_areas;
+    } grid;
+
+    struct
+    {
+      /** The length of the edges of an equilateral triangle with the
+       *  minimal area, which is used next to the boundary */
+      gdouble  min_length;
+      /** The amount by which the edge length grows for each unit of
+       *  distance from the boundary */
+      gdouble  grade;
+      gdouble  max_area;
+      /** The end points of the boundary segments - 4 coordinates for
+       *  each segment */
+      gdouble *segments;
+      guint    segment_count;
+      /** A uniform grid of buckets over the bounds of the segments,
+       *  in compressed row storage: the segments in bucket i are
+       *  bucket_items[bucket_start[i] .. bucket_start[i+1]-1] */
+      gdouble  min_x, min_y;
+      gdouble  bucket_w, bucket_h;
+      guint    cols, rows;
+      guint   *bucket_start;
+      guint   *bucket_items;
+    } boundary;
+
+    struct
+    {
+      P2trSizingField **fields;
+      guint             count;
+    } composite;
+
+    struct
+    {
+      P2trTriangleTooBig func;
+    } callback;
+  } data;
+};
+
+/**
+ * Create a sizing field with the same maximal area everywhere
+ * @param max_area The maximal area of triangles
+ */
+P2trSizingField* p2tr_sizing_field_new_constant (gdouble max_area);
+
+/**
+ * Create a sizing field sampled on a regular grid. Outside of the
+ * grid, the nearest samples are used
+ * @param min_x The X coordinate of the first column of samples
+ * @param min_y The Y coordinate of the first row of samples
+ * @param step_x The distance between columns of samples
+ * @param step_y The distance between rows of samples
+ * @param width The amount of columns of samples
+ * @param height The amount of rows of samples
+ * @param max_areas The samples, in row major order. They are copied
+ */
+P2trSizingField* p2tr_sizing_field_new_grid     (gdouble       min_x,
+                                                 gdouble       min_y,
+                                                 gdouble       step_x,
+                                                 gdouble       step_y,
+                                                 guint         width,
+                                                 guint         height,
+                                                 const gfloat *max_areas);
+
+/**
+ * Create a sizing field in which the triangles are small next to the
+ * constrained edges of a mesh, and grow gradually away from them.
+ * The edge length of the triangles grows linearly with the distance
+ * from the nearest constrained edge, starting from the edge length of
+ * an equilateral triangle with the minimal area.
+ *
+ * The constrained edges are copied when the field is created.
+ * Splitting them later (as the refiner does) doesn't change the field.
+ * @param mesh The mesh whose constrained edges are the boundary
+ * @param min_area The maximal area of triangles next to the boundary
+ * @param grade The growth of the edge length per unit of distance
+ * @param max_area The maximal area of triangles anywhere
+ */
+P2trSizingField* p2tr_sizing_field_new_boundary_distance (P2trMesh *mesh,
+                                                          gdouble   min_area,
+                                                          gdouble   grade,
+                                                          gdouble   max_area);
+
+/**
+ * Create a sizing field which is the minimum of several fields. A
+ * triangle is too big for it if it's too big for any of the fields
+ * @param fields The fields to combine. They are reffed
+ * @param count The amount of fields
+ */
+P2trSizingField* p2tr_sizing_field_new_composite (P2trSizingField **fields,
+                                                  guint             count);
+
+/**
+ * Create a sizing field which asks a function whether each triangle
+ * is too big
+ */
+P2trSizingField* p2tr_sizing_field_new_callback (P2trTriangleTooBig func);
+
+P2trSizingField* p2tr_sizing_field_ref          (P2trSizingField *self);
+
+void             p2tr_sizing_field_unref        (P2trSizingField *self);
+
+void             p2tr_sizing_field_free         (P2trSizingField *self);
+
+/**
+ * Find the maximal area of triangles at a given point. For callback
+ * fields (which can only test whole triangles), this is G_MAXDOUBLE
+ */
+gdouble          p2tr_sizing_field_max_area     (P2trSizingField   *self,
+                                                 const P2trVector2 *pt);
+
+/**
+ * Check whether a triangle is too big according to a sizing field.
+ * Use the @ref p2tr_sizing_field_too_big macro, which tests constant
+ * fields inline
+ */
+gboolean         p2tr_sizing_field_too_big_full (P2trSizingField   *self,
+                                                 P2trTriangle      *tri);
+
+/**
+ * Check which triangles of an array are too big according to a sizing
+ * field. This is faster than testing each triangle separately, since
+ * the type of the field is only examined once for the whole array
+ * @param[in] self The sizing field
+ * @param[in] tris The triangles to test
+ * @param[in] count The amount of triangles
+ * @param[out] result For each triangle, whether it's too big
+ */
+void             p2tr_sizing_field_too_big_batch (P2trSizingField  *self,
+                                                  P2trTriangle    **tris,
+                                                  guint             count,
+                                                  gboolean         *result);
+
+/**
+ * Check whether a triangle is too big according to a sizing field
+ */
+#define p2tr_sizing_field_too_big(field,tri)                          \
+  (((field)->type == P2TR_SIZING_CONSTANT)                            \
+   ? (p2tr_triangle_get_quality (tri)->area                           \
+      > (field)->data.constant.max_area)                              \
+   : p2tr_sizing_field_too_big_full ((field), (tri)))
+
+/** @} */
+#endif
@@ -0,0 +1,266 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <glib.h>
+#include "rutils.h"
+#include "rmath.h"
+
+#include "point.h"
+#include "edge.h"
+#include "triangle.h"
+#include "mesh.h"
+#include "rcdt.h"
+#include "vedge.h"
+#include "cdt-flipfix.h"
+#include "smooth.h"
+
+/**
+ * The moves of a range of points, computed by one thread
+ */
+typedef struct
+{
+  P2trDenseSet     *points;
+  P2trSmoothMethod  method;
+  guint             start, end;
+  /** The new position of each point in the range */
+  P2trVector2      *targets;
+  /** Whether each point in the range should be moved */
+  gboolean         *movable;
+} P2trSmoothJob;
+
+/**
+ * Find the new position of a point, from the current positions of
+ * the points around it. Return FALSE if the point must not be moved
+ */
+static gboolean
+p2tr_smooth_compute_target (P2trPoint        *pt,
+                            P2trSmoothMethod  method,
+                            P2trVector2      *dest)
+{
+  GList   *iter;
+  gdouble  x = 0, y = 0, weight = 0;
+
+  for (iter = pt->outgoing_edges; iter != NULL; iter = iter->next)
+    {
+      P2trEdge *e = (P2trEdge*) iter->data;
+
+      /* Points on the outline of the domain always have a constrained
+       * edge, but check the triangles anyway since the moves below
+       * assume the point is surrounded by them */
+      if (e->constrained || e->tri == NULL)
+        return FALSE;
+
+      if (method == P2TR_SMOOTH_ODT)
+        {
+          P2trPoint   *C = p2tr_triangle_get_opposite_point (e->tri, e, FALSE);
+          P2trVector2  center;
+          gdouble      area;
+
+          area = ABS ((e->end->c.x - pt->c.x) * (C->c.y - pt->c.y)
+                      - (e->end->c.y - pt->c.y) * (C->c.x - pt->c.x));
+          p2tr_math_triangle_circumcenter (&pt->c, &e->end->c, &C->c, &center, NULL);
+
+          x += area * center.x;
+          y += area * center.y;
+          weight += area;
+        }
+      else
+        {
+          x += e->end->c.x;
+          y += e->end->c.y;
+          weight += 1;
+        }
+    }
+
+  if (weight <= 0)
+    return FALSE;
+
+  dest->x = x / weight;
+  dest->y = y / weight;
+  return TRUE;
+}
+
+static gpointer
+p2tr_smooth_job_run (gpointer data)
+{
+  P2trSmoothJob *job = (P2trSmoothJob*) data;
+  guint          i;
+
+  /* Only the positions are read here, and nothing is written to the
+   * mesh, so jobs may run in parallel */
+  for (i = job->start; i < job->end; i++)
+    {
+      P2trPoint *pt = (P2trPoint*) p2tr_dense_set_get (job->points, i);
+      job->movable[i - job->start] = p2tr_smooth_compute_target (pt,
+          job->method, &job->targets[i - job->start]);
+    }
+
+  return NULL;
+}
+
+/**
+ * Find the smallest angle of the triangles around a point, if it was
+ * at the given position. Return a negative value if any of the
+ * triangles would be inverted or degenerate
+ */
+static gdouble
+p2tr_smooth_star_quality (P2trPoint         *pt,
+                          const P2trVector2 *at)
+{
+  GList   *iter;
+  gdouble  result = G_MAXDOUBLE;
+
+  for (iter = pt->outgoing_edges; iter != NULL; iter = iter->next)
+    {
+      P2trEdge  *e = (P2trEdge*) iter->data;
+      P2trPoint *C = p2tr_triangle_get_opposite_point (e->tri, e, FALSE);
+
+      /* The points of a triangle are always ordered clockwise */
+      if (p2tr_math_orient2d (at, &e->end->c, &C->c) != P2TR_ORIENTATION_CW)
+        return -1;
+
+      result = MIN (result, p2tr_math_triangle_min_angle (at, &e->end->c, &C->c));
+    }
+
+  return result;
+}
+
+/**
+ * Try to move a point towards its new position, and return whether it
+ * was moved. The edges which may no longer be delaunay are added to
+ * the flip candidates
+ */
+static gboolean
+p2tr_smooth_apply (P2trPoint         *pt,
+                   const P2trVector2 *target,
+                   P2trVEdgeSet      *candidates)
+{
+  P2trVector2  pos;
+  GList       *iter;
+  gdouble      quality = p2tr_smooth_star_quality (pt, &pt->c);
+  gint         attempt;
+
+  /* If the full move is rejected, try going half the way */
+  pos = *target;
+  for (attempt = 0; attempt < 2; attempt++)
+    {
+      if (p2tr_smooth_star_quality (pt, &pos) > quality)
+        break;
+      pos.x = (pos.x + pt->c.x) / 2;
+      pos.y = (pos.y + pt->c.y) / 2;
+    }
+
+  if (attempt == 2)
+    return FALSE;
+
+  p2tr_point_move (pt, &pos);
+
+  for (iter = pt->outgoing_edges; iter != NULL; iter = iter->next)
+    {
+      P2trEdge *e = (P2trEdge*) iter->data;
+      P2trEdge *opposite = p2tr_triangle_get_opposite_edge (e->tri, pt);
+
+      p2tr_vedge_set_add (candidates, p2tr_edge_ref (e));
+      if (! opposite->constrained)
+        p2tr_vedge_set_add (candidates, opposite);
+      else
+        p2tr_edge_unref (opposite);
+    }
+
+  return TRUE;
+}
+
+guint
+p2tr_cdt_smooth (P2trCDT          *self,
+                 P2trSmoothMethod  method,
+                 guint             iterations,
+                 guint             n_threads)
+{
+  P2trDenseSet  *points = self->mesh->points;
+  P2trSmoothJob *jobs;
+  GThread      **threads;
+  P2trVector2   *targets;
+  gboolean      *movable;
+  guint          moved = 0, count, chunk, i, j;
+
+  if (n_threads == 0)
+    n_threads = 1;
+
+  jobs = g_new (P2trSmoothJob, n_threads);
+  threads = g_new (GThread*, n_threads);
+
+  while (iterations-- > 0)
+    {
+      P2trVEdgeSet *candidates;
+
+      /* Points are only moved, so the amount and the order of the
+       * points doesn't change during the iteration */
+      count = p2tr_dense_set_size (points);
+      chunk = (count + n_threads - 1) / n_threads;
+      targets = g_new (P2trVector2, count);
+      movable = g_new (gboolean, count);
+
+      for (i = 0; i < n_threads; i++)
+        {
+          jobs[i].points  = points;
+          jobs[i].method  = method;
+          jobs[i].start   = MIN (i * chunk, count);
+          jobs[i].end     = MIN ((i + 1) * chunk, count);
+          jobs[i].targets = targets + jobs[i].start;
+          jobs[i].movable = movable + jobs[i].start;
+        }
+
+      for (i = 1; i < n_threads; i++)
+        threads[i] = g_thread_new ("p2tr-smooth", p2tr_smooth_job_run, &jobs[i]);
+      p2tr_smooth_job_run (&jobs[0]);
+      for (i = 1; i < n_threads; i++)
+        g_thread_join (threads[i]);
+
+      candidates = p2tr_vedge_set_new ();
+      for (j = 0; j < count; j++)
+        if (movable[j] && p2tr_smooth_apply (
+                (P2trPoint*) p2tr_dense_set_get (points, j), &targets[j], candidates))
+          moved++;
+
+      p2tr_cdt_flip_fix (self, candidates);
+      p2tr_vedge_set_free (candidates);
+
+      g_free (targets);
+      g_free (movable);
+    }
+
+  g_free (threads);
+  g_free (jobs);
+
+  return moved;
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __P2TC_REFINE_SMOOTH_H__
+#define __P2TC_REFINE_SMOOTH_H__
+
+#include <glib.h>
+#include "rcdt.h"
+
+/**
+ * \defgroup P2trSmooth P2trSmooth - Mesh Smoothing
+ * Moving the free points of a refined triangulation in order to
+ * improve the angles of its triangles. Points of constrained edges are
+ * never moved, so the domain and its segments are kept exactly.
+ *
+ * Each iteration computes the new positions of all the points from the
+ * old positions (Jacobi style), which may be done on several threads.
+ * The moves are then applied one by one, and a move is only accepted
+ * if it doesn't make the smallest angle around the point worse. After
+ * all the moves, edges are flipped to make the triangulation a CDT
+ * again.
+ * @{
+ */
+
+/**
+ * The ways to compute the new position of a point
+ */
+typedef enum
+{
+  /** Move each point to the average of its neighbors */
+  P2TR_SMOOTH_LAPLACIAN,
+  /** Move each point to the average of the circumcenters of the
+   *  triangles around it, weighted by their areas. This is the optimal
+   *  Delaunay triangulation (ODT) smoothing of Chen and Xu, which
+   *  usually gives better angles than the laplacian smoothing */
+  P2TR_SMOOTH_ODT
+} P2trSmoothMethod;
+
+/**
+ * Smooth a triangulation. Since the triangles are flipped, any
+ * refinement of the triangulation which was stopped before it was
+ * finished should be reset (see @ref p2tr_refiner_reset) before it's
+ * continued.
+ * @param self The triangulation to smooth
+ * @param method The way to compute the new positions of the points
+ * @param iterations The amount of smoothing iterations
+ * @param n_threads The amount of threads used for computing the new
+ *        positions. With 1 (or 0), everything is done in the calling
+ *        thread
+ * @return The amount of moves which were accepted, over all the
+ *         iterations
+ */
+guint    p2tr_cdt_smooth (P2trCDT          *self,
+                          P2trSmoothMethod  method,
+                          guint             iterations,
+                          guint             n_threads);
+
+/** @} */
+
+#endif
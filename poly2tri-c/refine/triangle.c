@@ -32,6 +32,7 @@
 
 #include <math.h>
 #include <glib.h>
+#include "pool.h"
 
 #include "rutils.h"
 #include "rmath.h"
@@ -72,9 +73,14 @@ p2tr_triangle_new (P2trEdge *AB,
                    P2trEdge *CA)
 {
   gint i;
-  P2trTriangle *self = g_slice_new (P2trTriangle);
+  P2trMesh     *mesh = AB->end->mesh;
+  P2trPoolSet  *pools = (mesh != NULL) ? mesh->pools : NULL;
+  P2trTriangle *self = p2tr_pool_new (P2trTriangle, P2TR_POOL_TRIANGLE, pools);
 
+  self->pools = pools;
   self->refcount = 0;
+  self->handle = P2TR_HANDLE_NONE;
+  self->quality.valid = FALSE;
 
 #ifndef P2TC_NO_LOGIC_CHECKS
   p2tr_validate_edges_can_form_tri (AB, BC, CA);
@@ -143,7 +149,7 @@ void
 p2tr_triangle_free (P2trTriangle *self)
 {
   g_assert (p2tr_triangle_is_removed (self));
-  g_slice_free (P2trTriangle, self);
+  p2tr_pool_delete (P2trTriangle, P2TR_POOL_TRIANGLE, self->pools, self);
 }
 
 void
@@ -157,6 +163,8 @@ p2tr_triangle_remove (P2trTriangle *self)
 
   mesh = p2tr_triangle_get_mesh (self);
   
+  p2tr_triangle_invalidate_quality (self);
+
   if (mesh != NULL)
     {
       p2tr_mesh_on_triangle_removed (mesh, self);
@@ -241,6 +249,12 @@ p2tr_triangle_get_angle_at (P2trTriangle *self,
 
 gdouble
 p2tr_triangle_smallest_non_constrained_angle (P2trTriangle *self)
+{
+  return p2tr_triangle_get_quality (self)->min_angle;
+}
+
+static gdouble
+p2tr_triangle_compute_min_angle (P2trTriangle *self)
 {
     gdouble result = G_MAXDOUBLE, angle;
     
@@ -265,6 +279,43 @@ p2tr_triangle_smallest_non_constrained_angle (P2trTriangle *self)
     return result;
 }
 
+const P2trTriangleQuality*
+p2tr_triangle_get_quality (P2trTriangle *self)
+{
+  P2trTriangleQuality *q = &self->quality;
+
+  if (! q->valid)
+    {
+      const P2trVector2 *A = &P2TR_TRIANGLE_GET_POINT (self, 0)->c;
+      const P2trVector2 *B = &P2TR_TRIANGLE_GET_POINT (self, 1)->c;
+      const P2trVector2 *C = &P2TR_TRIANGLE_GET_POINT (self, 2)->c;
+      gdouble a2 = P2TR_VECTOR2_DISTANCE_SQ (B, C);
+      gdouble b2 = P2TR_VECTOR2_DISTANCE_SQ (A, C);
+      gdouble c2 = P2TR_VECTOR2_DISTANCE_SQ (A, B);
+      gdouble shortest2 = MIN (a2, MIN (b2, c2));
+
+      q->min_angle = p2tr_triangle_compute_min_angle (self);
+      q->area = 0.5 * ABS ((B->x - A->x) * (C->y - A->y)
+                           - (B->y - A->y) * (C->x - A->x));
+
+      /* R = abc / 4S, so the ratio is abc / (4S * shortest), which is
+       * the product of the two longer edges divided by 4S */
+      if (q->area > 0 && shortest2 > 0)
+        q->radius_edge_ratio = sqrt (a2 * b2 * c2 / shortest2) / (4 * q->area);
+      else
+        q->radius_edge_ratio = G_MAXDOUBLE;
+      q->valid = TRUE;
+    }
+
+  return q;
+}
+
+void
+p2tr_triangle_invalidate_quality (P2trTriangle *self)
+{
+  self->quality.valid = FALSE;
+}
+
 void
 p2tr_triangle_get_circum_circle (P2trTriangle *self,
                                  P2trCircle   *circle)
@@ -276,6 +327,31 @@ p2tr_triangle_get_circum_circle (P2trTriangle *self,
       circle);
 }
 
+void
+p2tr_triangle_get_circum_center (P2trTriangle *self,
+                                 P2trVector2  *center,
+                                 gdouble      *radius_sq)
+{
+  p2tr_math_triangle_circumcenter (
+      &P2TR_TRIANGLE_GET_POINT(self,0)->c,
+      &P2TR_TRIANGLE_GET_POINT(self,1)->c,
+      &P2TR_TRIANGLE_GET_POINT(self,2)->c,
+      center, radius_sq);
+}
+
+void
+p2tr_triangle_get_off_center (P2trTriangle *self,
+                              gdouble       min_angle,
+                              P2trVector2  *center,
+                              gdouble      *radius_sq)
+{
+  p2tr_math_triangle_offcenter (
+      &P2TR_TRIANGLE_GET_POINT(self,0)->c,
+      &P2TR_TRIANGLE_GET_POINT(self,1)->c,
+      &P2TR_TRIANGLE_GET_POINT(self,2)->c,
+      min_angle, center, radius_sq);
+}
+
 P2trInCircle
 p2tr_triangle_circumcircle_contains_point (P2trTriangle      *self,
                                            const P2trVector2  *pt)
@@ -36,6 +36,31 @@
 #include <glib.h>
 #include "rmath.h"
 #include "triangulation.h"
+#include "dense-set.h"
+#include "pool.h"
+
+/**
+ * Cached quality measures of a triangle. Since the points of a triangle
+ * and the constrained flags of its edges never change while it's a part
+ * of a mesh, these are computed once and reused until the triangle is
+ * removed
+ */
+typedef struct
+{
+  /** The smallest angle of the triangle which is not enclosed between
+   *  two constrained edges (see
+   *  @ref p2tr_triangle_smallest_non_constrained_angle) */
+  gdouble  min_angle;
+
+  /** The ratio between the circumradius and the shortest edge */
+  gdouble  radius_edge_ratio;
+
+  /** The area of the triangle */
+  gdouble  area;
+
+  /** Whether the fields above are up to date */
+  gboolean valid;
+} P2trTriangleQuality;
 
 /**
  * @struct P2trTriangle_
@@ -46,6 +71,21 @@ struct P2trTriangle_
   P2trEdge* edges[3];
   
   guint refcount;
+
+  /**
+   * The handle of this triangle inside the set of triangles of its
+   * mesh, or @ref P2TR_HANDLE_NONE if it's not a part of any mesh
+   */
+  P2trHandle handle;
+
+  /** Cached quality measures - use @ref p2tr_triangle_get_quality */
+  P2trTriangleQuality quality;
+
+  /**
+   * The pools from which the triangle was allocated, or NULL if it was
+   * allocated with g_slice
+   */
+  P2trPoolSet *pools;
 };
 
 P2trTriangle*   p2tr_triangle_new            (P2trEdge *AB,
@@ -76,9 +116,43 @@ gdouble     p2tr_triangle_get_angle_at       (P2trTriangle *self,
 
 gdouble     p2tr_triangle_smallest_non_constrained_angle (P2trTriangle *self);
 
+/**
+ * Get the quality measures of a triangle, computing and caching them
+ * if they are not cached already
+ * @param self The triangle
+ * @return The cached quality measures. They are owned by the triangle
+ *         and remain valid until it's removed
+ */
+const P2trTriangleQuality* p2tr_triangle_get_quality (P2trTriangle *self);
+
+/**
+ * Drop the cached quality measures of a triangle, so that they will be
+ * recomputed on the next query. Must be called if the position of any
+ * of the points of the triangle is changed
+ */
+void        p2tr_triangle_invalidate_quality (P2trTriangle *self);
+
 void        p2tr_triangle_get_circum_circle (P2trTriangle *self,
                                              P2trCircle   *circle);
 
+/**
+ * Find the circumcenter of a triangle and its squared circumradius,
+ * without computing any square root. See
+ * @ref p2tr_math_triangle_circumcenter
+ */
+void        p2tr_triangle_get_circum_center (P2trTriangle *self,
+                                             P2trVector2  *center,
+                                             gdouble      *radius_sq);
+
+/**
+ * Find the off-center of a triangle for the given minimal angle. See
+ * @ref p2tr_math_triangle_offcenter
+ */
+void        p2tr_triangle_get_off_center    (P2trTriangle *self,
+                                             gdouble       min_angle,
+                                             P2trVector2  *center,
+                                             gdouble      *radius_sq);
+
 P2trInCircle p2tr_triangle_circumcircle_contains_point (P2trTriangle       *self,
                                                         const P2trVector2  *pt);
 
@@ -32,6 +32,7 @@
 
 #include <math.h>
 #include <glib.h>
+#include "pool.h"
 
 #include "point.h"
 #include "edge.h"
@@ -55,9 +56,11 @@ p2tr_vedge_new (P2trPoint *start,
                 P2trPoint *end,
                 gboolean   constrained)
 {
-  P2trVEdge *self = g_slice_new (P2trVEdge);
+  P2trPoolSet *pools = (end->mesh != NULL) ? end->mesh->pools : NULL;
+  P2trVEdge   *self = p2tr_pool_new (P2trVEdge, P2TR_POOL_VEDGE, pools);
 
   p2tr_vedge_init (self, start, end, constrained);
+  self->pools = pools;
 
   p2tr_point_ref (start);
   p2tr_point_ref (end);
@@ -129,7 +132,7 @@ p2tr_vedge_free (P2trVEdge *self)
 {
   p2tr_point_unref (self->start);
   p2tr_point_unref (self->end);
-  g_slice_free (P2trVEdge, self);
+  p2tr_pool_delete (P2trVEdge, P2TR_POOL_VEDGE, self->pools, self);
 }
 
 P2trMesh*
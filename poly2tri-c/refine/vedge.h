@@ -36,6 +36,7 @@
 #include <glib.h>
 #include "rutils.h"
 #include "triangulation.h"
+#include "pool.h"
 
 /**
  * @struct P2trVEdge_
@@ -52,6 +53,11 @@ struct P2trVEdge_
   gboolean   constrained;
   /** A count of references to the virtual edge */
   guint      refcount;
+  /**
+   * The pools from which the virtual edge was allocated, or NULL if it
+   * was allocated with g_slice
+   */
+  P2trPoolSet *pools;
 };
 
 P2trVEdge*  p2tr_vedge_new       (P2trPoint *start,
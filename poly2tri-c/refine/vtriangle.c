@@ -31,6 +31,7 @@
  */
 
 #include <glib.h>
+#include "pool.h"
 
 #include "point.h"
 #include "edge.h"
@@ -42,7 +43,11 @@
 P2trVTriangle*
 p2tr_vtriangle_new (P2trTriangle *tri)
 {
-  P2trVTriangle *self = g_slice_new (P2trVTriangle);
+  P2trMesh      *mesh = tri->edges[0]->end->mesh;
+  P2trPoolSet   *pools = (mesh != NULL) ? mesh->pools : NULL;
+  P2trVTriangle *self = p2tr_pool_new (P2trVTriangle, P2TR_POOL_VTRIANGLE, pools);
+
+  self->pools = pools;
 
   self->points[0] = p2tr_point_ref (tri->edges[0]->end);
   self->points[1] = p2tr_point_ref (tri->edges[1]->end);
@@ -74,7 +79,7 @@ p2tr_vtriangle_free (P2trVTriangle *self)
   p2tr_point_unref (self->points[0]);
   p2tr_point_unref (self->points[1]);
   p2tr_point_unref (self->points[2]);
-  g_slice_free (P2trVTriangle, self);
+  p2tr_pool_delete (P2trVTriangle, P2TR_POOL_VTRIANGLE, self->pools, self);
 }
 
 P2trMesh*
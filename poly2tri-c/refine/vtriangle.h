@@ -36,6 +36,7 @@
 #include <glib.h>
 #include "rmath.h"
 #include "triangulation.h"
+#include "pool.h"
 
 /**
  * @struct P2trVTriangle_
@@ -47,6 +48,12 @@ struct P2trVTriangle_
   P2trPoint* points[3];
   
   guint refcount;
+
+  /**
+   * The pools from which the virtual triangle was allocated, or NULL if
+   * it was allocated with g_slice
+   */
+  P2trPoolSet *pools;
 };
 
 P2trVTriangle*   p2tr_vtriangle_new          (P2trTriangle  *tri);
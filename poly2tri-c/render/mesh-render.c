@@ -30,12 +30,31 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <math.h>
 #include <glib.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <poly2tri-c/refine/refine.h>
 #include "mesh-render.h"
 
+/* Whether to use the vectorized kernels for rendering from a UVT cache.
+ * The kernels are compiled for each instruction set with a target
+ * attribute, and chosen at runtime according to the CPU. Define as 0 to
+ * always use the generic code */
+#ifndef P2TR_RENDER_SIMD
+#if (defined (__x86_64__) || defined (__i386__)) \
+    && (defined (__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define P2TR_RENDER_SIMD 1
+#else
+#define P2TR_RENDER_SIMD 0
+#endif
+#endif
+
+#if P2TR_RENDER_SIMD
+#include <immintrin.h>
+#endif
+
 /* This function implements box logic to see if a point is contained in a
  * triangles bounding box. This is very useful for cases where there are many
  * triangles to test against a single point, and most of them aren't even near
@@ -70,40 +89,456 @@ p2tr_mesh_render_cache_uvt (P2trMesh        *T,
   p2tr_mesh_render_cache_uvt_exact (T, dest, config->x_samples * config->y_samples, config);
 }
 
+/**
+ * An edge of a triangle which is being rasterized. The value of a
+ * sample relative to the edge is positive inside the triangle, zero on
+ * the edge and negative outside of it.
+ */
+typedef struct
+{
+  /** The end points of the edge, in a fixed order which doesn't depend
+   *  on the triangle. This way the two triangles of an edge compute
+   *  exactly the same value (up to its sign) for each sample on it, so
+   *  there are no cracks or overlaps between them */
+  const P2trVector2 *P, *Q;
+  /** 1 or -1, so that the value is positive inside the triangle */
+  gdouble            sign;
+  /** Whether samples exactly on the edge belong to the triangle. This
+   *  is the top-left fill rule - exactly one of the two triangles of
+   *  each edge owns the samples on it. Samples on the outline of the
+   *  mesh are always inside */
+  gboolean           inclusive;
+  /** The part of the value which only depends on the row */
+  gdouble            row_value;
+} P2trRasterEdge;
+
+static void
+p2tr_raster_edge_init (P2trRasterEdge    *self,
+                       P2trEdge          *edge,
+                       gdouble            orientation)
+{
+  const P2trVector2 *from = &P2TR_EDGE_START (edge)->c;
+  const P2trVector2 *to = &edge->end->c;
+  gdouble            dx, dy;
+
+  if (from->x < to->x || (from->x == to->x && from->y < to->y))
+    {
+      self->P = from;
+      self->Q = to;
+      self->sign = orientation;
+    }
+  else
+    {
+      self->P = to;
+      self->Q = from;
+      self->sign = -orientation;
+    }
+
+  /* The direction of the edge when going counter-clockwise around
+   * the triangle */
+  dx = (to->x - from->x) * orientation;
+  dy = (to->y - from->y) * orientation;
+  self->inclusive = dy < 0 || (dy == 0 && dx < 0) || edge->mirror->tri == NULL;
+}
+
+/* The value of a sample at X on the current row, relative to the edge */
+#define P2TR_RASTER_EDGE_VALUE(e, X)                                   \
+  ((e)->sign * ((e)->row_value - ((e)->Q->y - (e)->P->y) * ((X) - (e)->P->x)))
+
+#define P2TR_RASTER_EDGE_INSIDE(e, value)                              \
+  ((value) > 0 || ((value) == 0 && (e)->inclusive))
+
+/**
+ * A rectangle of samples, [x0, x1) x [y0, y1), and a part of a UVT
+ * cache storing the first dest_len samples in it row by row. The rows
+ * are stride samples apart in dest, so the region may also be a part of
+ * a larger cache
+ */
+typedef struct
+{
+  gint     x0, y0, x1, y1;
+  guint    stride;
+  P2trUVT *dest;
+  guint    dest_len;
+} P2trUVTRegion;
+
+/**
+ * Find the range of samples which may be inside a box. The range is
+ * rounded outwards, and is not clipped to the image.
+ */
+static void
+p2tr_mesh_render_box_bounds (const P2trMeshBox *box,
+                             P2trImageConfig   *config,
+                             gint              *x_first,
+                             gint              *y_first,
+                             gint              *x_last,
+                             gint              *y_last)
+{
+  *x_first = (gint) floor ((box->min_x - config->min_x) / config->step_x);
+  *x_last  = (gint) ceil  ((box->max_x - config->min_x) / config->step_x);
+  *y_first = (gint) floor ((box->min_y - config->min_y) / config->step_y);
+  *y_last  = (gint) ceil  ((box->max_y - config->min_y) / config->step_y);
+}
+
+/**
+ * Find the range of samples which may be inside a triangle, like
+ * @ref p2tr_mesh_render_box_bounds
+ */
+static void
+p2tr_mesh_render_triangle_bounds (P2trTriangle    *tri,
+                                  P2trImageConfig *config,
+                                  gint            *x_first,
+                                  gint            *y_first,
+                                  gint            *x_last,
+                                  gint            *y_last)
+{
+  const P2trVector2 *A = &P2TR_TRIANGLE_GET_POINT (tri, 0)->c;
+  const P2trVector2 *B = &P2TR_TRIANGLE_GET_POINT (tri, 1)->c;
+  const P2trVector2 *C = &P2TR_TRIANGLE_GET_POINT (tri, 2)->c;
+  P2trMeshBox        box;
+
+  box.min_x = MIN (A->x, MIN (B->x, C->x));
+  box.max_x = MAX (A->x, MAX (B->x, C->x));
+  box.min_y = MIN (A->y, MIN (B->y, C->y));
+  box.max_y = MAX (A->y, MAX (B->y, C->y));
+
+  p2tr_mesh_render_box_bounds (&box, config, x_first, y_first, x_last, y_last);
+}
+
+/**
+ * Sort the triangles of a mesh into a grid of cells, by the samples
+ * they may cover. The grid covers the samples from (x0, y0) up to (but
+ * not including) (x1, y1), with cells of cell_w by cell_h samples
+ * (except for the last ones, which may be smaller). Cells which are
+ * NULL are skipped
+ */
+static void
+p2tr_mesh_render_bin_triangles (P2trMesh         *mesh,
+                                P2trImageConfig  *config,
+                                gint              x0,
+                                gint              y0,
+                                gint              x1,
+                                gint              y1,
+                                gint              cell_w,
+                                gint              cell_h,
+                                GPtrArray       **cells)
+{
+  gint              cells_x = (x1 - x0 + cell_w - 1) / cell_w;
+  P2trDenseSetIter  iter;
+  P2trTriangle     *tri;
+  gint              cx, cy;
+
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  p2tr_dense_set_iter_init (&iter, mesh->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&tri))
+    {
+      gint x_first, y_first, x_last, y_last;
+
+      p2tr_mesh_render_triangle_bounds (tri, config, &x_first, &y_first, &x_last, &y_last);
+      x_first = MAX (x_first, x0);
+      y_first = MAX (y_first, y0);
+      x_last = MIN (x_last, x1 - 1);
+      y_last = MIN (y_last, y1 - 1);
+
+      if (x_first > x_last || y_first > y_last)
+        continue;
+
+      for (cy = (y_first - y0) / cell_h; cy <= (y_last - y0) / cell_h; cy++)
+        for (cx = (x_first - x0) / cell_w; cx <= (x_last - x0) / cell_w; cx++)
+          if (cells[cy * cells_x + cx] != NULL)
+            g_ptr_array_add (cells[cy * cells_x + cx], tri);
+    }
+}
+
+/**
+ * Store the barycentric coordinates of all the samples of a region
+ * which are inside a triangle. Each row of samples is limited to the
+ * span between the edges of the triangle, and each sample in the span
+ * is then tested exactly against the edges. The samples are positioned
+ * by their index in the entire image, so the result for a sample
+ * doesn't depend on the region containing it
+ */
+static void
+p2tr_mesh_render_rasterize_triangle (P2trTriangle    *tri,
+                                     P2trUVTRegion   *region,
+                                     P2trImageConfig *config)
+{
+  const P2trVector2 *A = &P2TR_TRIANGLE_GET_POINT (tri, 0)->c;
+  const P2trVector2 *B = &P2TR_TRIANGLE_GET_POINT (tri, 1)->c;
+  const P2trVector2 *C = &P2TR_TRIANGLE_GET_POINT (tri, 2)->c;
+  P2trRasterEdge     edges[3], *AB = &edges[0], *BC = &edges[1], *CA = &edges[2];
+  gdouble            area, orientation, min_x, max_x;
+  gint               x_first, x_last, y_first, y_last, x, y, i;
+  guint              row_start;
+
+  area = (B->x - A->x) * (C->y - A->y) - (B->y - A->y) * (C->x - A->x);
+  if (area == 0)
+    return;
+  orientation = (area > 0) ? 1 : -1;
+  area = ABS (area);
+
+  /* Point i of a triangle is the start of edge i */
+  p2tr_raster_edge_init (AB, tri->edges[0], orientation);
+  p2tr_raster_edge_init (BC, tri->edges[1], orientation);
+  p2tr_raster_edge_init (CA, tri->edges[2], orientation);
+
+  min_x = MIN (A->x, MIN (B->x, C->x));
+  max_x = MAX (A->x, MAX (B->x, C->x));
+
+  /* Samples which are not really inside are rejected by the exact
+   * tests below */
+  p2tr_mesh_render_triangle_bounds (tri, config, &x_first, &y_first, &x_last, &y_last);
+  x_first = MAX (x_first, region->x0);
+  x_last  = MIN (x_last,  region->x1 - 1);
+  y_first = MAX (y_first, region->y0);
+  y_last  = MIN (y_last,  region->y1 - 1);
+
+  for (y = y_first; y <= y_last; y++)
+    {
+      gdouble  Py = config->min_y + y * config->step_y;
+      gdouble  span_min = min_x, span_max = max_x;
+      gboolean empty = FALSE;
+      gint     span_first, span_last;
+
+      row_start = (y - region->y0) * region->stride;
+      if (row_start >= region->dest_len)
+        break;
+
+      for (i = 0; i < 3; i++)
+        {
+          P2trRasterEdge *e = &edges[i];
+          gdouble         dy = e->Q->y - e->P->y;
+
+          e->row_value = (e->Q->x - e->P->x) * (Py - e->P->y);
+
+          /* Find where the row crosses the edge, and on which side of
+           * that the inside of the triangle is */
+          if (dy == 0)
+            empty = empty || ! P2TR_RASTER_EDGE_INSIDE (e, e->sign * e->row_value);
+          else if (-dy * e->sign > 0)
+            span_min = MAX (span_min, e->P->x + e->row_value / dy);
+          else
+            span_max = MIN (span_max, e->P->x + e->row_value / dy);
+        }
+
+      if (empty || span_min > span_max)
+        continue;
+
+      span_first = MAX (x_first, (gint) floor ((span_min - config->min_x) / config->step_x));
+      span_last  = MIN (x_last,  (gint) ceil ((span_max - config->min_x) / config->step_x));
+
+      for (x = span_first; x <= span_last; x++)
+        {
+          gdouble Px = config->min_x + x * config->step_x;
+          gdouble ab = P2TR_RASTER_EDGE_VALUE (AB, Px);
+          gdouble bc = P2TR_RASTER_EDGE_VALUE (BC, Px);
+          gdouble ca = P2TR_RASTER_EDGE_VALUE (CA, Px);
+          guint   index = row_start + (x - region->x0);
+
+          if (P2TR_RASTER_EDGE_INSIDE (AB, ab)
+              && P2TR_RASTER_EDGE_INSIDE (BC, bc)
+              && P2TR_RASTER_EDGE_INSIDE (CA, ca)
+              && index < region->dest_len)
+            {
+              /* Same as p2tr_triangle_contains_point2 */
+              region->dest[index].tri = tri;
+              region->dest[index].u = ab / area;
+              region->dest[index].v = ca / area;
+            }
+        }
+    }
+}
+
 void
 p2tr_mesh_render_cache_uvt_exact (P2trMesh        *T,
                                   P2trUVT         *dest,
                                   gint             dest_len,
                                   P2trImageConfig *config)
 {
-  guint x, y, n = dest_len;
-  P2trUVT *uvt = dest;
-  P2trTriangle *tr_prev = NULL;
-  P2trVector2 pt;
-  
-  pt.x = config->min_x;
-  pt.y = config->min_y;
-
-  uvt->tri = p2tr_mesh_find_point_local2 (T, &pt, NULL, &uvt->u, &uvt->v);
-  if (uvt->tri) p2tr_triangle_unref (uvt->tri);
-  tr_prev = uvt->tri;
-  
-  for (y = 0, pt.y = config->min_y; y < config->y_samples; ++y, pt.y += config->step_y)
-    {
-      for (x = 0, pt.x = config->min_x; x < config->x_samples; ++x, pt.x += config->step_x)
-        {
-          if (n-- == 0) return;
-          uvt->tri = p2tr_mesh_find_point_local2 (T, &pt, tr_prev, &uvt->u, &uvt->v);
-          if (uvt->tri) p2tr_triangle_unref (uvt->tri);
-          tr_prev = uvt->tri;
-          ++uvt;
-        }
+  P2trDenseSetIter  iter;
+  P2trTriangle     *tri;
+  P2trUVTRegion     region;
+  gint              i;
+
+  region.x0 = region.y0 = 0;
+  region.x1 = config->x_samples;
+  region.y1 = config->y_samples;
+  region.stride = config->x_samples;
+  region.dest = dest;
+  region.dest_len = dest_len;
+
+  for (i = 0; i < dest_len; i++)
+    {
+      dest[i].tri = NULL;
+      dest[i].u = dest[i].v = 0;
     }
+
+  /* Instead of locating each sample in the mesh, go over the triangles
+   * and find the samples inside each one. This takes time linear in
+   * the amount of samples and triangles */
+  p2tr_dense_set_iter_init (&iter, T->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&tri))
+    p2tr_mesh_render_rasterize_triangle (tri, &region, config);
+}
+
+void
+p2tr_mesh_render_update_uvt_cache (P2trMesh        *mesh,
+                                   P2trUVT         *dest,
+                                   gint             dest_len,
+                                   P2trImageConfig *config,
+                                   GArray          *changes)
+{
+  gint              tiles_x = (config->x_samples + P2TR_UVT_UPDATE_TILE_SIZE - 1) / P2TR_UVT_UPDATE_TILE_SIZE;
+  gint              tiles_y = (config->y_samples + P2TR_UVT_UPDATE_TILE_SIZE - 1) / P2TR_UVT_UPDATE_TILE_SIZE;
+  GPtrArray       **tiles = g_new0 (GPtrArray*, tiles_x * tiles_y);
+  guint             i;
+  gint              tx, ty;
+
+  /* Merge the changed boxes into a grid of dirty tiles, so that areas
+   * which were changed several times are only recomputed once */
+  for (i = 0; i < changes->len; i++)
+    {
+      gint x_first, y_first, x_last, y_last;
+
+      p2tr_mesh_render_box_bounds (&g_array_index (changes, P2trMeshBox, i),
+          config, &x_first, &y_first, &x_last, &y_last);
+      x_first = MAX (x_first, 0);
+      y_first = MAX (y_first, 0);
+      x_last = MIN (x_last, (gint) config->x_samples - 1);
+      y_last = MIN (y_last, (gint) config->y_samples - 1);
+
+      for (ty = y_first / P2TR_UVT_UPDATE_TILE_SIZE; ty <= y_last / P2TR_UVT_UPDATE_TILE_SIZE; ty++)
+        for (tx = x_first / P2TR_UVT_UPDATE_TILE_SIZE; tx <= x_last / P2TR_UVT_UPDATE_TILE_SIZE; tx++)
+          if (tiles[ty * tiles_x + tx] == NULL)
+            tiles[ty * tiles_x + tx] = g_ptr_array_new ();
+    }
+
+  /* Find the triangles which may cover samples of the dirty tiles */
+  p2tr_mesh_render_bin_triangles (mesh, config, 0, 0,
+      config->x_samples, config->y_samples,
+      P2TR_UVT_UPDATE_TILE_SIZE, P2TR_UVT_UPDATE_TILE_SIZE, tiles);
+
+  for (ty = 0; ty < tiles_y; ty++)
+    for (tx = 0; tx < tiles_x; tx++)
+      {
+        GPtrArray     *tris = tiles[ty * tiles_x + tx];
+        P2trUVTRegion  region;
+        gint           start, x, y;
+
+        if (tris == NULL)
+          continue;
+
+        region.x0 = tx * P2TR_UVT_UPDATE_TILE_SIZE;
+        region.y0 = ty * P2TR_UVT_UPDATE_TILE_SIZE;
+        region.x1 = MIN (region.x0 + P2TR_UVT_UPDATE_TILE_SIZE, (gint) config->x_samples);
+        region.y1 = MIN (region.y0 + P2TR_UVT_UPDATE_TILE_SIZE, (gint) config->y_samples);
+        region.stride = config->x_samples;
+
+        start = region.y0 * config->x_samples + region.x0;
+        if (start < dest_len)
+          {
+            region.dest = dest + start;
+            region.dest_len = dest_len - start;
+
+            for (y = region.y0; y < region.y1; y++)
+              for (x = region.x0; x < region.x1; x++)
+                {
+                  gint index = y * config->x_samples + x;
+                  if (index < dest_len)
+                    {
+                      dest[index].tri = NULL;
+                      dest[index].u = dest[index].v = 0;
+                    }
+                }
+
+            for (i = 0; i < tris->len; i++)
+              p2tr_mesh_render_rasterize_triangle (
+                  (P2trTriangle*) g_ptr_array_index (tris, i), &region, config);
+          }
+
+        g_ptr_array_free (tris, TRUE);
+      }
+
+  g_free (tiles);
 }
 
 #define P2TR_USE_BARYCENTRIC(u, v, A, B, C)                            \
     ((A) + (v) * ((B) - (A)) + (u) * ((C) - (A)))
 
+/**
+ * Convert a float into the bits of an IEEE 754 half precision float,
+ * rounding to the nearest value (ties to even) like the F16C
+ * instructions do
+ */
+static guint16
+p2tr_mesh_render_float_to_half (gfloat value)
+{
+  union { gfloat f; guint32 u; } bits;
+  guint32 sign, exponent, mantissa, shift, result, rest, half_way;
+
+  bits.f = value;
+  sign = (bits.u >> 16) & 0x8000;
+  exponent = (bits.u >> 23) & 0xff;
+  mantissa = bits.u & 0x7fffff;
+
+  /* Infinity and NaN */
+  if (exponent == 0xff)
+    return sign | 0x7c00 | (mantissa ? 0x200 | (mantissa >> 13) : 0);
+  /* Too large, so it overflows to infinity */
+  if (exponent >= 127 + 16)
+    return sign | 0x7c00;
+  /* Too small, so it rounds to zero */
+  if (exponent < 127 - 25)
+    return sign;
+
+  if (exponent >= 127 - 14)
+    {
+      /* Normal numbers - re-bias the exponent and drop 13 bits of the
+       * mantissa. Rounding up may carry into the exponent, which is
+       * just right (even when the result becomes infinity) */
+      mantissa |= (exponent - (127 - 15)) << 23;
+      shift = 13;
+    }
+  else
+    {
+      /* Subnormal numbers - add the implicit leading bit, and shift so
+       * that the value is in units of 2^-24 */
+      mantissa |= 0x800000;
+      shift = 126 - exponent;
+    }
+
+  result = mantissa >> shift;
+  rest = mantissa & ((1 << shift) - 1);
+  half_way = 1 << (shift - 1);
+  if (rest > half_way || (rest == half_way && (result & 1)))
+    ++result;
+
+  return (guint16) (sign | result);
+}
+
+/* Conversions of the interpolated values into each channel format */
+#define P2TR_RENDER_TO_F(value) ((gfloat) (value))
+#define P2TR_RENDER_TO_B(value) ((guint8) (value))
+#define P2TR_RENDER_TO_S(value) ((guint16) (value))
+#define P2TR_RENDER_TO_H(value) p2tr_mesh_render_float_to_half ((gfloat) (value))
+
+/**
+ * The formats of the channels of rendered pixels
+ */
+typedef enum
+{
+  /** gfloat channels */
+  P2TR_RENDER_FORMAT_F,
+  /** guint8 channels */
+  P2TR_RENDER_FORMAT_B,
+  /** guint16 channels */
+  P2TR_RENDER_FORMAT_S,
+  /** Half precision float channels, interpolated from gfloat colors */
+  P2TR_RENDER_FORMAT_H
+} P2trRenderFormat;
+
 /**
  * This is a general macro for using a UVT cache in order to render a
  * color interpolation triangular mesh. The reason this is a macro and
@@ -119,8 +554,12 @@ p2tr_mesh_render_cache_uvt_exact (P2trMesh        *T,
  *        Should be of type @ref cformat*
  * @param n The amount of pixels to render into dest. Should be a
  *        positive integer.
+ * @param pixel_stride The distance between the pixels in dest, in
+ *        units of @ref cformat. At least cpp + 1.
  * @param cformat The type of the data inside @ref dest. This can be any
  *        numeric type (double, float, int, ...)
+ * @param ctype The type of the color channels returned by @ref pt2col
+ * @param convert A macro converting a double value into @ref cformat
  * @param cpp The amount of color channels per pixel, not including the
  *        alpha channel. Should be a positive integer.
  * @param pt2col The function which maps mesh points into colors. This
@@ -128,17 +567,23 @@ p2tr_mesh_render_cache_uvt_exact (P2trMesh        *T,
  * @param pt2col_user_data An additional parameter to @ref pt2col
  * @param alpha_last Specifies whether the alpha component should come
  *        after or before the other color channels. Should be a boolean.
+ * @param premultiplied Specifies whether the colors should be
+ *        premultiplied by the alpha. Should be a boolean.
  */
 #define P2TR_MESH_RENDER_FROM_CACHE(uvt_cache,                         \
                                     uvt_cache_w,                       \
                                     uvt_cache_h,                       \
                                     dest,                              \
                                     n,                                 \
+                                    pixel_stride,                      \
                                     cformat,                           \
+                                    ctype,                             \
+                                    convert,                           \
                                     cpp,                               \
                                     pt2col,                            \
                                     pt2col_user_data,                  \
-                                    alpha_last)                        \
+                                    alpha_last,                        \
+                                    premultiplied)                     \
 G_STMT_START                                                           \
 {                                                                      \
   P2trUVT *uvt_p = (uvt_cache);                                        \
@@ -148,29 +593,35 @@ G_STMT_START                                                           \
   guint x, y, i;                                                       \
   P2trPointToColorFuncC pt2col_c = (P2trPointToColorFuncC) (pt2col); \
                                                                        \
-  cformat *colA = g_newa (cformat, (cpp));                             \
-  cformat *colB = g_newa (cformat, (cpp));                             \
-  cformat *colC = g_newa (cformat, (cpp));                             \
+  ctype *colA = g_newa (ctype, (cpp));                                 \
+  ctype *colB = g_newa (ctype, (cpp));                                 \
+  ctype *colC = g_newa (ctype, (cpp));                                 \
                                                                        \
   cformat *pixel = dest;                                               \
                                                                        \
-  for (y = 0; y < (uvt_cache_w) && remain > 0; ++y)                    \
-    for (x = 0; x < (uvt_cache_h) && remain > 0; ++x, --remain, ++uvt_p) \
+  for (y = 0; y < (uvt_cache_h) && remain > 0; ++y)                    \
+    for (x = 0; x < (uvt_cache_w) && remain > 0; ++x, --remain, ++uvt_p) \
       {                                                                \
         P2trTriangle *tr_now = uvt_p->tri;                             \
                                                                        \
         /* If we are outside of the triangulation, set alpha to   */   \
-        /* zero and continue */                                        \
+        /* zero (and the colors too, if they are premultiplied)   */   \
+        /* and continue */                                             \
         if (tr_now == NULL)                                            \
           {                                                            \
             /* Remember that cpp does not include the alpha! */        \
-            pixel[(alpha_last) ? (cpp) : 0] = 0;                       \
-            pixel += cpp + 1;                                          \
+            if (premultiplied)                                         \
+              for (i = 0; i <= cpp; ++i)                               \
+                pixel[i] = convert (0);                                \
+            else                                                       \
+              pixel[(alpha_last) ? (cpp) : 0] = convert (0);           \
+            pixel += (pixel_stride);                                   \
           }                                                            \
         else                                                           \
           {                                                            \
             gdouble u = uvt_p->u;                                      \
             gdouble v = uvt_p->v;                                      \
+            cformat *px = pixel;                                       \
             /* If the triangle hasn't changed since the previous  */   \
             /* pixel, then don't sample the color at the vertices */   \
             /* again, since that is an expensive process!         */   \
@@ -187,89 +638,1343 @@ G_STMT_START                                                           \
                 pt2col_c (B, (gpointer) colB, pt2col_user_data);       \
                 pt2col_c (C, (gpointer) colC, pt2col_user_data);       \
                 /* Set the current triangle */                         \
-                tr_now = tr_prev;                                      \
+                tr_prev = tr_now;                                      \
               }                                                        \
                                                                        \
             /* We are inside the mesh, so set as opaque */             \
-            if (! alpha_last) *pixel++ = (cformat) 1;                  \
+            if (! alpha_last) *px++ = convert (1);                     \
             /* Interpolate the color using barycentric coodinates */   \
             for (i = 0; i < cpp; ++i)                                  \
-              *pixel++ = (cformat) P2TR_USE_BARYCENTRIC (u, v,         \
-                  colA[i], colB[i], colC[i]);                          \
+              *px++ = convert (P2TR_USE_BARYCENTRIC (u, v,             \
+                  colA[i], colB[i], colC[i]));                         \
             /* We are inside the mesh, so set as opaque */             \
-            if (alpha_last) *pixel++ = (cformat) 1;                    \
+            if (alpha_last) *px++ = convert (1);                       \
+            pixel += (pixel_stride);                                   \
           }                                                            \
       }                                                                \
 }                                                                      \
 G_STMT_END
 
-#define P2TR_MESH_RENDER(mesh,                                         \
-                         dest,                                         \
-                         config,                                       \
-                         pt2col,                                       \
-                         pt2col_user_data,                             \
-                         cache_render_func)                            \
+#if P2TR_RENDER_SIMD
+
+/**
+ * The maximal amount of channels (including the alpha) in a pixel
+ * rendered by the vectorized kernels
+ */
+#define P2TR_RENDER_SIMD_MAX_CHANNELS 5
+
+/**
+ * The interpolation coefficients of a triangle, with one entry for each
+ * channel of the pixel (including the alpha). The value of a channel at
+ * a sample is A + v * dB + u * dC, just like in @ref P2TR_USE_BARYCENTRIC
+ */
+typedef struct
+{
+  gdouble A[P2TR_RENDER_SIMD_MAX_CHANNELS];
+  gdouble dB[P2TR_RENDER_SIMD_MAX_CHANNELS];
+  gdouble dC[P2TR_RENDER_SIMD_MAX_CHANNELS];
+} P2trRenderCoeffs;
+
+/**
+ * A function that renders a run of pixels which are all inside the same
+ * triangle. The first 4 channels of each pixel are computed in vector
+ * registers, and the fifth one (if there is one) in a scalar register.
+ * The operations are the same as in the generic code, so the results
+ * are identical.
+ * @param uvt The UVT cache of the first pixel in the run
+ * @param count The amount of pixels in the run
+ * @param coeffs The interpolation coefficients of the triangle
+ * @param n_channels The amount of channels in a pixel, 4 or 5
+ * @param pixel_stride The distance between the pixels, in channels
+ * @param dest The destination of the first pixel in the run
+ */
+typedef void (*P2trRenderRunFunc) (const P2trUVT          *uvt,
+                                   glong                   count,
+                                   const P2trRenderCoeffs *coeffs,
+                                   guint                   n_channels,
+                                   gsize                   pixel_stride,
+                                   gpointer                dest);
+
+#define P2TR_RENDER_LAST_CHANNEL(uvt, coeffs)                          \
+    ((coeffs)->A[4] + (uvt)->v * (coeffs)->dB[4] + (uvt)->u * (coeffs)->dC[4])
+
+__attribute__ ((target ("sse2"))) static void
+p2tr_mesh_render_run_f_sse2 (const P2trUVT          *uvt,
+                             glong                   count,
+                             const P2trRenderCoeffs *coeffs,
+                             guint                   n_channels,
+                             gsize                   pixel_stride,
+                             gpointer                dest)
+{
+  gfloat  *pixel = (gfloat*) dest;
+  __m128d  A0 = _mm_loadu_pd (coeffs->A), A1 = _mm_loadu_pd (coeffs->A + 2);
+  __m128d  B0 = _mm_loadu_pd (coeffs->dB), B1 = _mm_loadu_pd (coeffs->dB + 2);
+  __m128d  C0 = _mm_loadu_pd (coeffs->dC), C1 = _mm_loadu_pd (coeffs->dC + 2);
+
+  for (; count > 0; --count, ++uvt, pixel += pixel_stride)
+    {
+      __m128d u = _mm_set1_pd (uvt->u), v = _mm_set1_pd (uvt->v);
+      __m128d r0 = _mm_add_pd (_mm_add_pd (A0, _mm_mul_pd (v, B0)), _mm_mul_pd (u, C0));
+      __m128d r1 = _mm_add_pd (_mm_add_pd (A1, _mm_mul_pd (v, B1)), _mm_mul_pd (u, C1));
+
+      _mm_storeu_ps (pixel, _mm_movelh_ps (_mm_cvtpd_ps (r0), _mm_cvtpd_ps (r1)));
+      if (n_channels == 5)
+        pixel[4] = (gfloat) P2TR_RENDER_LAST_CHANNEL (uvt, coeffs);
+    }
+}
+
+__attribute__ ((target ("sse2"))) static void
+p2tr_mesh_render_run_b_sse2 (const P2trUVT          *uvt,
+                             glong                   count,
+                             const P2trRenderCoeffs *coeffs,
+                             guint                   n_channels,
+                             gsize                   pixel_stride,
+                             gpointer                dest)
+{
+  guint8  *pixel = (guint8*) dest;
+  __m128d  A0 = _mm_loadu_pd (coeffs->A), A1 = _mm_loadu_pd (coeffs->A + 2);
+  __m128d  B0 = _mm_loadu_pd (coeffs->dB), B1 = _mm_loadu_pd (coeffs->dB + 2);
+  __m128d  C0 = _mm_loadu_pd (coeffs->dC), C1 = _mm_loadu_pd (coeffs->dC + 2);
+
+  for (; count > 0; --count, ++uvt, pixel += pixel_stride)
+    {
+      __m128d u = _mm_set1_pd (uvt->u), v = _mm_set1_pd (uvt->v);
+      __m128d r0 = _mm_add_pd (_mm_add_pd (A0, _mm_mul_pd (v, B0)), _mm_mul_pd (u, C0));
+      __m128d r1 = _mm_add_pd (_mm_add_pd (A1, _mm_mul_pd (v, B1)), _mm_mul_pd (u, C1));
+      /* Truncate like a cast, and then pack the 4 integers into bytes */
+      __m128i i = _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (r0), _mm_cvttpd_epi32 (r1));
+      gint32  packed;
+
+      i = _mm_packs_epi32 (i, i);
+      packed = _mm_cvtsi128_si32 (_mm_packus_epi16 (i, i));
+      memcpy (pixel, &packed, 4);
+      if (n_channels == 5)
+        pixel[4] = (guint8) P2TR_RENDER_LAST_CHANNEL (uvt, coeffs);
+    }
+}
+
+/* The kernels only need 256 bit floating point operations, so AVX is
+ * enough and AVX2 isn't required */
+__attribute__ ((target ("avx"))) static void
+p2tr_mesh_render_run_f_avx (const P2trUVT          *uvt,
+                            glong                   count,
+                            const P2trRenderCoeffs *coeffs,
+                            guint                   n_channels,
+                            gsize                   pixel_stride,
+                            gpointer                dest)
+{
+  gfloat  *pixel = (gfloat*) dest;
+  __m256d  A = _mm256_loadu_pd (coeffs->A);
+  __m256d  B = _mm256_loadu_pd (coeffs->dB);
+  __m256d  C = _mm256_loadu_pd (coeffs->dC);
+
+  for (; count > 0; --count, ++uvt, pixel += pixel_stride)
+    {
+      __m256d u = _mm256_broadcast_sd (&uvt->u), v = _mm256_broadcast_sd (&uvt->v);
+      __m256d r = _mm256_add_pd (_mm256_add_pd (A, _mm256_mul_pd (v, B)), _mm256_mul_pd (u, C));
+
+      _mm_storeu_ps (pixel, _mm256_cvtpd_ps (r));
+      if (n_channels == 5)
+        pixel[4] = (gfloat) P2TR_RENDER_LAST_CHANNEL (uvt, coeffs);
+    }
+}
+
+__attribute__ ((target ("avx"))) static void
+p2tr_mesh_render_run_b_avx (const P2trUVT          *uvt,
+                            glong                   count,
+                            const P2trRenderCoeffs *coeffs,
+                            guint                   n_channels,
+                            gsize                   pixel_stride,
+                            gpointer                dest)
+{
+  guint8  *pixel = (guint8*) dest;
+  __m256d  A = _mm256_loadu_pd (coeffs->A);
+  __m256d  B = _mm256_loadu_pd (coeffs->dB);
+  __m256d  C = _mm256_loadu_pd (coeffs->dC);
+
+  for (; count > 0; --count, ++uvt, pixel += pixel_stride)
+    {
+      __m256d u = _mm256_broadcast_sd (&uvt->u), v = _mm256_broadcast_sd (&uvt->v);
+      __m256d r = _mm256_add_pd (_mm256_add_pd (A, _mm256_mul_pd (v, B)), _mm256_mul_pd (u, C));
+      __m128i i = _mm256_cvttpd_epi32 (r);
+      gint32  packed;
+
+      i = _mm_packs_epi32 (i, i);
+      packed = _mm_cvtsi128_si32 (_mm_packus_epi16 (i, i));
+      memcpy (pixel, &packed, 4);
+      if (n_channels == 5)
+        pixel[4] = (guint8) P2TR_RENDER_LAST_CHANNEL (uvt, coeffs);
+    }
+}
+
+__attribute__ ((target ("avx"))) static void
+p2tr_mesh_render_run_s_avx (const P2trUVT          *uvt,
+                            glong                   count,
+                            const P2trRenderCoeffs *coeffs,
+                            guint                   n_channels,
+                            gsize                   pixel_stride,
+                            gpointer                dest)
+{
+  guint16 *pixel = (guint16*) dest;
+  __m256d  A = _mm256_loadu_pd (coeffs->A);
+  __m256d  B = _mm256_loadu_pd (coeffs->dB);
+  __m256d  C = _mm256_loadu_pd (coeffs->dC);
+
+  for (; count > 0; --count, ++uvt, pixel += pixel_stride)
+    {
+      __m256d u = _mm256_broadcast_sd (&uvt->u), v = _mm256_broadcast_sd (&uvt->v);
+      __m256d r = _mm256_add_pd (_mm256_add_pd (A, _mm256_mul_pd (v, B)), _mm256_mul_pd (u, C));
+      __m128i i = _mm256_cvttpd_epi32 (r);
+
+      /* AVX implies SSE 4.1, which can pack into unsigned 16 bits */
+      _mm_storel_epi64 ((__m128i*) pixel, _mm_packus_epi32 (i, i));
+      if (n_channels == 5)
+        pixel[4] = P2TR_RENDER_TO_S (P2TR_RENDER_LAST_CHANNEL (uvt, coeffs));
+    }
+}
+
+__attribute__ ((target ("avx,f16c"))) static void
+p2tr_mesh_render_run_h_avx (const P2trUVT          *uvt,
+                            glong                   count,
+                            const P2trRenderCoeffs *coeffs,
+                            guint                   n_channels,
+                            gsize                   pixel_stride,
+                            gpointer                dest)
+{
+  guint16 *pixel = (guint16*) dest;
+  __m256d  A = _mm256_loadu_pd (coeffs->A);
+  __m256d  B = _mm256_loadu_pd (coeffs->dB);
+  __m256d  C = _mm256_loadu_pd (coeffs->dC);
+
+  for (; count > 0; --count, ++uvt, pixel += pixel_stride)
+    {
+      __m256d u = _mm256_broadcast_sd (&uvt->u), v = _mm256_broadcast_sd (&uvt->v);
+      __m256d r = _mm256_add_pd (_mm256_add_pd (A, _mm256_mul_pd (v, B)), _mm256_mul_pd (u, C));
+
+      /* Like P2TR_RENDER_TO_H, round to a float and then to a half */
+      _mm_storel_epi64 ((__m128i*) pixel,
+          _mm_cvtps_ph (_mm256_cvtpd_ps (r), _MM_FROUND_TO_NEAREST_INT));
+      if (n_channels == 5)
+        pixel[4] = P2TR_RENDER_TO_H (P2TR_RENDER_LAST_CHANNEL (uvt, coeffs));
+    }
+}
+
+/**
+ * Choose the best kernel for rendering with the given configuration on
+ * the current CPU, or return NULL if the generic code should be used
+ */
+static P2trRenderRunFunc
+p2tr_mesh_render_get_run_func (P2trImageConfig  *config,
+                               P2trRenderFormat  format)
+{
+  if (config->cpp + 1 != 4 && config->cpp + 1 != 5)
+    return NULL;
+
+  if (__builtin_cpu_supports ("avx"))
+    switch (format)
+      {
+        case P2TR_RENDER_FORMAT_F:
+          return p2tr_mesh_render_run_f_avx;
+        case P2TR_RENDER_FORMAT_B:
+          return p2tr_mesh_render_run_b_avx;
+        case P2TR_RENDER_FORMAT_S:
+          return p2tr_mesh_render_run_s_avx;
+        case P2TR_RENDER_FORMAT_H:
+          return __builtin_cpu_supports ("f16c") ? p2tr_mesh_render_run_h_avx : NULL;
+      }
+  else if (__builtin_cpu_supports ("sse2"))
+    switch (format)
+      {
+        case P2TR_RENDER_FORMAT_F:
+          return p2tr_mesh_render_run_f_sse2;
+        case P2TR_RENDER_FORMAT_B:
+          return p2tr_mesh_render_run_b_sse2;
+        default:
+          return NULL;
+      }
+
+  return NULL;
+}
+
+/**
+ * Like @ref P2TR_MESH_RENDER_FROM_CACHE, but split the pixels into runs
+ * of pixels from the same triangle and render each run with a kernel.
+ * The alpha is interpolated like the other channels (from 1 at all the
+ * points of the triangle), so the kernels don't need to know where it
+ * is. The differences between the colors are computed in @ref ctype,
+ * like in @ref P2TR_USE_BARYCENTRIC.
+ * @param run_func The @ref P2trRenderRunFunc to render the runs with
+ */
+#define P2TR_MESH_RENDER_RUNS_FROM_CACHE(uvt_cache,                    \
+                                         dest,                         \
+                                         n,                            \
+                                         pixel_stride,                 \
+                                         cformat,                      \
+                                         ctype,                        \
+                                         convert,                      \
+                                         config,                       \
+                                         pt2col,                       \
+                                         pt2col_user_data,             \
+                                         premultiplied,                \
+                                         run_func)                     \
 G_STMT_START                                                           \
 {                                                                      \
-  gint n = (config)->x_samples * (config)->y_samples;                  \
-  P2trUVT *uvt_cache = g_new (P2trUVT, n);                             \
+  P2trUVT *uvt_p = (uvt_cache);                                        \
+  P2trUVT *uvt_end = uvt_p + (n);                                      \
+  guint n_channels = (config)->cpp + 1;                                \
+  guint alpha = (config)->alpha_last ? (config)->cpp : 0;              \
+  guint first = (config)->alpha_last ? 0 : 1;                          \
+  P2trTriangle *tr_prev = NULL;                                        \
+  P2trPointToColorFuncC pt2col_c = (P2trPointToColorFuncC) (pt2col);   \
+  ctype col[3][P2TR_RENDER_SIMD_MAX_CHANNELS];                         \
+  P2trRenderCoeffs coeffs;                                             \
+  cformat *pixel = (dest);                                             \
+  guint i;                                                             \
+                                                                       \
+  coeffs.A[alpha] = 1;                                                 \
+  coeffs.dB[alpha] = coeffs.dC[alpha] = 0;                             \
                                                                        \
-  p2tr_mesh_render_cache_uvt_exact ((mesh), uvt_cache, n, (config));   \
-  cache_render_func (uvt_cache, (dest), n, (config), (pt2col),         \
-      (pt2col_user_data));                                             \
+  while (uvt_p < uvt_end)                                              \
+    {                                                                  \
+      P2trTriangle *tr_now = uvt_p->tri;                               \
+      P2trUVT *run_end = uvt_p + 1;                                    \
                                                                        \
-  g_free (uvt_cache);                                                  \
+      while (run_end < uvt_end && run_end->tri == tr_now)              \
+        ++run_end;                                                     \
+                                                                       \
+      /* Outside of the triangulation only the alpha is set, unless */ \
+      /* the colors are premultiplied */                               \
+      if (tr_now == NULL)                                              \
+        {                                                              \
+          for (; uvt_p < run_end; ++uvt_p, pixel += (pixel_stride))    \
+            if (premultiplied)                                         \
+              for (i = 0; i < n_channels; ++i)                         \
+                pixel[i] = convert (0);                                \
+            else                                                       \
+              pixel[alpha] = convert (0);                              \
+          continue;                                                    \
+        }                                                              \
+                                                                       \
+      if (tr_now != tr_prev)                                           \
+        {                                                              \
+          for (i = 0; i < 3; ++i)                                      \
+            pt2col_c (P2TR_TRIANGLE_GET_POINT (tr_now, i),             \
+                (gpointer) col[i], pt2col_user_data);                  \
+          for (i = 0; i < (config)->cpp; ++i)                          \
+            {                                                          \
+              coeffs.A[first + i] = col[0][i];                         \
+              coeffs.dB[first + i] = col[1][i] - col[0][i];            \
+              coeffs.dC[first + i] = col[2][i] - col[0][i];            \
+            }                                                          \
+          tr_prev = tr_now;                                            \
+        }                                                              \
+                                                                       \
+      run_func (uvt_p, run_end - uvt_p, &coeffs, n_channels,           \
+          (pixel_stride), pixel);                                      \
+      pixel += (run_end - uvt_p) * (pixel_stride);                     \
+      uvt_p = run_end;                                                 \
+    }                                                                  \
 }                                                                      \
 G_STMT_END
 
+#define P2TR_MESH_RENDER_TRY_RUNS(uvt_cache, dest, n, pixel_stride,    \
+                                  cformat, ctype, convert, format,     \
+                                  config, pt2col, pt2col_user_data,    \
+                                  premultiplied)                       \
+G_STMT_START                                                           \
+{                                                                      \
+  P2trRenderRunFunc run_func =                                         \
+      p2tr_mesh_render_get_run_func ((config), (format));              \
+                                                                       \
+  if (run_func != NULL)                                                \
+    {                                                                  \
+      P2TR_MESH_RENDER_RUNS_FROM_CACHE (uvt_cache, dest, n,            \
+          pixel_stride, cformat, ctype, convert, config, pt2col,       \
+          pt2col_user_data, premultiplied, run_func);                  \
+      return;                                                          \
+    }                                                                  \
+}                                                                      \
+G_STMT_END
+
+#else
+
+#define P2TR_MESH_RENDER_TRY_RUNS(uvt_cache, dest, n, pixel_stride,    \
+                                  cformat, ctype, convert, format,     \
+                                  config, pt2col, pt2col_user_data,    \
+                                  premultiplied)                       \
+G_STMT_START { } G_STMT_END
+
+#endif
+
+/**
+ * The amount of rows rasterized together when rendering a region of
+ * interest. Only the UVT cache of one band of rows exists at a time
+ */
+#define P2TR_MESH_RENDER_BAND_ROWS 16
+
+/**
+ * A generalization of the functions rendering from a UVT cache into
+ * pixels with any stride, used for rendering in any pixel format
+ */
+typedef void (*P2trRenderStridedFunc) (P2trUVT               *uvt_cache,
+                                       gpointer               dest,
+                                       gint                   n,
+                                       gsize                  pixel_stride,
+                                       P2trRenderFlags        flags,
+                                       P2trImageConfig       *config,
+                                       P2trPointToColorFuncC  pt2col,
+                                       gpointer               pt2col_user_data);
+
+static void
+p2tr_mesh_render_roi (P2trMesh              *mesh,
+                      gpointer               dest,
+                      gsize                  channel_size,
+                      gsize                  row_stride,
+                      gsize                  pixel_stride,
+                      P2trImageConfig       *config,
+                      P2trRenderFlags        flags,
+                      guint                  x,
+                      guint                  y,
+                      guint                  width,
+                      guint                  height,
+                      P2trRenderStridedFunc  render,
+                      P2trPointToColorFuncC  pt2col,
+                      gpointer               pt2col_user_data)
+{
+  guint              n_bands = (height + P2TR_MESH_RENDER_BAND_ROWS - 1) / P2TR_MESH_RENDER_BAND_ROWS;
+  GPtrArray        **bands;
+  P2trUVT           *band_cache;
+  guint              b, i;
+
+  if (x + width > config->x_samples || y + height > config->y_samples)
+    p2tr_exception_programmatic ("The region of interest is outside of the image!");
+
+  if (width == 0 || height == 0)
+    return;
+
+  bands = g_new (GPtrArray*, n_bands);
+  band_cache = g_new (P2trUVT, width * MIN (height, P2TR_MESH_RENDER_BAND_ROWS));
+
+  for (b = 0; b < n_bands; b++)
+    bands[b] = g_ptr_array_new ();
+
+  /* Sort the triangles into the bands of rows they may cover */
+  p2tr_mesh_render_bin_triangles (mesh, config, x, y, x + width, y + height,
+      width, P2TR_MESH_RENDER_BAND_ROWS, bands);
+
+  for (b = 0; b < n_bands; b++)
+    {
+      P2trUVTRegion region;
+      gint          row;
+
+      region.x0 = x;
+      region.x1 = x + width;
+      region.y0 = y + b * P2TR_MESH_RENDER_BAND_ROWS;
+      region.y1 = MIN (region.y0 + P2TR_MESH_RENDER_BAND_ROWS, (gint) (y + height));
+      region.stride = width;
+      region.dest = band_cache;
+      region.dest_len = (region.y1 - region.y0) * width;
+
+      for (i = 0; i < region.dest_len; i++)
+        {
+          band_cache[i].tri = NULL;
+          band_cache[i].u = band_cache[i].v = 0;
+        }
+
+      for (i = 0; i < bands[b]->len; i++)
+        p2tr_mesh_render_rasterize_triangle (
+            (P2trTriangle*) g_ptr_array_index (bands[b], i), &region, config);
+
+      for (row = region.y0; row < region.y1; row++)
+        render (band_cache + (row - region.y0) * width,
+            (guint8*) dest + (row - y) * row_stride * channel_size,
+            width, pixel_stride, flags, config, pt2col, pt2col_user_data);
+
+      g_ptr_array_free (bands[b], TRUE);
+    }
+
+  g_free (bands);
+  g_free (band_cache);
+}
+
+/**
+ * Define all the render functions of a pixel format - rendering from a
+ * UVT cache, rendering a region of interest and rendering an image
+ * @param sfx The suffix of the functions of the format
+ * @param cformat The type of the channels in the destination buffer
+ * @param ctype The type of the color channels returned by pt2col
+ * @param color_func The type of the point-to-color functions
+ * @param convert A macro converting a double value into @ref cformat
+ * @param format The matching @ref P2trRenderFormat
+ */
+#define P2TR_MESH_RENDER_DEFINE_FORMAT(sfx, cformat, ctype, color_func, \
+                                       convert, format)                \
+static void                                                            \
+p2tr_mesh_render_from_cache_strided_##sfx (P2trUVT         *uvt_cache, \
+                                           cformat         *dest,      \
+                                           gint             n,         \
+                                           gsize            pixel_stride, \
+                                           P2trRenderFlags  flags,     \
+                                           P2trImageConfig *config,    \
+                                           color_func       pt2col,    \
+                                           gpointer         pt2col_user_data) \
+{                                                                      \
+  gboolean premultiplied = (flags & P2TR_RENDER_PREMULTIPLIED) != 0;   \
+                                                                       \
+  P2TR_MESH_RENDER_TRY_RUNS (uvt_cache, dest, n, pixel_stride,         \
+      cformat, ctype, convert, format, config, pt2col,                 \
+      pt2col_user_data, premultiplied);                                \
+                                                                       \
+  P2TR_MESH_RENDER_FROM_CACHE (uvt_cache,                              \
+      config->x_samples, config->y_samples,                            \
+      dest, n, pixel_stride, cformat, ctype, convert, config->cpp,     \
+      pt2col, pt2col_user_data,                                        \
+      config->alpha_last, premultiplied);                              \
+}                                                                      \
+                                                                       \
+void                                                                   \
+p2tr_mesh_render_from_cache_##sfx (P2trUVT         *uvt_cache,         \
+                                   cformat         *dest,              \
+                                   gint             n,                 \
+                                   P2trImageConfig *config,            \
+                                   color_func       pt2col,            \
+                                   gpointer         pt2col_user_data)  \
+{                                                                      \
+  p2tr_mesh_render_from_cache_strided_##sfx (uvt_cache, dest, n,       \
+      config->cpp + 1, 0, config, pt2col, pt2col_user_data);           \
+}                                                                      \
+                                                                       \
+void                                                                   \
+p2tr_mesh_render_roi_##sfx (P2trMesh        *mesh,                     \
+                            cformat         *dest,                     \
+                            gsize            row_stride,               \
+                            gsize            pixel_stride,             \
+                            P2trImageConfig *config,                   \
+                            P2trRenderFlags  flags,                    \
+                            guint            x,                        \
+                            guint            y,                        \
+                            guint            width,                    \
+                            guint            height,                   \
+                            color_func       pt2col,                   \
+                            gpointer         pt2col_user_data)         \
+{                                                                      \
+  p2tr_mesh_render_roi (mesh, dest, sizeof (cformat), row_stride,      \
+      pixel_stride, config, flags, x, y, width, height,                \
+      (P2trRenderStridedFunc) p2tr_mesh_render_from_cache_strided_##sfx, \
+      (P2trPointToColorFuncC) pt2col, pt2col_user_data);               \
+}                                                                      \
+                                                                       \
+void                                                                   \
+p2tr_mesh_render_##sfx (P2trMesh        *mesh,                         \
+                        cformat         *dest,                         \
+                        P2trImageConfig *config,                       \
+                        color_func       pt2col,                       \
+                        gpointer         pt2col_user_data)             \
+{                                                                      \
+  p2tr_mesh_render_roi_##sfx (mesh, dest,                              \
+      config->x_samples * (config->cpp + 1), config->cpp + 1, config,  \
+      0, 0, 0, config->x_samples, config->y_samples,                   \
+      pt2col, pt2col_user_data);                                       \
+}
+
+P2TR_MESH_RENDER_DEFINE_FORMAT (f, gfloat, gfloat, P2trPointToColorFuncF,
+                                P2TR_RENDER_TO_F, P2TR_RENDER_FORMAT_F)
+P2TR_MESH_RENDER_DEFINE_FORMAT (b, guint8, guint8, P2trPointToColorFuncB,
+                                P2TR_RENDER_TO_B, P2TR_RENDER_FORMAT_B)
+P2TR_MESH_RENDER_DEFINE_FORMAT (s, guint16, guint16, P2trPointToColorFuncS,
+                                P2TR_RENDER_TO_S, P2TR_RENDER_FORMAT_S)
+P2TR_MESH_RENDER_DEFINE_FORMAT (h, guint16, gfloat, P2trPointToColorFuncF,
+                                P2TR_RENDER_TO_H, P2TR_RENDER_FORMAT_H)
+
+/**
+ * Coverage values this close to 0 or 1 are rounded to them, so that
+ * rounding errors don't give fractional alpha to pixels which are not
+ * crossed by the outline of the mesh
+ */
+#define P2TR_COVERAGE_EPSILON 1e-6
+
+/**
+ * The state of computing the coverage of an image. The coverage is
+ * accumulated in pixel coordinates, where pixel (x,y) is the square
+ * between (x,y) and (x+1,y+1) - the sample of the pixel is its center.
+ * A line adds to the pixels which it crosses, and to the pixel right
+ * of each of them, so that the sum of each row up to a pixel is the
+ * area of that pixel that is right of the lines (signed by their
+ * direction). This is the same accumulation used by many font
+ * rasterizers.
+ */
+typedef struct
+{
+  /** The accumulated area of each pixel, row by row */
+  gdouble         *acc;
+  gint             width, height;
+  /** The UVT cache of the image (or NULL), in which samples outside of
+   *  the mesh whose pixels are crossed by the outline are assigned to
+   *  the nearest point on the outline */
+  P2trUVT         *uvt;
+  P2trImageConfig *config;
+  /** The triangle and the edge (by index) whose line is added */
+  P2trTriangle    *tri;
+  gint             edge;
+} P2trCoverage;
+
+static void
+p2tr_coverage_add (gdouble *row,
+                   gint     width,
+                   gint     x,
+                   gdouble  value)
+{
+  /* Area left of the image is part of the sum of every pixel in the
+   * row, and area right of the image isn't part of any */
+  if (x < width)
+    row[MAX (x, 0)] += value;
+}
+
+/**
+ * Assign a sample outside of the mesh to the nearest point on the edge
+ * being added, unless the sample is already inside a triangle
+ */
+static void
+p2tr_coverage_assign (P2trCoverage *self,
+                      gint          x,
+                      gint          y)
+{
+  P2trUVT           *uvt = &self->uvt[y * self->width + x];
+  const P2trVector2 *P = &P2TR_TRIANGLE_GET_POINT (self->tri, self->edge)->c;
+  const P2trVector2 *Q = &P2TR_TRIANGLE_GET_POINT (self->tri, (self->edge + 1) % 3)->c;
+  gdouble            Sx = self->config->min_x + x * self->config->step_x;
+  gdouble            Sy = self->config->min_y + y * self->config->step_y;
+  gdouble            dx = Q->x - P->x, dy = Q->y - P->y, t;
+  gdouble            weight[3] = { 0, 0, 0 };
+
+  if (uvt->tri != NULL)
+    return;
+
+  t = ((Sx - P->x) * dx + (Sy - P->y) * dy) / (dx * dx + dy * dy);
+  t = CLAMP (t, 0, 1);
+
+  /* Edge i goes from point i to point i + 1 */
+  weight[self->edge] = 1 - t;
+  weight[(self->edge + 1) % 3] = t;
+
+  uvt->tri = self->tri;
+  uvt->u = weight[2];
+  uvt->v = weight[1];
+}
+
+/**
+ * Add the part of a line inside one row of pixels. The line goes from
+ * @ref x0 to @ref x1 (where x0 <= x1) while going down a distance
+ * @ref dy in the row (negative when going up)
+ */
+static void
+p2tr_coverage_add_span (P2trCoverage *self,
+                        gint          y,
+                        gdouble       x0,
+                        gdouble       x1,
+                        gdouble       dy)
+{
+  gdouble *row = self->acc + y * self->width;
+  gint     x0i = (gint) floor (x0), x1i = (gint) ceil (x1), x;
+
+  if (x1i <= x0i + 1)
+    {
+      /* The line is inside one pixel - the area right of it is split by
+       * the average position of the line */
+      gdouble xm = 0.5 * (x0 + x1) - x0i;
+      p2tr_coverage_add (row, self->width, x0i, dy * (1 - xm));
+      p2tr_coverage_add (row, self->width, x0i + 1, dy * xm);
+    }
+  else
+    {
+      /* The area right of the line grows linearly while it crosses
+       * whole pixels, and quadratically in its first and last pixels */
+      gdouble s = 1 / (x1 - x0);
+      gdouble x0f = x0 - x0i, x1f = x1 - x1i + 1;
+      gdouble a0 = 0.5 * s * (1 - x0f) * (1 - x0f);
+      gdouble am = 0.5 * s * x1f * x1f;
+
+      p2tr_coverage_add (row, self->width, x0i, dy * a0);
+      if (x1i == x0i + 2)
+        p2tr_coverage_add (row, self->width, x0i + 1, dy * (1 - a0 - am));
+      else
+        {
+          gdouble a1 = s * (1.5 - x0f);
+          gdouble a2 = a1 + (x1i - x0i - 3) * s;
+
+          p2tr_coverage_add (row, self->width, x0i + 1, dy * (a1 - a0));
+          for (x = x0i + 2; x < x1i - 1; x++)
+            p2tr_coverage_add (row, self->width, x, dy * s);
+          p2tr_coverage_add (row, self->width, x1i - 1, dy * (1 - a2 - am));
+        }
+      p2tr_coverage_add (row, self->width, x1i, dy * am);
+    }
+
+  if (self->uvt != NULL)
+    for (x = MAX (x0i, 0); x <= MIN (MAX (x0i, x1i - 1), self->width - 1); x++)
+      p2tr_coverage_assign (self, x, y);
+}
+
+/**
+ * Add a line, whose X coordinates are at most one pixel outside of
+ * the image
+ */
+static void
+p2tr_coverage_add_line (P2trCoverage *self,
+                        gdouble       x0,
+                        gdouble       y0,
+                        gdouble       x1,
+                        gdouble       y1)
+{
+  gdouble dir = 1, dxdy, tmp;
+  gint    y, y_first, y_last;
+
+  if (y0 == y1)
+    return;
+
+  if (y0 > y1)
+    {
+      tmp = x0; x0 = x1; x1 = tmp;
+      tmp = y0; y0 = y1; y1 = tmp;
+      dir = -1;
+    }
+
+  dxdy = (x1 - x0) / (y1 - y0);
+  y_first = (y0 <= 0) ? 0 : (y0 >= self->height) ? self->height : (gint) floor (y0);
+  y_last  = (y1 <= 0) ? 0 : (y1 >= self->height) ? self->height : (gint) ceil (y1);
+
+  for (y = y_first; y < y_last; y++)
+    {
+      gdouble ya = MAX (y, y0), yb = MIN (y + 1, y1);
+      gdouble xa = x0 + dxdy * (ya - y0), xb = x0 + dxdy * (yb - y0);
+
+      p2tr_coverage_add_span (self, y, MIN (xa, xb), MAX (xa, xb), dir * (yb - ya));
+    }
+}
+
+/**
+ * Add an edge on the outline of the mesh. The parts of the edge left or
+ * right of the image are moved to one pixel outside of it, which keeps
+ * the sums of all the pixels inside the image
+ */
+static void
+p2tr_coverage_add_edge (P2trCoverage *self)
+{
+  const P2trVector2 *P = &P2TR_TRIANGLE_GET_POINT (self->tri, self->edge)->c;
+  const P2trVector2 *Q = &P2TR_TRIANGLE_GET_POINT (self->tri, (self->edge + 1) % 3)->c;
+  P2trImageConfig   *config = self->config;
+  gdouble            x0 = (P->x - config->min_x) / config->step_x + 0.5;
+  gdouble            y0 = (P->y - config->min_y) / config->step_y + 0.5;
+  gdouble            x1 = (Q->x - config->min_x) / config->step_x + 0.5;
+  gdouble            y1 = (Q->y - config->min_y) / config->step_y + 0.5;
+  gdouble            t[4], tmp, xa, xb;
+  gint               n = 0, i, j;
+
+  /* Split the edge where it crosses the sides of the image */
+  t[n++] = 0;
+  if (x0 != x1)
+    {
+      tmp = (-1 - x0) / (x1 - x0);
+      if (tmp > 0 && tmp < 1)
+        t[n++] = tmp;
+      tmp = (self->width + 1 - x0) / (x1 - x0);
+      if (tmp > 0 && tmp < 1)
+        t[n++] = tmp;
+    }
+  t[n++] = 1;
+
+  for (i = 1; i < n; i++)
+    for (j = i; j > 0 && t[j] < t[j - 1]; j--)
+      {
+        tmp = t[j]; t[j] = t[j - 1]; t[j - 1] = tmp;
+      }
+
+  for (i = 0; i + 1 < n; i++)
+    {
+      xa = CLAMP (x0 + t[i] * (x1 - x0), -1, self->width + 1);
+      xb = CLAMP (x0 + t[i + 1] * (x1 - x0), -1, self->width + 1);
+      p2tr_coverage_add_line (self,
+          xa, y0 + t[i] * (y1 - y0),
+          xb, y0 + t[i + 1] * (y1 - y0));
+    }
+}
+
 void
-p2tr_mesh_render_from_cache_f (P2trUVT               *uvt_cache,
-                               gfloat                *dest,
-                               gint                   n,
-                               P2trImageConfig       *config,
-                               P2trPointToColorFuncF  pt2col,
-                               gpointer               pt2col_user_data)
-{
-  P2TR_MESH_RENDER_FROM_CACHE (uvt_cache,
-      config->x_samples, config->y_samples,
-      dest, n, gfloat, config->cpp,
-      pt2col, pt2col_user_data,
-      config->alpha_last);
+p2tr_mesh_render_cache_coverage (P2trMesh        *mesh,
+                                 gfloat          *dest,
+                                 P2trUVT         *uvt_cache,
+                                 P2trImageConfig *config)
+{
+  P2trCoverage      cov;
+  P2trDenseSetIter  iter;
+  gdouble           sum;
+  gint              x, y;
+
+  cov.width = config->x_samples;
+  cov.height = config->y_samples;
+  cov.acc = g_new0 (gdouble, cov.width * cov.height);
+  cov.uvt = uvt_cache;
+  cov.config = config;
+
+  /* The edges of the outline of the mesh are the ones without a
+   * triangle on their other side. Taking them in the direction of their
+   * triangles, the inside of the mesh is always on the same side of
+   * them (including for holes), so the sum of each pixel is its
+   * coverage up to the sign */
+  p2tr_dense_set_iter_init (&iter, mesh->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*)&cov.tri))
+    for (cov.edge = 0; cov.edge < 3; cov.edge++)
+      if (cov.tri->edges[cov.edge]->mirror->tri == NULL)
+        p2tr_coverage_add_edge (&cov);
+
+  for (y = 0; y < cov.height; y++)
+    {
+      sum = 0;
+      for (x = 0; x < cov.width; x++)
+        {
+          gdouble value;
+
+          sum += cov.acc[y * cov.width + x];
+          value = MIN (ABS (sum), 1);
+          if (value < P2TR_COVERAGE_EPSILON)
+            value = 0;
+          else if (value > 1 - P2TR_COVERAGE_EPSILON)
+            value = 1;
+          dest[y * cov.width + x] = (gfloat) value;
+        }
+    }
+
+  g_free (cov.acc);
 }
 
 void
-p2tr_mesh_render_f (P2trMesh              *mesh,
-                    gfloat                *dest,
-                    P2trImageConfig       *config,
-                    P2trPointToColorFuncF  pt2col,
-                    gpointer               pt2col_user_data)
+p2tr_mesh_render_antialiased_f (P2trMesh              *mesh,
+                                gfloat                *dest,
+                                P2trImageConfig       *config,
+                                P2trRenderFlags        flags,
+                                P2trPointToColorFuncF  pt2col,
+                                gpointer               pt2col_user_data)
 {
-  P2TR_MESH_RENDER (mesh, dest, config, pt2col, pt2col_user_data,
-      p2tr_mesh_render_from_cache_f);
+  gint     n = config->x_samples * config->y_samples, i;
+  guint    cpp = config->cpp, alpha = config->alpha_last ? cpp : 0, j;
+  P2trUVT *uvt = g_new (P2trUVT, n);
+  gfloat  *coverage = g_new (gfloat, n);
+
+  p2tr_mesh_render_cache_uvt_exact (mesh, uvt, n, config);
+  p2tr_mesh_render_cache_coverage (mesh, coverage, uvt, config);
+  p2tr_mesh_render_from_cache_strided_f (uvt, dest, n, cpp + 1, flags,
+      config, pt2col, pt2col_user_data);
+
+  /* Only the pixels on the outline have fractional coverage */
+  for (i = 0; i < n; i++)
+    if (coverage[i] != 1 && uvt[i].tri != NULL)
+      {
+        gfloat *pixel = dest + i * (cpp + 1);
+
+        pixel[alpha] = coverage[i];
+        if (flags & P2TR_RENDER_PREMULTIPLIED)
+          for (j = 0; j <= cpp; j++)
+            if (j != alpha)
+              pixel[j] *= coverage[i];
+      }
+
+  g_free (coverage);
+  g_free (uvt);
+}
+
+/**
+ * The colors of a range of points, computed by one thread
+ */
+typedef struct
+{
+  P2trDenseSet          *points;
+  guint                  start, end;
+  P2trColorTable        *table;
+  P2trPointToColorFuncC  pt2col;
+  gpointer               pt2col_user_data;
+} P2trColorTableJob;
+
+static gpointer
+p2tr_color_table_job_run (gpointer data)
+{
+  P2trColorTableJob *job = (P2trColorTableJob*) data;
+  gsize              color_size = job->table->cpp * job->table->channel_size;
+  guint              i;
+
+  for (i = job->start; i < job->end; i++)
+    {
+      P2trPoint *pt = (P2trPoint*) p2tr_dense_set_get (job->points, i);
+      guint      index = P2TR_HANDLE_INDEX (pt->handle);
+
+      job->table->handles[index] = pt->handle;
+      job->pt2col (pt, job->table->colors + index * color_size,
+          job->pt2col_user_data);
+    }
+
+  return NULL;
+}
+
+static P2trColorTable*
+p2tr_color_table_new (P2trMesh              *mesh,
+                      guint                  cpp,
+                      gsize                  channel_size,
+                      P2trPointToColorFuncC  pt2col,
+                      gpointer               pt2col_user_data,
+                      guint                  n_threads)
+{
+  P2trColorTable     *self = g_slice_new (P2trColorTable);
+  P2trDenseSet       *points = mesh->points;
+  guint               count = p2tr_dense_set_size (points);
+  P2trColorTableJob  *jobs;
+  GThread           **threads;
+  guint               chunk, i;
+
+  self->cpp = cpp;
+  self->channel_size = channel_size;
+  /* Index the colors by the slots of the points, so that a lookup
+   * doesn't need the position of the point in the dense array */
+  self->n_colors = points->slot_count;
+  self->colors = (guint8*) g_malloc0 (self->n_colors * cpp * channel_size);
+  self->handles = g_new (P2trHandle, self->n_colors);
+  for (i = 0; i < self->n_colors; i++)
+    self->handles[i] = P2TR_HANDLE_NONE;
+
+  if (n_threads == 0)
+    n_threads = 1;
+
+  jobs = g_new (P2trColorTableJob, n_threads);
+  threads = g_new (GThread*, n_threads);
+  chunk = (count + n_threads - 1) / n_threads;
+
+  for (i = 0; i < n_threads; i++)
+    {
+      jobs[i].points           = points;
+      jobs[i].start            = MIN (i * chunk, count);
+      jobs[i].end              = MIN ((i + 1) * chunk, count);
+      jobs[i].table            = self;
+      jobs[i].pt2col           = pt2col;
+      jobs[i].pt2col_user_data = pt2col_user_data;
+    }
+
+  for (i = 1; i < n_threads; i++)
+    threads[i] = g_thread_new ("p2tr-color-table", p2tr_color_table_job_run, &jobs[i]);
+  p2tr_color_table_job_run (&jobs[0]);
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  g_free (threads);
+  g_free (jobs);
+
+  return self;
+}
+
+P2trColorTable*
+p2tr_color_table_new_f (P2trMesh              *mesh,
+                        guint                  cpp,
+                        P2trPointToColorFuncF  pt2col,
+                        gpointer               pt2col_user_data,
+                        guint                  n_threads)
+{
+  return p2tr_color_table_new (mesh, cpp, sizeof (gfloat),
+      (P2trPointToColorFuncC) pt2col, pt2col_user_data, n_threads);
+}
+
+P2trColorTable*
+p2tr_color_table_new_b (P2trMesh              *mesh,
+                        guint                  cpp,
+                        P2trPointToColorFuncB  pt2col,
+                        gpointer               pt2col_user_data,
+                        guint                  n_threads)
+{
+  return p2tr_color_table_new (mesh, cpp, sizeof (guint8),
+      (P2trPointToColorFuncC) pt2col, pt2col_user_data, n_threads);
+}
+
+P2trColorTable*
+p2tr_color_table_new_s (P2trMesh              *mesh,
+                        guint                  cpp,
+                        P2trPointToColorFuncS  pt2col,
+                        gpointer               pt2col_user_data,
+                        guint                  n_threads)
+{
+  return p2tr_color_table_new (mesh, cpp, sizeof (guint16),
+      (P2trPointToColorFuncC) pt2col, pt2col_user_data, n_threads);
 }
 
 void
-p2tr_mesh_render_from_cache_b (P2trUVT               *uvt_cache,
-                               guint8                *dest,
-                               gint                   n,
-                               P2trImageConfig       *config,
-                               P2trPointToColorFuncB  pt2col,
-                               gpointer               pt2col_user_data)
-{
-  P2TR_MESH_RENDER_FROM_CACHE (uvt_cache,
-      config->x_samples, config->y_samples,
-      dest, n, guint8, config->cpp,
-      pt2col, pt2col_user_data,
-      config->alpha_last);
+p2tr_color_table_free (P2trColorTable *self)
+{
+  g_free (self->handles);
+  g_free (self->colors);
+  g_slice_free (P2trColorTable, self);
+}
+
+static inline void
+p2tr_color_table_lookup (P2trColorTable *self,
+                         P2trPoint      *point,
+                         gpointer        dest,
+                         gsize           color_size)
+{
+  guint index = P2TR_HANDLE_INDEX (point->handle);
+
+  /* Points added to the mesh after the table was built have no color,
+   * even if they took the slot of a point that had one */
+  if (index < self->n_colors && self->handles[index] == point->handle)
+    memcpy (dest, self->colors + index * color_size, color_size);
+  else
+    memset (dest, 0, color_size);
+}
+
+void
+p2tr_color_table_lookup_f (P2trPoint *point,
+                           gfloat    *dest,
+                           gpointer   table)
+{
+  P2trColorTable *self = (P2trColorTable*) table;
+
+  p2tr_color_table_lookup (self, point, dest, self->cpp * sizeof (gfloat));
+}
+
+void
+p2tr_color_table_lookup_b (P2trPoint *point,
+                           guint8    *dest,
+                           gpointer   table)
+{
+  P2trColorTable *self = (P2trColorTable*) table;
+
+  p2tr_color_table_lookup (self, point, dest, self->cpp * sizeof (guint8));
+}
+
+void
+p2tr_color_table_lookup_s (P2trPoint *point,
+                           guint16   *dest,
+                           gpointer   table)
+{
+  P2trColorTable *self = (P2trColorTable*) table;
+
+  p2tr_color_table_lookup (self, point, dest, self->cpp * sizeof (guint16));
+}
+
+/**
+ * A generalization of the functions rendering from a UVT cache, used
+ * for rendering the tiles in any pixel format
+ */
+typedef void (*P2trRenderFromCacheFunc) (P2trUVT               *uvt_cache,
+                                         gpointer               dest,
+                                         gint                   n,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncC  pt2col,
+                                         gpointer               pt2col_user_data);
+
+typedef struct
+{
+  P2trImageConfig         *config;
+  /** The samples of the tile. The cache is only allocated while the
+   *  tile is rendered */
+  P2trUVTRegion            region;
+  /** The triangles which may cover samples of the tile */
+  GPtrArray               *tris;
+  /** The destination buffer of the entire image */
+  guint8                  *dest;
+  gsize                    pixel_size;
+  P2trRenderFromCacheFunc  render;
+  P2trPointToColorFuncC    pt2col;
+  gpointer                 pt2col_user_data;
+} P2trRenderTile;
+
+static void
+p2tr_mesh_render_tile (gpointer data,
+                       gpointer user_data)
+{
+  P2trRenderTile *tile = (P2trRenderTile*) data;
+  P2trUVTRegion  *region = &tile->region;
+  gint            w = region->x1 - region->x0, h = region->y1 - region->y0;
+  guint           i;
+  gint            y;
+
+  region->dest_len = w * h;
+  region->dest = g_new (P2trUVT, region->dest_len);
+
+  for (i = 0; i < region->dest_len; i++)
+    {
+      region->dest[i].tri = NULL;
+      region->dest[i].u = region->dest[i].v = 0;
+    }
+
+  for (i = 0; i < tile->tris->len; i++)
+    p2tr_mesh_render_rasterize_triangle (
+        (P2trTriangle*) g_ptr_array_index (tile->tris, i), region, tile->config);
+
+  /* The rows of the tile aren't contiguous in the image, so render
+   * each one separately */
+  for (y = 0; y < h; y++)
+    tile->render (region->dest + y * w,
+        tile->dest + ((region->y0 + y) * tile->config->x_samples + region->x0) * tile->pixel_size,
+        w, tile->config, tile->pt2col, tile->pt2col_user_data);
+
+  g_free (region->dest);
+  region->dest = NULL;
+}
+
+static void
+p2tr_mesh_render_tiled (P2trMesh                *mesh,
+                        gpointer                 dest,
+                        gsize                    pixel_size,
+                        P2trImageConfig         *config,
+                        P2trRenderFromCacheFunc  render,
+                        P2trPointToColorFuncC    pt2col,
+                        gpointer                 pt2col_user_data,
+                        guint                    tile_size,
+                        guint                    n_threads)
+{
+  P2trRenderTile   *tiles;
+  GPtrArray       **tris;
+  guint             tiles_x, tiles_y, i;
+
+  if (tile_size == 0)
+    tile_size = P2TR_MESH_RENDER_TILE_SIZE;
+
+  tiles_x = (config->x_samples + tile_size - 1) / tile_size;
+  tiles_y = (config->y_samples + tile_size - 1) / tile_size;
+  tiles = g_new (P2trRenderTile, tiles_x * tiles_y);
+  tris = g_new (GPtrArray*, tiles_x * tiles_y);
+
+  for (i = 0; i < tiles_x * tiles_y; i++)
+    {
+      P2trRenderTile *tile = &tiles[i];
+
+      tile->config = config;
+      tile->region.x0 = (i % tiles_x) * tile_size;
+      tile->region.y0 = (i / tiles_x) * tile_size;
+      tile->region.x1 = MIN (tile->region.x0 + tile_size, config->x_samples);
+      tile->region.y1 = MIN (tile->region.y0 + tile_size, config->y_samples);
+      tile->region.stride = tile->region.x1 - tile->region.x0;
+      tile->tris = g_ptr_array_new ();
+      tile->dest = (guint8*) dest;
+      tile->pixel_size = pixel_size;
+      tile->render = render;
+      tile->pt2col = pt2col;
+      tile->pt2col_user_data = pt2col_user_data;
+    }
+
+  /* Sort the triangles into the tiles they may cover, so that each
+   * tile only rasterizes the triangles near it */
+  for (i = 0; i < tiles_x * tiles_y; i++)
+    tris[i] = tiles[i].tris;
+  p2tr_mesh_render_bin_triangles (mesh, config, 0, 0,
+      config->x_samples, config->y_samples, tile_size, tile_size, tris);
+
+  if (n_threads <= 1)
+    {
+      for (i = 0; i < tiles_x * tiles_y; i++)
+        p2tr_mesh_render_tile (&tiles[i], NULL);
+    }
+  else
+    {
+      GThreadPool *pool = g_thread_pool_new (p2tr_mesh_render_tile, NULL,
+          n_threads, FALSE, NULL);
+
+      for (i = 0; i < tiles_x * tiles_y; i++)
+        g_thread_pool_push (pool, &tiles[i], NULL);
+
+      /* Wait for all the tiles to be rendered */
+      g_thread_pool_free (pool, FALSE, TRUE);
+    }
+
+  for (i = 0; i < tiles_x * tiles_y; i++)
+    g_ptr_array_free (tiles[i].tris, TRUE);
+  g_free (tris);
+  g_free (tiles);
+}
+
+void
+p2tr_mesh_render_tiled_f (P2trMesh              *mesh,
+                          gfloat                *dest,
+                          P2trImageConfig       *config,
+                          P2trPointToColorFuncF  pt2col,
+                          gpointer               pt2col_user_data,
+                          guint                  tile_size,
+                          guint                  n_threads)
+{
+  p2tr_mesh_render_tiled (mesh, dest, sizeof (gfloat) * (config->cpp + 1),
+      config, (P2trRenderFromCacheFunc) p2tr_mesh_render_from_cache_f,
+      (P2trPointToColorFuncC) pt2col, pt2col_user_data,
+      tile_size, n_threads);
 }
 
 void
-p2tr_mesh_render_b (P2trMesh              *mesh,
-                    guint8                *dest,
-                    P2trImageConfig       *config,
-                    P2trPointToColorFuncB  pt2col,
-                    gpointer               pt2col_user_data)
-{
-  P2TR_MESH_RENDER (mesh, dest, config, pt2col, pt2col_user_data,
-      p2tr_mesh_render_from_cache_b);
+p2tr_mesh_render_tiled_b (P2trMesh              *mesh,
+                          guint8                *dest,
+                          P2trImageConfig       *config,
+                          P2trPointToColorFuncB  pt2col,
+                          gpointer               pt2col_user_data,
+                          guint                  tile_size,
+                          guint                  n_threads)
+{
+  p2tr_mesh_render_tiled (mesh, dest, sizeof (guint8) * (config->cpp + 1),
+      config, (P2trRenderFromCacheFunc) p2tr_mesh_render_from_cache_b,
+      (P2trPointToColorFuncC) pt2col, pt2col_user_data,
+      tile_size, n_threads);
+}
+
+/**
+ * The amount of rows rasterized together when computing a compact UVT
+ * cache. Only the UVT cache of one band of rows exists at a time
+ */
+#define P2TR_UVT_COMPACT_BAND_ROWS 32
+
+/**
+ * The amount of samples decoded together when rendering from a compact
+ * UVT cache
+ */
+#define P2TR_UVT_COMPACT_CHUNK 1024
+
+static guint16
+p2tr_uvt_compact_encode (gdouble value)
+{
+  /* Samples on the edges of a triangle may be slightly outside of it */
+  value = CLAMP (value, 0, 1);
+  return (guint16) (value * P2TR_UVT_COMPACT_SCALE + 0.5);
+}
+
+void
+p2tr_mesh_render_cache_uvt_compact (P2trMesh        *mesh,
+                                    P2trUVTCompact  *dest,
+                                    gint             dest_len,
+                                    P2trImageConfig *config)
+{
+  gint               width = config->x_samples;
+  guint              n_bands = (config->y_samples + P2TR_UVT_COMPACT_BAND_ROWS - 1) / P2TR_UVT_COMPACT_BAND_ROWS;
+  GPtrArray        **bands = g_new (GPtrArray*, n_bands);
+  P2trUVT           *band_cache = g_new (P2trUVT, width * P2TR_UVT_COMPACT_BAND_ROWS);
+  guint              b, i;
+
+  for (b = 0; b < n_bands; b++)
+    bands[b] = g_ptr_array_new ();
+
+  /* Sort the triangles into the bands of rows they may cover */
+  p2tr_mesh_render_bin_triangles (mesh, config, 0, 0,
+      width, config->y_samples, width, P2TR_UVT_COMPACT_BAND_ROWS, bands);
+
+  for (b = 0; b < n_bands; b++)
+    {
+      P2trUVTRegion   region;
+      P2trUVTCompact *band_dest = dest + b * P2TR_UVT_COMPACT_BAND_ROWS * width;
+
+      region.x0 = 0;
+      region.x1 = width;
+      region.y0 = b * P2TR_UVT_COMPACT_BAND_ROWS;
+      region.y1 = MIN (region.y0 + P2TR_UVT_COMPACT_BAND_ROWS, (gint) config->y_samples);
+      region.stride = width;
+      region.dest = band_cache;
+
+      if (region.y0 * width >= dest_len)
+        break;
+
+      region.dest_len = MIN ((region.y1 - region.y0) * width, dest_len - region.y0 * width);
+
+      for (i = 0; i < region.dest_len; i++)
+        {
+          band_cache[i].tri = NULL;
+          band_cache[i].u = band_cache[i].v = 0;
+        }
+
+      for (i = 0; i < bands[b]->len; i++)
+        p2tr_mesh_render_rasterize_triangle (
+            (P2trTriangle*) g_ptr_array_index (bands[b], i), &region, config);
+
+      for (i = 0; i < region.dest_len; i++)
+        {
+          P2trUVT *uvt = &band_cache[i];
+
+          if (uvt->tri == NULL)
+            {
+              band_dest[i].tri = P2TR_HANDLE_NONE;
+              band_dest[i].u = band_dest[i].v = 0;
+            }
+          else
+            {
+              band_dest[i].tri = uvt->tri->handle;
+              band_dest[i].u = p2tr_uvt_compact_encode (uvt->u);
+              band_dest[i].v = p2tr_uvt_compact_encode (uvt->v);
+            }
+        }
+    }
+
+  for (b = 0; b < n_bands; b++)
+    g_ptr_array_free (bands[b], TRUE);
+  g_free (bands);
+  g_free (band_cache);
+}
+
+/**
+ * Decode a part of a compact UVT cache into a regular UVT cache
+ */
+static void
+p2tr_mesh_render_decode_compact (P2trMesh       *mesh,
+                                 P2trUVTCompact *src,
+                                 P2trUVT        *dest,
+                                 gint            n)
+{
+  P2trHandle    prev_handle = P2TR_HANDLE_NONE;
+  P2trTriangle *prev_tri = NULL;
+  gint          i;
+
+  for (i = 0; i < n; i++)
+    {
+      /* Neighbouring samples are usually in the same triangle, so only
+       * look up the handle when it changes */
+      if (src[i].tri != prev_handle)
+        {
+          prev_handle = src[i].tri;
+          prev_tri = (prev_handle == P2TR_HANDLE_NONE) ? NULL
+              : (P2trTriangle*) p2tr_dense_set_lookup (mesh->triangles, prev_handle);
+        }
+
+      dest[i].tri = prev_tri;
+      dest[i].u = src[i].u / (gdouble) P2TR_UVT_COMPACT_SCALE;
+      dest[i].v = src[i].v / (gdouble) P2TR_UVT_COMPACT_SCALE;
+    }
+}
+
+void
+p2tr_mesh_render_from_compact_cache_f (P2trMesh              *mesh,
+                                       P2trUVTCompact        *uvt_cache,
+                                       gfloat                *dest,
+                                       gint                   n,
+                                       P2trImageConfig       *config,
+                                       P2trPointToColorFuncF  pt2col,
+                                       gpointer               pt2col_user_data)
+{
+  P2trUVT chunk[P2TR_UVT_COMPACT_CHUNK];
+  gint    done, count;
+
+  for (done = 0; done < n; done += count)
+    {
+      count = MIN (n - done, P2TR_UVT_COMPACT_CHUNK);
+      p2tr_mesh_render_decode_compact (mesh, uvt_cache + done, chunk, count);
+      p2tr_mesh_render_from_cache_f (chunk, dest + done * (config->cpp + 1),
+          count, config, pt2col, pt2col_user_data);
+    }
+}
+
+void
+p2tr_mesh_render_from_compact_cache_b (P2trMesh              *mesh,
+                                       P2trUVTCompact        *uvt_cache,
+                                       guint8                *dest,
+                                       gint                   n,
+                                       P2trImageConfig       *config,
+                                       P2trPointToColorFuncB  pt2col,
+                                       gpointer               pt2col_user_data)
+{
+  P2trUVT chunk[P2TR_UVT_COMPACT_CHUNK];
+  gint    done, count;
+
+  for (done = 0; done < n; done += count)
+    {
+      count = MIN (n - done, P2TR_UVT_COMPACT_CHUNK);
+      p2tr_mesh_render_decode_compact (mesh, uvt_cache + done, chunk, count);
+      p2tr_mesh_render_from_cache_b (chunk, dest + done * (config->cpp + 1),
+          count, config, pt2col, pt2col_user_data);
+    }
 }
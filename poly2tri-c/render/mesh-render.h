@@ -82,6 +82,14 @@ typedef void (*P2trPointToColorFuncF)   (P2trPoint            *point,
                                          gfloat               *dest,
                                          gpointer              user_data);
 
+/**
+ * Similar to @ref P2trPointToColorFuncB, but with 16 bit unsigned
+ * integer data types (guint16) for each color component
+ */
+typedef void (*P2trPointToColorFuncS)   (P2trPoint            *point,
+                                         guint16              *dest,
+                                         gpointer              user_data);
+
 /**
  * A generalization of all the point-to-color functions. This is used
  * only for type casting inside the library and should not be used
@@ -121,6 +129,31 @@ void   p2tr_mesh_render_cache_uvt_exact (P2trMesh             *mesh,
                                          gint                  dest_len,
                                          P2trImageConfig      *config);
 
+/**
+ * The size of the tiles in which @ref p2tr_mesh_render_update_uvt_cache
+ * recomputes samples
+ */
+#define P2TR_UVT_UPDATE_TILE_SIZE 32
+
+/**
+ * Update a UVT cache computed with @ref p2tr_mesh_render_cache_uvt_exact
+ * after the mesh was changed. Only the samples in the tiles touched by
+ * the changed areas are recomputed, and the result is the same as
+ * computing the cache again.
+ * @param mesh The mesh, whose changes are tracked with
+ *        @ref p2tr_mesh_track_changes since the cache was computed
+ * @param dest The UVT cache
+ * @param dest_len The amount of samples in the cache
+ * @param config The render configuration the cache was computed with
+ * @param changes The changes of the mesh since the cache was computed,
+ *        as returned by @ref p2tr_mesh_take_changes
+ */
+void   p2tr_mesh_render_update_uvt_cache (P2trMesh            *mesh,
+                                          P2trUVT             *dest,
+                                          gint                 dest_len,
+                                          P2trImageConfig     *config,
+                                          GArray              *changes);
+
 /**
  * Render a mesh using a UVT cache that was computed for the given
  * area, together with a point-to-color function.
@@ -172,4 +205,361 @@ void   p2tr_mesh_render_b               (P2trMesh              *mesh,
                                          P2trPointToColorFuncB  pt2col,
                                          gpointer               pt2col_user_data);
 
+/**
+ * See @ref p2tr_mesh_render_from_cache_f. Each color channel is a
+ * 16 bit unsigned integer (guint16)
+ */
+void   p2tr_mesh_render_from_cache_s    (P2trUVT               *uvt_cache,
+                                         guint16               *dest,
+                                         gint                   dest_len,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncS  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_f and @ref p2tr_mesh_render_from_cache_s
+ */
+void   p2tr_mesh_render_s               (P2trMesh              *mesh,
+                                         guint16               *dest,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncS  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_from_cache_f. Each color channel is stored
+ * as the bits of an IEEE 754 half precision float. The colors are
+ * interpolated from floating point colors and converted directly into
+ * half floats, without an intermediate float buffer.
+ */
+void   p2tr_mesh_render_from_cache_h    (P2trUVT               *uvt_cache,
+                                         guint16               *dest,
+                                         gint                   dest_len,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncF  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_f and @ref p2tr_mesh_render_from_cache_h
+ */
+void   p2tr_mesh_render_h               (P2trMesh              *mesh,
+                                         guint16               *dest,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncF  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * A table of the colors of all the points of a mesh. Rendering with
+ * the lookup functions of a table (@ref p2tr_color_table_lookup_f and
+ * @ref p2tr_color_table_lookup_b) as the point-to-color function means
+ * that the real point-to-color function is called exactly once for
+ * each point, no matter how many triangles and pixels use it.
+ * Points added to the mesh after the table was built (including points
+ * that reuse the slot of a removed point) have no color in the table,
+ * and are looked up as all zeros.
+ */
+typedef struct {
+  /** The amount of color channels of each point */
+  guint       cpp;
+  /** The size in bytes of each color channel */
+  gsize       channel_size;
+  /** The colors, indexed by the slot index of the handle of each point */
+  guint8     *colors;
+  /** The handle of the point whose color is in each slot, or
+   *  @ref P2TR_HANDLE_NONE for unused slots */
+  P2trHandle *handles;
+  /** The amount of colors (including unused slots) in the table */
+  guint       n_colors;
+} P2trColorTable;
+
+/**
+ * Compute the colors of all the points of a mesh
+ * @param mesh The mesh
+ * @param cpp The amount of color channels returned by @ref pt2col
+ * @param pt2col A function that receives points in the mesh and returns
+ *        colors. With more than one thread, it's called from several
+ *        threads at once!
+ * @param pt2col_user_data Custom data to pass to @ref pt2col
+ * @param n_threads The amount of threads to compute the colors on.
+ *        With 1 (or 0), all the colors are computed in the calling thread
+ * @return The color table, which should be freed with
+ *         @ref p2tr_color_table_free
+ */
+P2trColorTable* p2tr_color_table_new_f   (P2trMesh              *mesh,
+                                          guint                  cpp,
+                                          P2trPointToColorFuncF  pt2col,
+                                          gpointer               pt2col_user_data,
+                                          guint                  n_threads);
+
+/**
+ * See @ref p2tr_color_table_new_f
+ */
+P2trColorTable* p2tr_color_table_new_b   (P2trMesh              *mesh,
+                                          guint                  cpp,
+                                          P2trPointToColorFuncB  pt2col,
+                                          gpointer               pt2col_user_data,
+                                          guint                  n_threads);
+
+/**
+ * See @ref p2tr_color_table_new_f
+ */
+P2trColorTable* p2tr_color_table_new_s   (P2trMesh              *mesh,
+                                          guint                  cpp,
+                                          P2trPointToColorFuncS  pt2col,
+                                          gpointer               pt2col_user_data,
+                                          guint                  n_threads);
+
+void            p2tr_color_table_free    (P2trColorTable        *self);
+
+/**
+ * A point-to-color function returning the colors from a table created
+ * with @ref p2tr_color_table_new_f. Pass the table as the user data.
+ * It's safe to use from several threads at once.
+ */
+void            p2tr_color_table_lookup_f (P2trPoint            *point,
+                                           gfloat               *dest,
+                                           gpointer              table);
+
+/**
+ * See @ref p2tr_color_table_lookup_f
+ */
+void            p2tr_color_table_lookup_b (P2trPoint            *point,
+                                           guint8               *dest,
+                                           gpointer              table);
+
+/**
+ * See @ref p2tr_color_table_lookup_f
+ */
+void            p2tr_color_table_lookup_s (P2trPoint            *point,
+                                           guint16              *dest,
+                                           gpointer              table);
+
+/**
+ * Flags changing the layout of rendered pixels
+ */
+typedef enum
+{
+  /**
+   * Premultiply the color channels by the alpha channel. Pixels outside
+   * of the mesh get zero in all their channels, instead of only in the
+   * alpha channel.
+   */
+  P2TR_RENDER_PREMULTIPLIED = 1 << 0
+} P2trRenderFlags;
+
+/**
+ * Render a region of interest of the image described by a render
+ * configuration, into a buffer with any layout. The region is processed
+ * in bands of rows, so the memory used doesn't depend on its height.
+ * The result for each pixel is the same as in @ref p2tr_mesh_render_f.
+ * @param mesh The mesh to render
+ * @param dest The destination of the first pixel of the region
+ * @param row_stride The distance between the rows of pixels in dest, in
+ *        color channels (gfloat units)
+ * @param pixel_stride The distance between the pixels of a row in
+ *        dest, in color channels. At least config->cpp + 1
+ * @param config The render configuration struct
+ * @param flags The layout of the rendered pixels
+ * @param x The column of the first sample of the region in the image
+ * @param y The row of the first sample of the region in the image
+ * @param width The width of the region, in samples
+ * @param height The height of the region, in samples
+ * @param pt2col A function that receives points in the mesh and returns
+ *        colors. The returned colors should have config->cpp components
+ * @param pt2col_user_data Custom data to pass to @ref pt2col
+ */
+void   p2tr_mesh_render_roi_f           (P2trMesh              *mesh,
+                                         gfloat                *dest,
+                                         gsize                  row_stride,
+                                         gsize                  pixel_stride,
+                                         P2trImageConfig       *config,
+                                         P2trRenderFlags        flags,
+                                         guint                  x,
+                                         guint                  y,
+                                         guint                  width,
+                                         guint                  height,
+                                         P2trPointToColorFuncF  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_roi_f. The strides are in bytes (guint8
+ * units)
+ */
+void   p2tr_mesh_render_roi_b           (P2trMesh              *mesh,
+                                         guint8                *dest,
+                                         gsize                  row_stride,
+                                         gsize                  pixel_stride,
+                                         P2trImageConfig       *config,
+                                         P2trRenderFlags        flags,
+                                         guint                  x,
+                                         guint                  y,
+                                         guint                  width,
+                                         guint                  height,
+                                         P2trPointToColorFuncB  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_roi_f. The strides are in guint16 units
+ */
+void   p2tr_mesh_render_roi_s           (P2trMesh              *mesh,
+                                         guint16               *dest,
+                                         gsize                  row_stride,
+                                         gsize                  pixel_stride,
+                                         P2trImageConfig       *config,
+                                         P2trRenderFlags        flags,
+                                         guint                  x,
+                                         guint                  y,
+                                         guint                  width,
+                                         guint                  height,
+                                         P2trPointToColorFuncS  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_roi_f and @ref p2tr_mesh_render_from_cache_h.
+ * The strides are in half float (guint16) units
+ */
+void   p2tr_mesh_render_roi_h           (P2trMesh              *mesh,
+                                         guint16               *dest,
+                                         gsize                  row_stride,
+                                         gsize                  pixel_stride,
+                                         P2trImageConfig       *config,
+                                         P2trRenderFlags        flags,
+                                         guint                  x,
+                                         guint                  y,
+                                         guint                  width,
+                                         guint                  height,
+                                         P2trPointToColorFuncF  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * Compute the fraction of the area of each pixel that is covered by the
+ * mesh, where each pixel is the rectangle of one step around its sample.
+ * The coverage is computed analytically from the edges on the outline
+ * of the mesh, so it's exact and it only costs a pass over the pixels
+ * and over the outline. Only the pixels crossed by the outline get a
+ * coverage between 0 and 1.
+ * @param mesh The mesh
+ * @param dest The destination buffer for the coverage of each pixel,
+ *        which should hold config->x_samples * config->y_samples values
+ * @param uvt_cache A UVT cache of the entire image made by
+ *        @ref p2tr_mesh_render_cache_uvt_exact, or NULL. Samples which
+ *        are outside of the mesh but whose pixels are partially covered
+ *        are set to the nearest point on the outline, so that they get
+ *        a color when rendered
+ * @param config The render configuration struct
+ */
+void   p2tr_mesh_render_cache_coverage  (P2trMesh              *mesh,
+                                         gfloat                *dest,
+                                         P2trUVT               *uvt_cache,
+                                         P2trImageConfig       *config);
+
+/**
+ * Render a mesh like @ref p2tr_mesh_render_f, but with anti-aliased
+ * edges - the alpha channel of each pixel is its coverage (see
+ * @ref p2tr_mesh_render_cache_coverage) instead of only 0 or 1
+ * @param flags The layout of the rendered pixels. With
+ *        @ref P2TR_RENDER_PREMULTIPLIED, the colors of partially
+ *        covered pixels are also multiplied by their coverage
+ */
+void   p2tr_mesh_render_antialiased_f   (P2trMesh              *mesh,
+                                         gfloat                *dest,
+                                         P2trImageConfig       *config,
+                                         P2trRenderFlags        flags,
+                                         P2trPointToColorFuncF  pt2col,
+                                         gpointer               pt2col_user_data);
+
+/**
+ * The size of the tiles used by @ref p2tr_mesh_render_tiled_f when no
+ * size is given
+ */
+#define P2TR_MESH_RENDER_TILE_SIZE 128
+
+/**
+ * Render a mesh like @ref p2tr_mesh_render_f, but split the image into
+ * square tiles and render them on a pool of threads. Each tile has its
+ * own UVT cache, which only exists while the tile is rendered. The
+ * result is identical to the one of @ref p2tr_mesh_render_f.
+ * @param mesh The mesh to render
+ * @param dest The destination buffer for the image
+ * @param config The render configuration struct
+ * @param pt2col A function that receives points in the mesh and returns
+ *        colors. With more than one thread, it's called from several
+ *        threads at once!
+ * @param pt2col_user_data Custom data to pass to @ref pt2col
+ * @param tile_size The width and height of the tiles in samples, or 0
+ *        for @ref P2TR_MESH_RENDER_TILE_SIZE
+ * @param n_threads The maximal amount of threads to render on. With 1
+ *        (or 0), all the tiles are rendered in the calling thread
+ */
+void   p2tr_mesh_render_tiled_f         (P2trMesh              *mesh,
+                                         gfloat                *dest,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncF  pt2col,
+                                         gpointer               pt2col_user_data,
+                                         guint                  tile_size,
+                                         guint                  n_threads);
+
+/**
+ * See @ref p2tr_mesh_render_tiled_f
+ */
+void   p2tr_mesh_render_tiled_b         (P2trMesh              *mesh,
+                                         guint8                *dest,
+                                         P2trImageConfig       *config,
+                                         P2trPointToColorFuncB  pt2col,
+                                         gpointer               pt2col_user_data,
+                                         guint                  tile_size,
+                                         guint                  n_threads);
+
+/**
+ * A compact version of @ref P2trUVT, taking 8 bytes per sample instead
+ * of 24. The barycentric coordinates are stored as 16 bit fixed point
+ * numbers, so colors rendered from a compact cache may differ slightly
+ * from colors rendered from a regular cache.
+ */
+typedef struct {
+  /** The barycentric coordinates, multiplied by
+   *  @ref P2TR_UVT_COMPACT_SCALE */
+  guint16    u;
+  guint16    v;
+  /** The handle of the triangle in the triangle set of the mesh, or
+   *  @ref P2TR_HANDLE_NONE outside of the mesh */
+  P2trHandle tri;
+} P2trUVTCompact;
+
+/** The fixed point scale of the coordinates in @ref P2trUVTCompact */
+#define P2TR_UVT_COMPACT_SCALE 65535
+
+/**
+ * Similar to @ref p2tr_mesh_render_cache_uvt_exact, but compute a
+ * compact UVT cache. The cache refers to the triangles by their handles,
+ * so triangles which are removed from the mesh later are treated as if
+ * they were outside of it.
+ */
+void   p2tr_mesh_render_cache_uvt_compact    (P2trMesh              *mesh,
+                                              P2trUVTCompact        *dest,
+                                              gint                   dest_len,
+                                              P2trImageConfig       *config);
+
+/**
+ * Similar to @ref p2tr_mesh_render_from_cache_f, but render from a
+ * compact UVT cache of the given mesh
+ */
+void   p2tr_mesh_render_from_compact_cache_f (P2trMesh              *mesh,
+                                              P2trUVTCompact        *uvt_cache,
+                                              gfloat                *dest,
+                                              gint                   dest_len,
+                                              P2trImageConfig       *config,
+                                              P2trPointToColorFuncF  pt2col,
+                                              gpointer               pt2col_user_data);
+
+/**
+ * See @ref p2tr_mesh_render_from_compact_cache_f
+ */
+void   p2tr_mesh_render_from_compact_cache_b (P2trMesh              *mesh,
+                                              P2trUVTCompact        *uvt_cache,
+                                              guint8                *dest,
+                                              gint                   dest_len,
+                                              P2trImageConfig       *config,
+                                              P2trPointToColorFuncB  pt2col,
+                                              gpointer               pt2col_user_data);
+
 #endif
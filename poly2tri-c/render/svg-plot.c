@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <glib.h>
 
@@ -94,7 +95,7 @@ p2tr_render_svg_style (FILE           *out,
           fprintf (out, "stroke: #%02x%02x%02x; stroke-opacity: %f; ",
               context->stroke_color[0], context->stroke_color[1],
               context->stroke_color[2], context->stroke_color[3] / 255.0);
-          fprintf (out, "stroke-:width: %f; stroke-linejoin: round; ",
+          fprintf (out, "stroke-width: %f; stroke-linejoin: round; ",
               context->stroke_width);
         }
 
@@ -150,7 +151,7 @@ void
 p2tr_render_svg (P2trMesh *mesh,
                  FILE     *out)
 {
-  P2trHashSetIter  siter;
+  P2trDenseSetIter  siter;
   P2trTriangle    *tr;
   P2trPoint       *pt;
 
@@ -189,16 +190,287 @@ p2tr_render_svg (P2trMesh *mesh,
   top_right.y += 10;
   p2tr_render_svg_init (out, &bottom_left, &top_right);
 
-  p2tr_hash_set_iter_init (&siter, mesh->triangles);
-  while (p2tr_hash_set_iter_next (&siter, (gpointer*)&tr))
+  p2tr_dense_set_iter_init (&siter, mesh->triangles);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&tr))
     p2tr_render_svg_draw_triangle (out, &TRI,
         &P2TR_TRIANGLE_GET_POINT(tr, 0)->c,
         &P2TR_TRIANGLE_GET_POINT(tr, 1)->c,
         &P2TR_TRIANGLE_GET_POINT(tr, 2)->c);
 
-  p2tr_hash_set_iter_init (&siter, mesh->points);
-  while (p2tr_hash_set_iter_next (&siter, (gpointer*)&pt))
+  p2tr_dense_set_iter_init (&siter, mesh->points);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&pt))
     p2tr_render_svg_draw_circle (out, &PT, &pt->c, 1);
 
   p2tr_render_svg_finish (out);
 }
+
+/**
+ * The size of the output buffer of @ref p2tr_render_svg_compact
+ */
+#define P2TR_SVG_BUFFER_SIZE 65536
+
+/**
+ * The maximal length of the text of one triangle (or point) written by
+ * @ref p2tr_render_svg_compact - 6 numbers of at most 24 characters
+ * each, and a few commands
+ */
+#define P2TR_SVG_MAX_ITEM_LENGTH 160
+
+/**
+ * The amount of triangles (or points) in each path element. Very long
+ * path data is slow to edit in some SVG editors
+ */
+#define P2TR_SVG_PATH_ITEMS 16384
+
+/**
+ * The maximal amount of decimal digits of coordinates, so that they
+ * can be stored as integers
+ */
+#define P2TR_SVG_MAX_DECIMALS 9
+
+/**
+ * Writes the data of paths into a large buffer. Coordinates are rounded
+ * to a fixed amount of decimal digits and stored as integers, so that
+ * relative coordinates are exact differences and rounding errors don't
+ * accumulate along a path
+ */
+typedef struct
+{
+  FILE    *out;
+  gchar    buffer[P2TR_SVG_BUFFER_SIZE];
+  gsize    len;
+  guint    decimals;
+  /** 10^decimals */
+  gint64   unit;
+  /** The current point of the path, in units of 10^-decimals */
+  gint64   x, y;
+} P2trSVGWriter;
+
+static void
+p2tr_svg_writer_flush (P2trSVGWriter *self)
+{
+  fwrite (self->buffer, 1, self->len, self->out);
+  self->len = 0;
+}
+
+/**
+ * Make sure the next item fits in the buffer
+ */
+static void
+p2tr_svg_writer_reserve (P2trSVGWriter *self)
+{
+  if (self->len + P2TR_SVG_MAX_ITEM_LENGTH > P2TR_SVG_BUFFER_SIZE)
+    p2tr_svg_writer_flush (self);
+}
+
+static void
+p2tr_svg_writer_text (P2trSVGWriter *self,
+                      const gchar   *text)
+{
+  gsize len = strlen (text);
+
+  if (self->len + len > P2TR_SVG_BUFFER_SIZE)
+    p2tr_svg_writer_flush (self);
+  memcpy (self->buffer + self->len, text, len);
+  self->len += len;
+}
+
+/**
+ * Write a number given in units of 10^-decimals, without trailing
+ * zeros after the decimal point. The number is separated from a
+ * previous number by a space, unless its minus sign separates it
+ */
+static void
+p2tr_svg_writer_number (P2trSVGWriter *self,
+                        gint64         value)
+{
+  gchar   digits[24];
+  gint64  abs_value = (value < 0) ? -value : value;
+  gint64  int_part = abs_value / self->unit;
+  gint64  frac_part = abs_value % self->unit;
+  guint   n = 0, n_frac = self->decimals, i;
+  gchar   prev = (self->len > 0) ? self->buffer[self->len - 1] : ' ';
+
+  while (n_frac > 0 && frac_part % 10 == 0)
+    {
+      frac_part /= 10;
+      n_frac--;
+    }
+
+  if (value < 0)
+    self->buffer[self->len++] = '-';
+  else if (prev >= '0' && prev <= '9')
+    self->buffer[self->len++] = ' ';
+
+  /* The digits are found from the last one to the first one */
+  for (i = 0; i < n_frac; i++, frac_part /= 10)
+    digits[n++] = (gchar) ('0' + frac_part % 10);
+  if (n_frac > 0)
+    digits[n++] = '.';
+  do
+    {
+      digits[n++] = (gchar) ('0' + int_part % 10);
+      int_part /= 10;
+    }
+  while (int_part > 0);
+
+  while (n > 0)
+    self->buffer[self->len++] = digits[--n];
+}
+
+/**
+ * Write a path command (or nothing, to repeat the last command) with a
+ * point relative to the current point, which becomes the current point
+ */
+static void
+p2tr_svg_writer_point (P2trSVGWriter     *self,
+                       gchar              command,
+                       const P2trVector2 *p)
+{
+  gint64 x = (gint64) floor (p->x * self->unit + 0.5);
+  gint64 y = (gint64) floor (p->y * self->unit + 0.5);
+
+  if (command != '\0')
+    self->buffer[self->len++] = command;
+  p2tr_svg_writer_number (self, x - self->x);
+  p2tr_svg_writer_number (self, y - self->y);
+  self->x = x;
+  self->y = y;
+}
+
+/**
+ * Start a path element. The first point of the path is relative to the
+ * origin
+ */
+static void
+p2tr_svg_writer_begin_path (P2trSVGWriter *self)
+{
+  p2tr_svg_writer_text (self, "<path d=\"");
+  self->x = self->y = 0;
+}
+
+static void
+p2tr_svg_writer_end_path (P2trSVGWriter *self)
+{
+  p2tr_svg_writer_text (self, "\" />" P2TR_SVG_NEWLINE);
+}
+
+void
+p2tr_render_svg_compact (P2trMesh *mesh,
+                         FILE     *out,
+                         guint     decimals)
+{
+  P2trDenseSetIter  siter;
+  P2trTriangle     *tr;
+  P2trPoint        *pt;
+  P2trSVGWriter    *writer;
+  gint64            first_x, first_y;
+  guint             count, i;
+
+  /* Same colors as in p2tr_render_svg */
+  P2trSVGContext  TRI = {
+      TRUE,
+      1,
+      /* Sky Blue 3 */
+      { 32, 74, 135, 255 },
+      TRUE,
+      /* Sky Blue 1 */
+      { 114, 159, 207, 255 },
+      1
+  };
+
+  /* The points are drawn as lines of length zero with round caps, so
+   * that all of them can be in one path */
+  P2trSVGContext PT = {
+      TRUE,
+      2,
+      /* Orange 1 */
+      { 245, 121, 0, 255 },
+      FALSE,
+      { 0, 0, 0, 0 },
+      1
+  };
+
+  P2trVector2 bottom_left, top_right;
+
+  p2tr_mesh_get_bounds (mesh,
+      &bottom_left.x, &bottom_left.y,
+      &top_right.x,   &top_right.y);
+
+  bottom_left.x -= 10;
+  bottom_left.y -= 10;
+  top_right.x += 10;
+  top_right.y += 10;
+  p2tr_render_svg_init (out, &bottom_left, &top_right);
+
+  writer = g_slice_new (P2trSVGWriter);
+  writer->out = out;
+  writer->len = 0;
+  writer->decimals = MIN (decimals, P2TR_SVG_MAX_DECIMALS);
+  writer->unit = 1;
+  for (i = 0; i < writer->decimals; i++)
+    writer->unit *= 10;
+
+  /* The style of all the paths is set once, on their group */
+  fprintf (out, "<g ");
+  p2tr_render_svg_style (out, &TRI, FALSE);
+  fprintf (out, ">%s", P2TR_SVG_NEWLINE);
+
+  count = 0;
+  p2tr_dense_set_iter_init (&siter, mesh->triangles);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&tr))
+    {
+      if (count++ % P2TR_SVG_PATH_ITEMS == 0)
+        {
+          if (count > 1)
+            p2tr_svg_writer_end_path (writer);
+          p2tr_svg_writer_begin_path (writer);
+        }
+
+      p2tr_svg_writer_reserve (writer);
+      p2tr_svg_writer_point (writer, 'm', &P2TR_TRIANGLE_GET_POINT(tr, 0)->c);
+      first_x = writer->x;
+      first_y = writer->y;
+      p2tr_svg_writer_point (writer, 'l', &P2TR_TRIANGLE_GET_POINT(tr, 1)->c);
+      p2tr_svg_writer_point (writer, '\0', &P2TR_TRIANGLE_GET_POINT(tr, 2)->c);
+
+      /* Closing the triangle moves back to its first point, so the
+       * first point of the next triangle is relative to it */
+      writer->buffer[writer->len++] = 'z';
+      writer->x = first_x;
+      writer->y = first_y;
+    }
+  if (count > 0)
+    p2tr_svg_writer_end_path (writer);
+  p2tr_svg_writer_text (writer, "</g>" P2TR_SVG_NEWLINE);
+  p2tr_svg_writer_flush (writer);
+
+  fprintf (out, "<g stroke-linecap=\"round\" ");
+  p2tr_render_svg_style (out, &PT, FALSE);
+  fprintf (out, ">%s", P2TR_SVG_NEWLINE);
+
+  count = 0;
+  p2tr_dense_set_iter_init (&siter, mesh->points);
+  while (p2tr_dense_set_iter_next (&siter, (gpointer*)&pt))
+    {
+      if (count++ % P2TR_SVG_PATH_ITEMS == 0)
+        {
+          if (count > 1)
+            p2tr_svg_writer_end_path (writer);
+          p2tr_svg_writer_begin_path (writer);
+        }
+
+      p2tr_svg_writer_reserve (writer);
+      p2tr_svg_writer_point (writer, 'm', &pt->c);
+      writer->buffer[writer->len++] = 'h';
+      writer->buffer[writer->len++] = '0';
+    }
+  if (count > 0)
+    p2tr_svg_writer_end_path (writer);
+  p2tr_svg_writer_text (writer, "</g>" P2TR_SVG_NEWLINE);
+  p2tr_svg_writer_flush (writer);
+
+  g_slice_free (P2trSVGWriter, writer);
+
+  p2tr_render_svg_finish (out);
+}
@@ -72,4 +72,25 @@ void p2tr_render_svg_finish        (FILE              *out);
 void p2tr_render_svg               (P2trMesh          *mesh,
                                     FILE              *out);
 
+/**
+ * The default amount of decimal digits in the coordinates written by
+ * @ref p2tr_render_svg_compact
+ */
+#define P2TR_SVG_DEFAULT_DECIMALS 3
+
+/**
+ * Render a mesh like @ref p2tr_render_svg, but into a much smaller
+ * file. All the triangles (and all the points) are written as a few
+ * path elements with one shared style, using relative coordinates with
+ * a fixed amount of decimal digits. The output is written through a
+ * large buffer instead of many small writes.
+ * @param mesh The mesh to render
+ * @param out The output file
+ * @param decimals The amount of decimal digits of the coordinates (at
+ *        most 9). Trailing zeros are omitted
+ */
+void p2tr_render_svg_compact       (P2trMesh          *mesh,
+                                    FILE              *out,
+                                    guint              decimals);
+
 #endif
@@ -0,0 +1,103 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Meshes allocate their objects from pools which they own, so a mesh
+ * may be built on one thread and freed on another, and its objects may
+ * outlive it */
+
+#include <stdlib.h>
+#include <math.h>
+#include <glib.h>
+
+#include <poly2tri-c/p2t/poly2tri.h>
+#include <poly2tri-c/refine/refine.h>
+
+static gboolean
+too_big (P2trTriangle *tri)
+{
+  return p2tr_triangle_get_quality (tri)->area > 4;
+}
+
+static gpointer
+build_cdt (gpointer data)
+{
+  GPtrArray   *points = g_ptr_array_new ();
+  P2tCDT      *cdt;
+  P2trCDT     *rcdt;
+  P2trRefiner *refiner;
+  gint         i;
+
+  for (i = 0; i < 16; i++)
+    {
+      gdouble r = (i % 2) ? 20 : 50, a = 2 * G_PI * i / 16;
+      g_ptr_array_add (points, p2t_point_new_dd (r * cos (a), r * sin (a)));
+    }
+
+  cdt = p2t_cdt_new (points);
+  p2t_cdt_triangulate (cdt);
+  rcdt = p2tr_cdt_new (cdt);
+  p2t_cdt_free (cdt);
+
+  for (i = 0; i < 16; i++)
+    p2t_point_free ((P2tPoint*) g_ptr_array_index (points, i));
+  g_ptr_array_free (points, TRUE);
+
+  refiner = p2tr_refiner_new (G_PI / 6, too_big, rcdt);
+  p2tr_refiner_refine (refiner, 5000, NULL);
+  p2tr_refiner_free (refiner);
+
+  return rcdt;
+}
+
+int
+main (int argc, char *argv[])
+{
+  P2trCDT   *rcdt;
+  P2trPoint *point;
+  P2trDenseSetIter iter;
+
+  /* Build on a worker thread, free on the main thread */
+  rcdt = (P2trCDT*) g_thread_join (g_thread_new ("build", build_cdt, NULL));
+  g_assert (p2tr_dense_set_size (rcdt->mesh->triangles) > 100);
+  p2tr_cdt_free (rcdt);
+
+  /* Keep a point of the mesh alive after the mesh is freed, and then
+   * release it on another thread */
+  rcdt = build_cdt (NULL);
+  p2tr_dense_set_iter_init (&iter, rcdt->mesh->points);
+  g_assert (p2tr_dense_set_iter_next (&iter, (gpointer*) &point));
+  p2tr_point_ref (point);
+  p2tr_cdt_free (rcdt);
+  g_thread_join (g_thread_new ("unref", (GThreadFunc) p2tr_point_unref, point));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Refining a box must check all the triangles which intersect it, even
+ * when they are not connected to each other inside the box - here the
+ * box crosses a hole, and only the part on the right of the hole
+ * contains the center of the box */
+
+#include <stdlib.h>
+#include <glib.h>
+
+#include <poly2tri-c/p2t/poly2tri.h>
+#include <poly2tri-c/refine/refine.h>
+
+#define BOX_MIN_X 25
+#define BOX_MIN_Y 45
+#define BOX_MAX_X 85
+#define BOX_MAX_Y 55
+
+static gdouble box_max_area = 200;
+
+static gboolean
+in_box (P2trTriangle *tri)
+{
+  gdouble min_x = G_MAXDOUBLE, min_y = G_MAXDOUBLE;
+  gdouble max_x = -G_MAXDOUBLE, max_y = -G_MAXDOUBLE;
+  gint    i;
+
+  for (i = 0; i < 3; i++)
+    {
+      const P2trVector2 *c = &P2TR_TRIANGLE_GET_POINT (tri, i)->c;
+      min_x = MIN (min_x, c->x);
+      min_y = MIN (min_y, c->y);
+      max_x = MAX (max_x, c->x);
+      max_y = MAX (max_y, c->y);
+    }
+
+  return max_x >= BOX_MIN_X && min_x <= BOX_MAX_X
+      && max_y >= BOX_MIN_Y && min_y <= BOX_MAX_Y;
+}
+
+/* Only the triangles inside the box are required to become smaller, so
+ * the refinement of the box does not spread to the rest of the mesh */
+static gboolean
+too_big (P2trTriangle *tri)
+{
+  return p2tr_triangle_get_quality (tri)->area
+      > (in_box (tri) ? box_max_area : 200);
+}
+
+static GPtrArray*
+rectangle (gdouble min_x,
+           gdouble min_y,
+           gdouble max_x,
+           gdouble max_y)
+{
+  GPtrArray *points = g_ptr_array_new ();
+
+  g_ptr_array_add (points, p2t_point_new_dd (min_x, min_y));
+  g_ptr_array_add (points, p2t_point_new_dd (max_x, min_y));
+  g_ptr_array_add (points, p2t_point_new_dd (max_x, max_y));
+  g_ptr_array_add (points, p2t_point_new_dd (min_x, max_y));
+
+  return points;
+}
+
+static void
+free_points (GPtrArray *points)
+{
+  guint i;
+
+  for (i = 0; i < points->len; i++)
+    p2t_point_free ((P2tPoint*) g_ptr_array_index (points, i));
+  g_ptr_array_free (points, TRUE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GPtrArray        *outline = rectangle (0, 0, 100, 100);
+  GPtrArray        *hole = rectangle (30, 20, 50, 80);
+  P2tCDT           *cdt;
+  P2trCDT          *rcdt;
+  P2trRefiner      *refiner;
+  P2trRefineStopReason reason;
+  P2trDenseSetIter  iter;
+  P2trTriangle     *tri;
+
+  cdt = p2t_cdt_new (outline);
+  p2t_cdt_add_hole (cdt, hole);
+  p2t_cdt_triangulate (cdt);
+  rcdt = p2tr_cdt_new (cdt);
+  p2t_cdt_free (cdt);
+  free_points (outline);
+  free_points (hole);
+
+  /* Refine everything coarsely, and then only the box finely */
+  refiner = p2tr_refiner_new (G_PI / 6, too_big, rcdt);
+  p2tr_refiner_refine (refiner, 100000, NULL);
+
+  box_max_area = 2;
+  reason = p2tr_refiner_refine_box (refiner, BOX_MIN_X, BOX_MIN_Y,
+      BOX_MAX_X, BOX_MAX_Y, NULL, NULL, NULL);
+  g_assert (reason == P2TR_REFINE_DONE);
+
+  /* The triangles in the box on both sides of the hole were refined */
+  p2tr_dense_set_iter_init (&iter, rcdt->mesh->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*) &tri))
+    if (in_box (tri))
+      g_assert (! too_big (tri));
+
+  p2tr_refiner_free (refiner);
+  p2tr_cdt_free (rcdt);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,231 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* A refinement which was stopped may be saved as a checkpoint - the
+ * mesh and the queues of the refiner - and resumed from it later, by a
+ * refiner of the loaded mesh */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+
+#include <poly2tri-c/p2t/poly2tri.h>
+#include <poly2tri-c/refine/refine.h>
+
+static gboolean
+too_big (P2trTriangle *tri)
+{
+  return p2tr_triangle_get_quality (tri)->area > 4;
+}
+
+static P2trCDT*
+build_cdt (void)
+{
+  GPtrArray *points = g_ptr_array_new ();
+  P2tCDT    *cdt;
+  P2trCDT   *rcdt;
+  gint       i;
+
+  for (i = 0; i < 16; i++)
+    {
+      gdouble r = (i % 2) ? 20 : 50, a = 2 * G_PI * i / 16;
+      g_ptr_array_add (points, p2t_point_new_dd (r * cos (a), r * sin (a)));
+    }
+
+  cdt = p2t_cdt_new (points);
+  p2t_cdt_triangulate (cdt);
+  rcdt = p2tr_cdt_new (cdt);
+  p2t_cdt_free (cdt);
+
+  for (i = 0; i < 16; i++)
+    p2t_point_free ((P2tPoint*) g_ptr_array_index (points, i));
+  g_ptr_array_free (points, TRUE);
+
+  return rcdt;
+}
+
+static guint
+count_constrained (P2trMesh *mesh)
+{
+  P2trDenseSetIter iter;
+  P2trEdge *e;
+  guint     count = 0;
+
+  p2tr_dense_set_iter_init (&iter, mesh->edges);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*) &e))
+    if (e->constrained)
+      ++count;
+
+  return count;
+}
+
+static gint
+compare_lines (const gchar **l1,
+               const gchar **l2)
+{
+  return strcmp (*l1, *l2);
+}
+
+/**
+ * Save the queues of a refiner, as a sorted list of lines. The order
+ * of triangles with the same quality, and the point from which each
+ * triangle starts, may change when the queues are loaded - so each
+ * triangle is rotated to start from its lowest point
+ */
+static GPtrArray*
+save_queues (P2trRefiner *refiner)
+{
+  FILE      *f = tmpfile ();
+  GPtrArray *lines = g_ptr_array_new_with_free_func (g_free);
+  gchar      line[256];
+
+  g_assert (f != NULL);
+  p2tr_refiner_save_queues (refiner, f);
+  rewind (f);
+
+  while (fgets (line, sizeof (line), f) != NULL)
+    {
+      guint p[3];
+
+      if (sscanf (line, "%u %u %u\n", &p[0], &p[1], &p[2]) == 3
+          && strncmp (line, "P2TRQ", 5) != 0)
+        {
+          guint first = (p[0] < p[1])
+              ? (p[0] < p[2] ? 0 : 2)
+              : (p[1] < p[2] ? 1 : 2);
+          g_ptr_array_add (lines, g_strdup_printf ("%u %u %u",
+              p[first], p[(first + 1) % 3], p[(first + 2) % 3]));
+        }
+      else
+        g_ptr_array_add (lines, g_strdup (line));
+    }
+  fclose (f);
+
+  g_ptr_array_sort (lines, (GCompareFunc) compare_lines);
+  return lines;
+}
+
+static void
+assert_same_queues (GPtrArray *q1,
+                    GPtrArray *q2)
+{
+  guint i;
+
+  g_assert (q1->len == q2->len);
+  for (i = 0; i < q1->len; i++)
+    g_assert (strcmp (g_ptr_array_index (q1, i),
+          g_ptr_array_index (q2, i)) == 0);
+}
+
+int
+main (int argc, char *argv[])
+{
+  P2trCDT          *rcdt, *loaded;
+  P2trMesh         *mesh;
+  P2trRefiner      *refiner, *resumed;
+  P2trRefineBudget  budget;
+  P2trDenseSetIter  iter;
+  P2trTriangle     *tri;
+  GPtrArray        *queues, *loaded_queues;
+  FILE             *checkpoint;
+  P2trRefineStopReason reason;
+  gboolean          loaded_ok;
+  guint             i;
+
+  /* Stop a refinement in the middle and save a checkpoint */
+  rcdt = build_cdt ();
+  refiner = p2tr_refiner_new (G_PI / 6, too_big, rcdt);
+  p2tr_refiner_budget_init (&budget);
+  budget.max_steps = 50;
+  reason = p2tr_refiner_refine_budget (refiner, &budget, NULL);
+  g_assert (reason == P2TR_REFINE_STOP_STEPS);
+
+  checkpoint = tmpfile ();
+  g_assert (checkpoint != NULL);
+  p2tr_mesh_save_checkpoint (rcdt->mesh, checkpoint);
+  p2tr_refiner_save_queues (refiner, checkpoint);
+  queues = save_queues (refiner);
+
+  /* Load it back - the points must keep their order and coordinates,
+   * and the constrained edges must stay constrained */
+  rewind (checkpoint);
+  mesh = p2tr_mesh_load_checkpoint (checkpoint);
+  g_assert (mesh != NULL);
+
+  g_assert (p2tr_dense_set_size (mesh->points)
+      == p2tr_dense_set_size (rcdt->mesh->points));
+  g_assert (p2tr_dense_set_size (mesh->edges)
+      == p2tr_dense_set_size (rcdt->mesh->edges));
+  g_assert (p2tr_dense_set_size (mesh->triangles)
+      == p2tr_dense_set_size (rcdt->mesh->triangles));
+  g_assert (count_constrained (mesh) == count_constrained (rcdt->mesh));
+
+  for (i = 0; i < p2tr_dense_set_size (mesh->points); i++)
+    {
+      P2trPoint *a = (P2trPoint*) p2tr_dense_set_get (mesh->points, i);
+      P2trPoint *b = (P2trPoint*) p2tr_dense_set_get (rcdt->mesh->points, i);
+      g_assert (a->c.x == b->c.x && a->c.y == b->c.y);
+    }
+
+  loaded = p2tr_cdt_new_from_mesh (mesh);
+  p2tr_mesh_unref (mesh);
+
+  /* The queues must be restored with the same triangles and segments */
+  resumed = p2tr_refiner_new (G_PI / 6, too_big, loaded);
+  loaded_ok = p2tr_refiner_load_queues (resumed, checkpoint);
+  g_assert (loaded_ok);
+  fclose (checkpoint);
+
+  loaded_queues = save_queues (resumed);
+  assert_same_queues (queues, loaded_queues);
+  g_ptr_array_free (queues, TRUE);
+  g_ptr_array_free (loaded_queues, TRUE);
+
+  /* And the refinement must continue from them to the end */
+  p2tr_refiner_budget_init (&budget);
+  reason = p2tr_refiner_refine_budget (resumed, &budget, NULL);
+  g_assert (reason == P2TR_REFINE_DONE);
+  p2tr_cdt_validate_cdt (loaded);
+
+  p2tr_dense_set_iter_init (&iter, loaded->mesh->triangles);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*) &tri))
+    g_assert (! too_big (tri));
+
+  p2tr_refiner_free (resumed);
+  p2tr_cdt_free (loaded);
+  p2tr_refiner_free (refiner);
+  p2tr_cdt_free (rcdt);
+
+  return EXIT_SUCCESS;
+}
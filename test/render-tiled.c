@@ -0,0 +1,179 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Rendering an image in tiles, on any amount of threads, gives exactly
+ * the same result as rendering it at once - including the partial
+ * tiles on the right and bottom, and the samples outside the mesh */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+
+#include <poly2tri-c/p2t/poly2tri.h>
+#include <poly2tri-c/refine/refine.h>
+#include <poly2tri-c/render/mesh-render.h>
+
+#define CPP 3
+
+static gboolean
+too_big (P2trTriangle *tri)
+{
+  return p2tr_triangle_get_quality (tri)->area > 20;
+}
+
+static void
+color_f (P2trPoint *point,
+         gfloat    *dest,
+         gpointer   user_data)
+{
+  dest[0] = (gfloat) (point->c.x / 100);
+  dest[1] = (gfloat) (point->c.y / 100);
+  dest[2] = (gfloat) (0.5 + 0.5 * sin (point->c.x / 7) * cos (point->c.y / 5));
+}
+
+static void
+color_b (P2trPoint *point,
+         guint8    *dest,
+         gpointer   user_data)
+{
+  gfloat color[CPP];
+  guint  i;
+
+  color_f (point, color, user_data);
+  for (i = 0; i < CPP; i++)
+    dest[i] = (guint8) (color[i] * 255);
+}
+
+static GPtrArray*
+polygon (gdouble cx,
+         gdouble cy,
+         gdouble r,
+         guint   n)
+{
+  GPtrArray *points = g_ptr_array_new ();
+  guint      i;
+
+  for (i = 0; i < n; i++)
+    g_ptr_array_add (points, p2t_point_new_dd (
+        cx + r * cos (i * 2 * G_PI / n), cy + r * sin (i * 2 * G_PI / n)));
+
+  return points;
+}
+
+static void
+free_points (GPtrArray *points)
+{
+  guint i;
+
+  for (i = 0; i < points->len; i++)
+    p2t_point_free ((P2tPoint*) g_ptr_array_index (points, i));
+  g_ptr_array_free (points, TRUE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const guint tile_sizes[] = { 1, 7, 64, 0, 1000 };
+  static const guint thread_counts[] = { 1, 2, 5 };
+
+  GPtrArray       *outline = polygon (50, 50, 50, 24);
+  GPtrArray       *hole = polygon (40, 55, 15, 7);
+  P2tCDT          *cdt;
+  P2trCDT         *rcdt;
+  P2trRefiner     *refiner;
+  P2trImageConfig  config;
+  gsize            n;
+  gfloat          *expected_f, *tiled_f;
+  guint8          *expected_b, *tiled_b;
+  guint            i, j;
+
+  cdt = p2t_cdt_new (outline);
+  p2t_cdt_add_hole (cdt, hole);
+  p2t_cdt_triangulate (cdt);
+  rcdt = p2tr_cdt_new (cdt);
+  p2t_cdt_free (cdt);
+  free_points (outline);
+  free_points (hole);
+
+  refiner = p2tr_refiner_new (G_PI / 6, too_big, rcdt);
+  p2tr_refiner_refine (refiner, 100000, NULL);
+  p2tr_refiner_free (refiner);
+
+  /* The image is larger than the mesh, and its size isn't a multiple of
+   * any of the tile sizes */
+  config.min_x = -3.3;
+  config.min_y = -5.1;
+  config.step_x = 0.37;
+  config.step_y = 0.41;
+  config.x_samples = 301;
+  config.y_samples = 263;
+  config.cpp = CPP;
+  config.alpha_last = TRUE;
+
+  n = config.x_samples * config.y_samples * (CPP + 1);
+  expected_f = g_new (gfloat, n);
+  tiled_f = g_new (gfloat, n);
+  expected_b = g_new (guint8, n);
+  tiled_b = g_new (guint8, n);
+
+  /* Outside of the mesh only the alpha is written, so all the images
+   * start with the same contents */
+  memset (expected_f, 0xff, n * sizeof (gfloat));
+  memset (expected_b, 0xff, n * sizeof (guint8));
+
+  p2tr_mesh_render_f (rcdt->mesh, expected_f, &config, color_f, NULL);
+  p2tr_mesh_render_b (rcdt->mesh, expected_b, &config, color_b, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (tile_sizes); i++)
+    for (j = 0; j < G_N_ELEMENTS (thread_counts); j++)
+      {
+        memset (tiled_f, 0xff, n * sizeof (gfloat));
+        memset (tiled_b, 0xff, n * sizeof (guint8));
+
+        p2tr_mesh_render_tiled_f (rcdt->mesh, tiled_f, &config, color_f,
+            NULL, tile_sizes[i], thread_counts[j]);
+        p2tr_mesh_render_tiled_b (rcdt->mesh, tiled_b, &config, color_b,
+            NULL, tile_sizes[i], thread_counts[j]);
+
+        g_assert (memcmp (expected_f, tiled_f, n * sizeof (gfloat)) == 0);
+        g_assert (memcmp (expected_b, tiled_b, n * sizeof (guint8)) == 0);
+      }
+
+  g_free (expected_f);
+  g_free (tiled_f);
+  g_free (expected_b);
+  g_free (tiled_b);
+  p2tr_cdt_free (rcdt);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+/*
+ * This file is a part of Poly2Tri-C
+ * (c) Barak Itkin <lightningismyname@gmail.com>
+ * http://code.google.com/p/poly2tri-c/
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of Poly2Tri nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* The maximal error of a simplification bounds the difference between
+ * the value at every removed point and the value interpolated from the
+ * simplified mesh, and not only at each point when it's removed */
+
+#include <stdlib.h>
+#include <math.h>
+#include <glib.h>
+
+#include <poly2tri-c/p2t/poly2tri.h>
+#include <poly2tri-c/refine/refine.h>
+
+#define MAX_ERROR 0.2
+
+static gdouble
+height (const P2trVector2 *c)
+{
+  return 10 * sin (c->x / 7) * cos (c->y / 5);
+}
+
+static gdouble
+point_height (P2trPoint *point,
+              gpointer   user_data)
+{
+  return height (&point->c);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GPtrArray            *points = g_ptr_array_new ();
+  GArray               *original = g_array_new (FALSE, FALSE, sizeof (P2trVector2));
+  P2tCDT               *cdt;
+  P2trCDT              *rcdt;
+  P2trRefiner          *refiner;
+  P2trSizingField      *sizing;
+  P2trSimplifier       *simplifier;
+  P2trSimplifierParams  params;
+  P2trDenseSetIter      iter;
+  P2trPoint            *pt;
+  guint                 i, removed;
+
+  g_ptr_array_add (points, p2t_point_new_dd (0, 0));
+  g_ptr_array_add (points, p2t_point_new_dd (60, 0));
+  g_ptr_array_add (points, p2t_point_new_dd (60, 60));
+  g_ptr_array_add (points, p2t_point_new_dd (0, 60));
+
+  cdt = p2t_cdt_new (points);
+  p2t_cdt_triangulate (cdt);
+  rcdt = p2tr_cdt_new (cdt);
+  p2t_cdt_free (cdt);
+
+  for (i = 0; i < points->len; i++)
+    p2t_point_free ((P2tPoint*) g_ptr_array_index (points, i));
+  g_ptr_array_free (points, TRUE);
+
+  /* Unlike a P2trTriangleTooBig callback, a sizing field also splits
+   * the big triangles of the input */
+  refiner = p2tr_refiner_new (G_PI / 6, p2tr_refiner_false_too_big, rcdt);
+  sizing = p2tr_sizing_field_new_constant (1);
+  p2tr_refiner_set_sizing_field (refiner, sizing);
+  p2tr_sizing_field_unref (sizing);
+  p2tr_refiner_refine (refiner, 100000, NULL);
+  p2tr_refiner_free (refiner);
+
+  p2tr_dense_set_iter_init (&iter, rcdt->mesh->points);
+  while (p2tr_dense_set_iter_next (&iter, (gpointer*) &pt))
+    g_array_append_val (original, pt->c);
+
+  p2tr_simplifier_params_init (&params);
+  params.value_func = point_height;
+  params.max_error = MAX_ERROR;
+
+  simplifier = p2tr_simplifier_new (rcdt, &params);
+  removed = p2tr_simplifier_simplify (simplifier, 0);
+  p2tr_simplifier_free (simplifier);
+  g_assert (removed > original->len / 4);
+
+  for (i = 0; i < original->len; i++)
+    {
+      P2trVector2  *c = &g_array_index (original, P2trVector2, i);
+      P2trTriangle *tri;
+      gdouble       u, v, a, b, d;
+
+      tri = p2tr_mesh_find_point_local2 (rcdt->mesh, c, NULL, &u, &v);
+      g_assert (tri != NULL);
+
+      /* u is the weight of the third point and v of the second one */
+      a = height (&P2TR_TRIANGLE_GET_POINT (tri, 0)->c);
+      b = height (&P2TR_TRIANGLE_GET_POINT (tri, 1)->c);
+      d = height (&P2TR_TRIANGLE_GET_POINT (tri, 2)->c);
+      g_assert (ABS (height (c) - (a + u * (d - a) + v * (b - a)))
+          <= MAX_ERROR + 1e-9);
+
+      p2tr_triangle_unref (tri);
+    }
+
+  g_array_free (original, TRUE);
+  p2tr_cdt_free (rcdt);
+
+  return EXIT_SUCCESS;
+}